@@ -4,6 +4,7 @@
 #include <sstream>
 
 #include "Common/Log.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/StringUtils.h"
 
 #include "Common/GPU/Vulkan/VulkanContext.h"
@@ -489,6 +490,16 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling) {
 					snprintf(line, sizeof(line), "%s: %0.3f ms\n", frameData.profile.timestampDescriptions[i + 1].c_str(), milliseconds);
 					str << line;
 				}
+				if (Trace_IsActive()) {
+					// We don't know when the GPU started relative to the CPU clock, so line the first
+					// timestamp up with the start of CPU recording.  Durations and gaps are exact.
+					double base = frameData.profile.cpuStartTime;
+					for (int i = 0; i < numQueries - 1; i++) {
+						double start = (double)((queryResults[i] - queryResults[0]) & timestampDiffMask) * timestampConversionFactor * 0.001;
+						double end = (double)((queryResults[i + 1] - queryResults[0]) & timestampDiffMask) * timestampConversionFactor * 0.001;
+						Trace_AddGPUSpan(frameData.profile.timestampDescriptions[i + 1], base + start, base + end);
+					}
+				}
 				frameData.profile.profileSummary = str.str();
 			} else {
 				frameData.profile.profileSummary = "(error getting GPU profile - not ready?)";
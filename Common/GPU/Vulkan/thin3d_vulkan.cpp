@@ -28,6 +28,7 @@
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/GPU/Vulkan/VulkanImage.h"
 #include "Common/GPU/Vulkan/VulkanMemory.h"
@@ -900,7 +901,7 @@ VKContext::~VKContext() {
 }
 
 void VKContext::BeginFrame() {
-	renderManager_.BeginFrame(g_Config.bShowGpuProfile);
+	renderManager_.BeginFrame(g_Config.bShowGpuProfile || Trace_IsActive());
 
 	FrameData &frame = frame_[vulkan_->GetCurFrame()];
 	push_ = frame.pushBuffer;
@@ -0,0 +1,160 @@
+// Timeline tracing, saved as Chrome trace JSON.
+
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "ppsspp_config.h"
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/Profiler/Trace.h"
+#include "Common/TimeUtil.h"
+
+#if PPSSPP_PLATFORM(IOS) && defined(__IPHONE_OS_VERSION_MIN_REQUIRED) && __IPHONE_OS_VERSION_MIN_REQUIRED < __IPHONE_9_0
+// iOS did not support C++ thread_local before iOS 9, everything goes on one track.
+#define TRACE_THREAD_LOCAL 0
+#else
+#define TRACE_THREAD_LOCAL 1
+#endif
+
+// Keeps a forgotten trace from eating all memory.  Around 64MB of events.
+static const size_t MAX_TRACE_EVENTS = 1000000;
+// Track (tid) used for GPU timestamps, far away from the CPU thread ids.
+static const int GPU_TRACK_ID = 1000;
+
+struct TraceEvent {
+	const char *name;
+	const char *cat;
+	// GPU spans have names that aren't literals.
+	std::string ownedName;
+	const char *argName;
+	int argValue;
+	int tid;
+	char phase;
+	double start;
+	double end;
+};
+
+std::atomic<bool> g_traceActive;
+
+static std::mutex traceLock;
+static std::vector<TraceEvent> traceEvents;
+static double traceStartTime;
+static size_t traceDroppedEvents;
+static std::atomic<int> traceNextThreadId;
+#if TRACE_THREAD_LOCAL
+static thread_local int traceThreadId = -1;
+#endif
+
+static int GetTraceThreadId() {
+#if TRACE_THREAD_LOCAL
+	if (traceThreadId == -1)
+		traceThreadId = traceNextThreadId++;
+	return traceThreadId;
+#else
+	return 0;
+#endif
+}
+
+static void AddEvent(TraceEvent &&ev) {
+	std::lock_guard<std::mutex> guard(traceLock);
+	// Might've been stopped since the caller checked.
+	if (!Trace_IsActive())
+		return;
+	if (traceEvents.size() >= MAX_TRACE_EVENTS) {
+		traceDroppedEvents++;
+		return;
+	}
+	traceEvents.push_back(std::move(ev));
+}
+
+bool Trace_Start() {
+	std::lock_guard<std::mutex> guard(traceLock);
+	if (Trace_IsActive())
+		return false;
+
+	traceEvents.clear();
+	traceEvents.reserve(65536);
+	traceDroppedEvents = 0;
+	traceStartTime = time_now_d();
+	g_traceActive = true;
+	NOTICE_LOG(SYSTEM, "Started recording trace");
+	return true;
+}
+
+void Trace_AddSpan(const char *name, const char *cat, double start, double end, const char *argName, int argValue) {
+	AddEvent(TraceEvent{ name, cat, std::string(), argName, argValue, GetTraceThreadId(), 'X', start, end });
+}
+
+void Trace_AddGPUSpan(const std::string &name, double start, double end) {
+	AddEvent(TraceEvent{ nullptr, "gpu", name, nullptr, 0, GPU_TRACK_ID, 'X', start, end });
+}
+
+void Trace_AddInstant(const char *name, const char *cat) {
+	double now = time_now_d();
+	AddEvent(TraceEvent{ name, cat, std::string(), nullptr, 0, GetTraceThreadId(), 'i', now, now });
+}
+
+static void WriteEscaped(FILE *fp, const char *s) {
+	if (!s) {
+		fputs("(null)", fp);
+		return;
+	}
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', fp);
+		// Control characters aren't allowed in JSON strings, and we don't expect any.
+		if ((unsigned char)*s >= 0x20)
+			fputc(*s, fp);
+	}
+}
+
+bool Trace_StopAndSave(const std::string &filename) {
+	std::vector<TraceEvent> events;
+	size_t dropped;
+	double startTime;
+	{
+		std::lock_guard<std::mutex> guard(traceLock);
+		if (!Trace_IsActive())
+			return false;
+		g_traceActive = false;
+		events.swap(traceEvents);
+		dropped = traceDroppedEvents;
+		startTime = traceStartTime;
+	}
+
+	FILE *fp = File::OpenCFile(filename, "w");
+	if (!fp) {
+		ERROR_LOG(SYSTEM, "Failed to write trace to %s", filename.c_str());
+		return false;
+	}
+
+	fprintf(fp, "{\"traceEvents\":[\n");
+	fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU timestamps\"}}", GPU_TRACK_ID);
+	for (const TraceEvent &ev : events) {
+		// Chrome trace times are in microseconds.
+		double ts = (ev.start - startTime) * 1000000.0;
+		fprintf(fp, ",\n{\"name\":\"");
+		WriteEscaped(fp, ev.name ? ev.name : ev.ownedName.c_str());
+		fprintf(fp, "\",\"cat\":\"");
+		WriteEscaped(fp, ev.cat);
+		fprintf(fp, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d", ev.phase, ts, ev.tid);
+		if (ev.phase == 'X') {
+			fprintf(fp, ",\"dur\":%.3f", (ev.end - ev.start) * 1000000.0);
+		} else {
+			fprintf(fp, ",\"s\":\"t\"");
+		}
+		if (ev.argName) {
+			fprintf(fp, ",\"args\":{\"");
+			WriteEscaped(fp, ev.argName);
+			fprintf(fp, "\":%d}", ev.argValue);
+		}
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%d}}\n", (int)dropped);
+	fclose(fp);
+
+	NOTICE_LOG(SYSTEM, "Wrote trace with %d events to %s", (int)events.size(), filename.c_str());
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "Common/TimeUtil.h"
+
+// Timeline tracing, saved as Chrome trace JSON (open in chrome://tracing or ui.perfetto.dev.)
+// Unlike the category profiler, this keeps every span with its timestamp, so single flushes,
+// texture uploads and blits can be seen in order.  Always compiled in; while not recording,
+// a TRACE_SCOPE costs a relaxed atomic load.
+
+extern std::atomic<bool> g_traceActive;
+
+inline bool Trace_IsActive() {
+	return g_traceActive.load(std::memory_order_relaxed);
+}
+
+// Returns false if a trace is already being recorded.
+bool Trace_Start();
+// Stops recording and writes out the trace.  Returns false if not recording or the file can't be written.
+bool Trace_StopAndSave(const std::string &filename);
+
+// Times are from time_now_d().  name, cat and argName must outlive the trace (use literals.)
+void Trace_AddSpan(const char *name, const char *cat, double start, double end, const char *argName = nullptr, int argValue = 0);
+// Spans timed on the GPU (timestamp queries), shown on a separate track.
+void Trace_AddGPUSpan(const std::string &name, double start, double end);
+// A marker on the calling thread's track, like a frame boundary.
+void Trace_AddInstant(const char *name, const char *cat);
+
+class TraceScope {
+public:
+	TraceScope(const char *name, const char *cat) : name_(name), cat_(cat) {
+		if (Trace_IsActive())
+			start_ = time_now_d();
+	}
+	~TraceScope() {
+		if (start_ != 0.0)
+			Trace_AddSpan(name_, cat_, start_, time_now_d(), argName_, argValue_);
+	}
+
+	// Shows up in the span's args, for example a draw count.
+	void SetArg(const char *argName, int value) {
+		argName_ = argName;
+		argValue_ = value;
+	}
+
+private:
+	const char *name_;
+	const char *cat_;
+	const char *argName_ = nullptr;
+	int argValue_ = 0;
+	double start_ = 0.0;
+};
+
+#define TRACE_SCOPE(name, cat) TraceScope _trace_scoped(name, cat);
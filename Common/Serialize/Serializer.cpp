@@ -15,14 +15,226 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <thread>
 #include <snappy-c.h>
+#include <zlib.h>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadPool.h"
+#include "Common/TimeUtil.h"
+
+// Chunked compression: a header, a table of compressed chunk sizes, then the chunks.
+// Every chunk is compressed separately, so they can be (de)compressed in parallel.
+struct SChunkedHeader {
+	u32 Method;
+	u32 ChunkSize;
+	u32 NumChunks;
+	u32 UncompressedSize;
+};
+
+static const u32 CHUNK_SIZE = 1024 * 1024;
+// Deflate gets most of its gains at the lowest level, and slot saves block the emu thread.
+static const int DENSE_LEVEL = Z_BEST_SPEED;
+// Chunks compressed per pool loop before they're handed to output, bounds the memory held at once.
+static const int CHUNK_BATCH = 16;
+static const int MAX_CHUNK_THREADS = 8;
+
+// A pool of its own, since rewind compresses on its own thread and a shared pool only runs one
+// loop at a time.  This way texture scaling and the like on the emu thread never wait on it.
+static ThreadPool &ChunkPool() {
+	static ThreadPool pool(std::max(1, std::min((int)std::thread::hardware_concurrency(), MAX_CHUNK_THREADS)));
+	return pool;
+}
+
+static bool CompressChunk(CChunkFileReader::Compression compression, const u8 *data, size_t sz, std::vector<u8> *out) {
+	if (compression == CChunkFileReader::Compression::FAST) {
+		size_t len = snappy_max_compressed_length(sz);
+		out->resize(len);
+		if (snappy_compress((const char *)data, sz, (char *)&(*out)[0], &len) != SNAPPY_OK)
+			return false;
+		out->resize(len);
+	} else {
+		uLongf len = compressBound((uLong)sz);
+		out->resize(len);
+		if (compress2(&(*out)[0], &len, data, (uLong)sz, DENSE_LEVEL) != Z_OK)
+			return false;
+		out->resize(len);
+	}
+	return true;
+}
+
+// The state as it will be on disk: the buffer, with the regions PointerWrap skipped spliced back in.
+class ChunkSource {
+public:
+	ChunkSource(const u8 *buffer, size_t sz, const std::vector<PointerWrapRegion> &regions) {
+		const u8 *pos = buffer;
+		for (const PointerWrapRegion &region : regions) {
+			Add(pos, region.at - pos);
+			Add(region.data, region.size);
+			pos = region.at;
+		}
+		Add(pos, buffer + sz - pos);
+	}
+
+	size_t Size() const {
+		return size_;
+	}
+
+	// Points right into the data when the range is in one piece, otherwise gathers it into temp.
+	const u8 *Get(size_t offset, size_t sz, std::vector<u8> &temp) const {
+		size_t i = std::upper_bound(starts_.begin(), starts_.end(), offset) - starts_.begin() - 1;
+		if (offset + sz <= starts_[i] + sizes_[i])
+			return pieces_[i] + (offset - starts_[i]);
+
+		temp.resize(sz);
+		for (size_t done = 0; done < sz; ++i) {
+			size_t pieceOffset = offset + done - starts_[i];
+			size_t n = std::min(sz - done, sizes_[i] - pieceOffset);
+			memcpy(&temp[done], pieces_[i] + pieceOffset, n);
+			done += n;
+		}
+		return &temp[0];
+	}
+
+private:
+	void Add(const u8 *data, size_t sz) {
+		// Empty pieces would confuse the lookup in Get.
+		if (sz == 0)
+			return;
+		pieces_.push_back(data);
+		starts_.push_back(size_);
+		sizes_.push_back(sz);
+		size_ += sz;
+	}
+
+	std::vector<const u8 *> pieces_;
+	std::vector<size_t> starts_;
+	std::vector<size_t> sizes_;
+	size_t size_ = 0;
+};
+
+static bool DecompressChunk(u32 method, const u8 *data, size_t sz, u8 *out, size_t outSize) {
+	if (method == (u32)CChunkFileReader::Compression::FAST) {
+		size_t len = outSize;
+		return snappy_uncompress((const char *)data, sz, (char *)out, &len) == SNAPPY_OK && len == outSize;
+	} else if (method == (u32)CChunkFileReader::Compression::DENSE) {
+		uLongf len = (uLongf)outSize;
+		return uncompress(out, &len, data, (uLong)sz) == Z_OK && len == outSize;
+	}
+	return false;
+}
+
+// Compresses a batch of chunks on the thread pool, then hands them to output in order.
+// That way the caller can write out the first chunks while later batches are compressed.
+static bool CompressChunksOrdered(const ChunkSource &source, CChunkFileReader::Compression compression, const std::function<bool(const std::vector<u8> &)> &output) {
+	const size_t sz = source.Size();
+	const int numChunks = (int)((sz + CHUNK_SIZE - 1) / CHUNK_SIZE);
+	std::vector<std::vector<u8>> chunks(std::min(numChunks, CHUNK_BATCH));
+
+	for (int base = 0; base < numChunks; base += CHUNK_BATCH) {
+		const int count = std::min(numChunks - base, CHUNK_BATCH);
+		std::atomic<bool> success(true);
+		ChunkPool().ParallelLoop([&](int l, int h) {
+			std::vector<u8> temp;
+			for (int i = l; i < h; ++i) {
+				size_t offset = (size_t)(base + i) * CHUNK_SIZE;
+				size_t chunkSize = std::min((size_t)CHUNK_SIZE, sz - offset);
+				if (!CompressChunk(compression, source.Get(offset, chunkSize, temp), chunkSize, &chunks[i]))
+					success = false;
+			}
+		}, 0, count);
+
+		if (!success)
+			return false;
+		for (int i = 0; i < count; ++i) {
+			if (!output(chunks[i]))
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool DecompressChunksTo(const u8 *data, size_t sz, u8 *dest, size_t destSize) {
+	SChunkedHeader header;
+	if (sz < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.UncompressedSize != destSize || header.ChunkSize == 0)
+		return false;
+	if (header.NumChunks != (header.UncompressedSize + header.ChunkSize - 1) / header.ChunkSize)
+		return false;
+
+	const int numChunks = (int)header.NumChunks;
+	size_t pos = sizeof(header) + numChunks * sizeof(u32);
+	if (pos > sz)
+		return false;
+	std::vector<size_t> offsets(numChunks + 1);
+	for (int i = 0; i < numChunks; ++i) {
+		u32 chunkSize;
+		memcpy(&chunkSize, data + sizeof(header) + i * sizeof(u32), sizeof(u32));
+		offsets[i] = pos;
+		pos += chunkSize;
+	}
+	offsets[numChunks] = pos;
+	if (pos > sz)
+		return false;
+
+	std::atomic<bool> success(true);
+	ChunkPool().ParallelLoop([&](int l, int h) {
+		for (int i = l; i < h; ++i) {
+			size_t outOffset = (size_t)i * header.ChunkSize;
+			size_t outSize = std::min((size_t)header.ChunkSize, destSize - outOffset);
+			if (!DecompressChunk(header.Method, data + offsets[i], offsets[i + 1] - offsets[i], dest + outOffset, outSize))
+				success = false;
+		}
+	}, 0, numChunks);
+	return success;
+}
+
+void CChunkFileReader::CompressChunks(const u8 *data, size_t sz, Compression compression, std::vector<u8> *result) {
+	SChunkedHeader header{ (u32)compression, CHUNK_SIZE, (u32)((sz + CHUNK_SIZE - 1) / CHUNK_SIZE), (u32)sz };
+	result->resize(sizeof(header) + header.NumChunks * sizeof(u32));
+	memcpy(&(*result)[0], &header, sizeof(header));
+
+	u32 index = 0;
+	bool success = CompressChunksOrdered(ChunkSource(data, sz, std::vector<PointerWrapRegion>()), compression, [&](const std::vector<u8> &chunk) {
+		u32 chunkSize = (u32)chunk.size();
+		memcpy(&(*result)[sizeof(header) + index++ * sizeof(u32)], &chunkSize, sizeof(u32));
+		result->insert(result->end(), chunk.begin(), chunk.end());
+		return true;
+	});
+	if (!success)
+		result->clear();
+}
+
+bool CChunkFileReader::DecompressChunks(const u8 *data, size_t sz, std::vector<u8> *result) {
+	SChunkedHeader header;
+	if (sz < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	result->resize(header.UncompressedSize);
+	if (header.UncompressedSize == 0)
+		return true;
+	return DecompressChunksTo(data, sz, &(*result)[0], result->size());
+}
+
+void PointerWrap::DoRegion(void *data, int size) {
+	if (!regions) {
+		DoVoid(data, size);
+	} else if (mode == MODE_WRITE) {
+		regions->push_back({ *ptr, (const u8 *)data, (size_t)size });
+	} else if (mode != MODE_MEASURE) {
+		DoVoid(data, size);
+	}
+}
 
 PointerWrapSection PointerWrap::Section(const char *title, int ver) {
 	return Section(title, ver, ver);
@@ -268,7 +480,20 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const std::string &filename,
 		return ERROR_BAD_FILE;
 	}
 
-	if (header.Compress) {
+	if (header.Compress == COMPRESS_CHUNKED) {
+		double start = time_now_d();
+		u8 *uncomp_buffer = new u8[header.UncompressedSize];
+		if (!DecompressChunksTo(buffer, sz, uncomp_buffer, header.UncompressedSize)) {
+			ERROR_LOG(SAVESTATE, "ChunkReader: Failed to decompress file");
+			delete [] uncomp_buffer;
+			delete [] buffer;
+			return ERROR_BAD_FILE;
+		}
+		INFO_LOG(SAVESTATE, "Savestate: Decompressed %d bytes into %d in %0.1f ms", (int)sz, (int)header.UncompressedSize, (time_now_d() - start) * 1000.0);
+		_buffer = uncomp_buffer;
+		sz = header.UncompressedSize;
+		delete [] buffer;
+	} else if (header.Compress) {
 		u8 *uncomp_buffer = new u8[header.UncompressedSize];
 		size_t uncomp_size = header.UncompressedSize;
 		auto status = snappy_uncompress((const char *)buffer, sz, (char *)uncomp_buffer, &uncomp_size);
@@ -301,9 +526,12 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const std::string &filename,
 }
 
 // Takes ownership of buffer.
-CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz) {
+CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t bufferSize, const std::vector<PointerWrapRegion> &regions, Compression compression) {
 	INFO_LOG(SAVESTATE, "ChunkReader: Writing %s", filename.c_str());
 
+	const ChunkSource source(buffer, bufferSize, regions);
+	const size_t sz = source.Size();
+
 	File::IOFile pFile(filename, "wb");
 	if (!pFile) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Error opening file for write");
@@ -311,26 +539,10 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename,
 		return ERROR_BAD_FILE;
 	}
 
-	// Make sure we can allocate a buffer to compress before compressing.
-	size_t write_len = snappy_max_compressed_length(sz);
-	u8 *compressed_buffer = (u8 *)malloc(write_len);
-	u8 *write_buffer = buffer;
-	if (!compressed_buffer) {
-		ERROR_LOG(SAVESTATE, "ChunkReader: Unable to allocate compressed buffer");
-		// We'll save uncompressed.  Better than not saving...
-		write_len = sz;
-	} else {
-		snappy_compress((const char *)buffer, sz, (char *)compressed_buffer, &write_len);
-		free(buffer);
-
-		write_buffer = compressed_buffer;
-	}
-
-	// Create header
+	// Create header, the sizes are filled in once everything's written.
 	SChunkHeader header{};
-	header.Compress = compressed_buffer ? 1 : 0;
+	header.Compress = COMPRESS_CHUNKED;
 	header.Revision = REVISION_CURRENT;
-	header.ExpectedSize = (u32)write_len;
 	header.UncompressedSize = (u32)sz;
 	truncate_cpy(header.GitVersion, gitVersion);
 
@@ -338,26 +550,47 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename,
 	char titleFixed[128]{};
 	truncate_cpy(titleFixed, title.c_str());
 
+	SChunkedHeader chunked{ (u32)compression, CHUNK_SIZE, (u32)((sz + CHUNK_SIZE - 1) / CHUNK_SIZE), (u32)sz };
+	std::vector<u32> chunkSizes(chunked.NumChunks);
+
 	// Now let's start writing out the file...
 	if (!pFile.WriteArray(&header, 1)) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing header");
-		free(write_buffer);
+		free(buffer);
 		return ERROR_BAD_FILE;
 	}
 	if (!pFile.WriteArray(titleFixed, sizeof(titleFixed))) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing title");
-		free(write_buffer);
+		free(buffer);
+		return ERROR_BAD_FILE;
+	}
+	const uint64_t tablePos = pFile.Tell();
+	if (!pFile.WriteArray(&chunked, 1) || (!chunkSizes.empty() && !pFile.WriteArray(&chunkSizes[0], chunkSizes.size()))) {
+		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing chunk table");
+		free(buffer);
 		return ERROR_BAD_FILE;
 	}
 
-	if (!pFile.WriteBytes(write_buffer, write_len)) {
+	double start = time_now_d();
+	u32 index = 0;
+	size_t write_len = sizeof(chunked) + chunkSizes.size() * sizeof(u32);
+	bool success = CompressChunksOrdered(source, compression, [&](const std::vector<u8> &chunk) {
+		chunkSizes[index++] = (u32)chunk.size();
+		write_len += chunk.size();
+		return pFile.WriteBytes(&chunk[0], chunk.size());
+	});
+	free(buffer);
+	if (!success) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing compressed data");
-		free(write_buffer);
 		return ERROR_BAD_FILE;
-	} else if (sz != write_len) {
-		INFO_LOG(SAVESTATE, "Savestate: Compressed %i bytes into %i", (int)sz, (int)write_len);
 	}
-	free(write_buffer);
+
+	header.ExpectedSize = (u32)write_len;
+	if (!pFile.Seek(0, SEEK_SET) || !pFile.WriteArray(&header, 1) || !pFile.Seek(tablePos, SEEK_SET) || !pFile.WriteArray(&chunked, 1) || (!chunkSizes.empty() && !pFile.WriteArray(&chunkSizes[0], chunkSizes.size()))) {
+		ERROR_LOG(SAVESTATE, "ChunkReader: Failed updating header");
+		return ERROR_BAD_FILE;
+	}
+	INFO_LOG(SAVESTATE, "Savestate: Compressed %i bytes into %i in %0.1f ms", (int)sz, (int)write_len, (time_now_d() - start) * 1000.0);
 
 	INFO_LOG(SAVESTATE, "ChunkReader: Done writing %s", filename.c_str());
 	return ERROR_NONE;
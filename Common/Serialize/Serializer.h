@@ -72,6 +72,14 @@ class PointerWrapSection
 	const char *title_;
 };
 
+// A large plain block of data that a save references instead of copying, see PointerWrap::DoRegion.
+struct PointerWrapRegion {
+	// Where in the buffer the data belongs.
+	const u8 *at;
+	const u8 *data;
+	size_t size;
+};
+
 // Wrapper class
 class PointerWrap
 {
@@ -92,6 +100,10 @@ class PointerWrap
 	u8 **ptr;
 	Mode mode;
 	Error error = ERROR_NONE;
+	// When set, DoRegion only records regions here while measuring and writing, and the buffer
+	// holds everything else.  The data must then stay untouched until the state is written out,
+	// so the caller has to keep every writer out until Save() returns, see SaveState.
+	std::vector<PointerWrapRegion> *regions = nullptr;
 
 	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), mode(mode_) {}
 	PointerWrap(unsigned char **ptr_, int mode_) : ptr((u8**)ptr_), mode((Mode)mode_) {}
@@ -115,6 +127,8 @@ class PointerWrap
 	// Same as DoVoid, except doesn't advance pointer if it doesn't match on read.
 	bool ExpectVoid(void *data, int size);
 	void DoVoid(void *data, int size);
+	// Same as DoVoid, but for large blocks like PSP RAM, which can be saved in place (see regions.)
+	void DoRegion(void *data, int size);
 
 	void DoMarker(const char *prevName, u32 arbitraryNumber = 0x42);
 
@@ -132,6 +146,14 @@ class CChunkFileReader
 		ERROR_BAD_ALLOC,
 	};
 
+	// States are compressed in independent chunks, in parallel.
+	enum class Compression {
+		// snappy, for frequent snapshots kept in memory.
+		FAST = 0,
+		// deflate, for states written to disk.
+		DENSE = 1,
+	};
+
 	// May fail badly if ptr doesn't point to valid data.
 	template<class T>
 	static Error LoadPtr(u8 *ptr, T &_class, std::string *errorString)
@@ -192,20 +214,36 @@ class CChunkFileReader
 
 	// Save file template
 	template<class T>
-	static Error Save(const std::string &filename, const std::string &title, const char *gitVersion, T& _class)
+	static Error Save(const std::string &filename, const std::string &title, const char *gitVersion, T& _class, Compression compression = Compression::DENSE)
 	{
-		// Get data
-		size_t const sz = MeasurePtr(_class);
+		// Regions are compressed straight from where they are, the buffer only gets the rest.
+		// Everything below runs before returning, nothing keeps a reference afterward.
+		std::vector<PointerWrapRegion> regions;
+		u8 *ptr = nullptr;
+		PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+		p.regions = &regions;
+		_class.DoState(p);
+		size_t const sz = (size_t)ptr;
 		u8 *buffer = (u8 *)malloc(sz);
 		if (!buffer)
 			return ERROR_BAD_ALLOC;
-		Error error = SavePtr(buffer, _class);
+
+		// Get data
+		ptr = buffer;
+		p.SetMode(PointerWrap::MODE_WRITE);
+		_class.DoState(p);
+		if (p.error == p.ERROR_FAILURE) {
+			free(buffer);
+			return ERROR_BROKEN_STATE;
+		}
 
 		// SaveFile takes ownership of buffer
-		if (error == ERROR_NONE)
-			error = SaveFile(filename, title, gitVersion, buffer, sz);
-		return error;
+		return SaveFile(filename, title, gitVersion, buffer, sz, regions, compression);
 	}
+
+	// For in-memory states.  The result is only meant for DecompressChunks.
+	static void CompressChunks(const u8 *data, size_t sz, Compression compression, std::vector<u8> *result);
+	static bool DecompressChunks(const u8 *data, size_t sz, std::vector<u8> *result);
 	
 	template <class T>
 	static Error Verify(T& _class)
@@ -249,7 +287,15 @@ class CChunkFileReader
 		REVISION_CURRENT = REVISION_TITLE,
 	};
 
+	// Values of SChunkHeader::Compress.
+	enum {
+		COMPRESS_NONE = 0,
+		COMPRESS_SNAPPY = 1,
+		// See CompressChunks.
+		COMPRESS_CHUNKED = 2,
+	};
+
 	static Error LoadFile(const std::string &filename, std::string *gitVersion, u8 *&buffer, size_t &sz, std::string *failureReason);
-	static Error SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
+	static Error SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz, const std::vector<PointerWrapRegion> &regions, Compression compression);
 	static Error LoadFileHeader(File::IOFile &pFile, SChunkHeader &header, std::string *title);
 };
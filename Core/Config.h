@@ -117,6 +117,8 @@ struct Config {
 	uint32_t uJitDisableFlags;
 
 	bool bSeparateSASThread;
+	bool bSeparateAtracThread;
+	bool bSeparateVideoThread;
 	bool bSeparateIOThread;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
@@ -221,6 +223,8 @@ struct Config {
 	bool bFragmentTestCache;
 	int iSplineBezierQuality; // 0 = low , 1 = Intermediate , 2 = High
 	bool bHardwareTessellation;
+	bool bVulkanAsyncPipelines;
+	bool bShaderDepalTextures;
 
 	std::vector<std::string> vPostShaderNames; // Off for chain end (only Off for no shader)
 	std::map<std::string, float> mPostShaderSetting;
@@ -237,6 +241,7 @@ struct Config {
 	int iGlobalVolume;
 	int iAltSpeedVolume;
 	bool bExtraAudioBuffering;  // For bluetooth
+	int iAudioResampler;
 	std::string sAudioDevice;
 	bool bAutoAudioDevice;
 
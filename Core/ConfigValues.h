@@ -91,6 +91,12 @@ enum AudioBackendType {
 	AUDIO_BACKEND_WASAPI,
 };
 
+// For iAudioResampler.
+enum class AudioResampler {
+	LINEAR = 0,
+	SINC = 1,
+};
+
 // For iIOTimingMethod.
 enum IOTimingMethods {
 	IOTIMING_FAST = 0,
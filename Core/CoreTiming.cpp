@@ -15,10 +15,12 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <vector>
 #include <cstdio>
 #include <mutex>
+#include <unordered_map>
 
 #include "Common/Profiler/Profiler.h"
 
@@ -55,14 +57,46 @@ struct BaseEvent {
 	int type;
 };
 
+// Only used for the threadsafe queue now, see MoveEvents().
 typedef LinkedListItem<BaseEvent> Event;
 
-Event *first;
+// Pending events are kept in slots, ordered by an indexed binary min-heap on time.
+// Ties run in the order they were scheduled, like the sorted list this used to be.
+struct QueuedEvent : BaseEvent {
+	u64 order;
+	int heapIndex;
+	// Chain of events with the same type and userdata, for UnscheduleEvent.
+	int keyPrev;
+	int keyNext;
+};
+
+struct EventKey {
+	int type;
+	u64 userdata;
+
+	bool operator ==(const EventKey &other) const {
+		return type == other.type && userdata == other.userdata;
+	}
+};
+
+struct EventKeyHash {
+	size_t operator ()(const EventKey &key) const {
+		return (size_t)((key.userdata * 0x9E3779B97F4A7C15ULL) ^ (u64)key.type);
+	}
+};
+
+static std::vector<QueuedEvent> eventSlots;
+static std::vector<int> freeEventSlots;
+static std::vector<int> eventHeap;
+// Maps to the first slot of a chain, or -1 if the key has no events right now.
+static std::unordered_map<EventKey, int, EventKeyHash> eventsByKey;
+static std::vector<int> eventTypeCounts;
+static u64 nextEventOrder;
+
 Event *tsFirst;
 Event *tsLast;
 
 // event pools
-Event *eventPool = 0;
 Event *eventTsPool = 0;
 int allocatedTsEvents = 0;
 // Optimization to skip MoveEvents when possible.
@@ -125,16 +159,6 @@ u64 GetGlobalTimeUs() {
 	return lastGlobalTimeUs + usSinceLast;
 }
 
-Event* GetNewEvent()
-{
-	if(!eventPool)
-		return new Event;
-
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
-}
-
 Event* GetNewTsEvent()
 {
 	allocatedTsEvents++;
@@ -147,12 +171,6 @@ Event* GetNewTsEvent()
 	return ev;
 }
 
-void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
-}
-
 void FreeTsEvent(Event* ev)
 {
 	ev->next = eventTsPool;
@@ -183,7 +201,7 @@ void RestoreRegisterEvent(int event_type, const char *name, TimedCallback callba
 
 void UnregisterAllEvents()
 {
-	_dbg_assert_msg_(first == nullptr, "Unregistering events with events pending - this isn't good.");
+	_dbg_assert_msg_(eventHeap.empty(), "Unregistering events with events pending - this isn't good.");
 	event_types.clear();
 }
 
@@ -206,12 +224,11 @@ void Shutdown()
 	ClearPendingEvents();
 	UnregisterAllEvents();
 
-	while(eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	eventSlots.clear();
+	eventSlots.shrink_to_fit();
+	freeEventSlots.clear();
+	eventsByKey.clear();
+	eventTypeCounts.clear();
 
 	std::lock_guard<std::mutex> lk(externalEventLock);
 	while(eventTsPool)
@@ -265,32 +282,128 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 		ScheduleEvent_Threadsafe(0, event_type, userdata);
 }
 
-void ClearPendingEvents()
-{
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
+static inline bool EventBefore(int a, int b) {
+	const QueuedEvent &ea = eventSlots[a];
+	const QueuedEvent &eb = eventSlots[b];
+	return ea.time < eb.time || (ea.time == eb.time && ea.order < eb.order);
+}
+
+static void HeapSiftUp(int pos) {
+	int slot = eventHeap[pos];
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+		if (!EventBefore(slot, eventHeap[parent]))
+			break;
+		eventHeap[pos] = eventHeap[parent];
+		eventSlots[eventHeap[pos]].heapIndex = pos;
+		pos = parent;
 	}
+	eventHeap[pos] = slot;
+	eventSlots[slot].heapIndex = pos;
 }
 
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
+static void HeapSiftDown(int pos) {
+	int slot = eventHeap[pos];
+	const int size = (int)eventHeap.size();
+	while (true) {
+		int child = pos * 2 + 1;
+		if (child >= size)
 			break;
+		if (child + 1 < size && EventBefore(eventHeap[child + 1], eventHeap[child]))
+			child++;
+		if (!EventBefore(eventHeap[child], slot))
+			break;
+		eventHeap[pos] = eventHeap[child];
+		eventSlots[eventHeap[pos]].heapIndex = pos;
+		pos = child;
+	}
+	eventHeap[pos] = slot;
+	eventSlots[slot].heapIndex = pos;
+}
+
+static void AddEventToQueue(const BaseEvent &ev) {
+	// Drop keys without events once they clearly outnumber them, so varying userdata can't pile up.
+	if (eventsByKey.size() > 64 && eventsByKey.size() > eventHeap.size() * 4) {
+		for (auto it = eventsByKey.begin(); it != eventsByKey.end(); ) {
+			if (it->second == -1)
+				it = eventsByKey.erase(it);
+			else
+				++it;
 		}
-		prev = next;
-		pNext = &prev->next;
 	}
+
+	int slot;
+	if (freeEventSlots.empty()) {
+		slot = (int)eventSlots.size();
+		eventSlots.push_back(QueuedEvent());
+	} else {
+		slot = freeEventSlots.back();
+		freeEventSlots.pop_back();
+	}
+
+	QueuedEvent &qe = eventSlots[slot];
+	qe.time = ev.time;
+	qe.userdata = ev.userdata;
+	qe.type = ev.type;
+	qe.order = nextEventOrder++;
+
+	// Keys are kept when their chain empties, since most events get scheduled again.
+	auto it = eventsByKey.emplace(EventKey{ ev.type, ev.userdata }, -1).first;
+	qe.keyPrev = -1;
+	qe.keyNext = it->second;
+	if (it->second != -1)
+		eventSlots[it->second].keyPrev = slot;
+	it->second = slot;
+
+	if (ev.type >= (int)eventTypeCounts.size())
+		eventTypeCounts.resize(ev.type + 1);
+	eventTypeCounts[ev.type]++;
+
+	eventHeap.push_back(slot);
+	HeapSiftUp((int)eventHeap.size() - 1);
+}
+
+static void RemoveEventFromQueue(int slot) {
+	QueuedEvent &qe = eventSlots[slot];
+
+	int pos = qe.heapIndex;
+	int last = eventHeap.back();
+	eventHeap.pop_back();
+	if (last != slot) {
+		eventHeap[pos] = last;
+		eventSlots[last].heapIndex = pos;
+		if (pos > 0 && EventBefore(last, eventHeap[(pos - 1) / 2]))
+			HeapSiftUp(pos);
+		else
+			HeapSiftDown(pos);
+	}
+
+	if (qe.keyPrev != -1) {
+		eventSlots[qe.keyPrev].keyNext = qe.keyNext;
+	} else {
+		eventsByKey[EventKey{ qe.type, qe.userdata }] = qe.keyNext;
+	}
+	if (qe.keyNext != -1)
+		eventSlots[qe.keyNext].keyPrev = qe.keyPrev;
+
+	eventTypeCounts[qe.type]--;
+	freeEventSlots.push_back(slot);
+}
+
+// Returns the pending events in the order they will run.
+static std::vector<int> SortedEventSlots() {
+	std::vector<int> sorted = eventHeap;
+	std::sort(sorted.begin(), sorted.end(), &EventBefore);
+	return sorted;
+}
+
+void ClearPendingEvents()
+{
+	for (int slot : eventHeap)
+		freeEventSlots.push_back(slot);
+	eventHeap.clear();
+	eventsByKey.clear();
+	std::fill(eventTypeCounts.begin(), eventTypeCounts.end(), 0);
 }
 
 // This must be run ONLY from within the cpu thread
@@ -298,55 +411,32 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = GetTicks() + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	BaseEvent ev;
+	ev.userdata = userdata;
+	ev.type = event_type;
+	ev.time = GetTicks() + cyclesIntoFuture;
+	AddEventToQueue(ev);
 }
 
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
 	s64 result = 0;
-	if (!first)
+	auto it = eventsByKey.find(EventKey{ event_type, userdata });
+	if (it == eventsByKey.end())
 		return result;
-	while(first)
-	{
-		if (first->type == event_type && first->userdata == userdata)
-		{
-			result = first->time - GetTicks();
 
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return result;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
-
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+	// If there are several, report the one that would've run last.
+	int latest = -1;
+	for (int slot = it->second; slot != -1; slot = eventSlots[slot].keyNext) {
+		if (latest == -1 || EventBefore(latest, slot))
+			latest = slot;
 	}
+	if (latest != -1)
+		result = eventSlots[latest].time - GetTicks();
 
+	while (it->second != -1)
+		RemoveEventFromQueue(it->second);
 	return result;
 }
 
@@ -407,52 +497,21 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return event_type >= 0 && event_type < (int)eventTypeCounts.size() && eventTypeCounts[event_type] > 0;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
+	if (!IsScheduled(event_type))
 		return;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+
+	std::vector<int> matches;
+	for (int slot : eventHeap) {
+		if (eventSlots[slot].type == event_type)
+			matches.push_back(slot);
 	}
+	for (int slot : matches)
+		RemoveEventFromQueue(slot);
 }
 
 void RemoveThreadsafeEvent(int event_type)
@@ -509,16 +568,15 @@ void RemoveAllEvents(int event_type)
 //This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents()
 {
-	while (first)
+	while (!eventHeap.empty())
 	{
-		if (first->time <= (s64)GetTicks())
+		int slot = eventHeap[0];
+		if (eventSlots[slot].time <= (s64)GetTicks())
 		{
-//			LOG(CPU, "[Scheduler] %s		 (%lld, %lld) ",
-//				first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-			FreeEvent(evt);
+			// Copy it out first, the callback may well schedule more events.
+			BaseEvent evt = eventSlots[slot];
+			RemoveEventFromQueue(slot);
+			event_types[evt.type].callback(evt.userdata, (int)(GetTicks() - evt.time));
 		}
 		else
 		{
@@ -536,20 +594,11 @@ void MoveEvents()
 	while (tsFirst)
 	{
 		Event *next = tsFirst->next;
-		AddEventToQueue(tsFirst);
+		AddEventToQueue(*tsFirst);
+		FreeTsEvent(tsFirst);
 		tsFirst = next;
 	}
 	tsLast = NULL;
-
-	// Move free events to threadsafe pool
-	while(allocatedTsEvents > 0 && eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		ev->next = eventTsPool;
-		eventTsPool = ev;
-		allocatedTsEvents--;
-	}
 }
 
 void ForceCheck()
@@ -577,7 +626,7 @@ void Advance()
 		MoveEvents();
 	ProcessFifoWaitEvents();
 
-	if (!first)
+	if (eventHeap.empty())
 	{
 		// This should never happen in PPSSPP.
 		// WARN_LOG_REPORT(TIME, "WARNING - no events in queue. Setting currentMIPS->downcount to 10000");
@@ -589,7 +638,7 @@ void Advance()
 	else
 	{
 		// Note that events can eat cycles as well.
-		int target = (int)(first->time - globalTimer);
+		int target = (int)(eventSlots[eventHeap[0]].time - globalTimer);
 		if (target > MAX_SLICE_LENGTH)
 			target = MAX_SLICE_LENGTH;
 
@@ -601,11 +650,10 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
+	for (int slot : SortedEventSlots())
 	{
-		//INFO_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+		const QueuedEvent &ev = eventSlots[slot];
+		DEBUG_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", (long long)globalTimer, (long long)ev.time, ev.type);
 	}
 }
 
@@ -615,10 +663,10 @@ void Idle(int maxIdle)
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
 
-	if (first && cyclesDown > 0)
+	if (!eventHeap.empty() && cyclesDown > 0)
 	{
 		int cyclesExecuted = slicelength - currentMIPS->downcount;
-		int cyclesNextEvent = (int) (first->time - globalTimer);
+		int cyclesNextEvent = (int) (eventSlots[eventHeap[0]].time - globalTimer);
 
 		if (cyclesNextEvent < cyclesExecuted + cyclesDown)
 		{
@@ -638,14 +686,13 @@ void Idle(int maxIdle)
 }
 
 std::string GetScheduledEventsSummary() {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr) {
+	for (int slot : SortedEventSlots()) {
+		const QueuedEvent *ptr = &eventSlots[slot];
 		unsigned int t = ptr->type;
 		if (t >= event_types.size()) {
 			_dbg_assert_msg_(false, "Invalid event type %d", t);
-			ptr = ptr->next;
 			continue;
 		}
 		const char *name = event_types[t].name;
@@ -654,7 +701,6 @@ std::string GetScheduledEventsSummary() {
 		char temp[512];
 		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ptr->time, (u32)(ptr->userdata >> 32), (u32)(ptr->userdata));
 		text += temp;
-		ptr = ptr->next;
 	}
 	return text;
 }
@@ -672,6 +718,37 @@ void Event_DoStateOld(PointerWrap &p, BaseEvent *ev)
 	Do(p, *ev);
 }
 
+// Same format as DoLinkedList: each event in run order behind a 1 marker, then a 0.
+static void DoEventQueue(PointerWrap &p, void (*doEvent)(PointerWrap &, BaseEvent *))
+{
+	if (p.mode == PointerWrap::MODE_READ) {
+		ClearPendingEvents();
+		while (true) {
+			u8 shouldExist = 0;
+			Do(p, shouldExist);
+			if (shouldExist != 1) {
+				if (shouldExist != 0) {
+					WARN_LOG(SAVESTATE, "Savestate failure: incorrect item marker %d", shouldExist);
+					p.SetError(p.ERROR_FAILURE);
+				}
+				break;
+			}
+			BaseEvent ev;
+			doEvent(p, &ev);
+			AddEventToQueue(ev);
+		}
+	} else {
+		for (int slot : SortedEventSlots()) {
+			u8 shouldExist = 1;
+			Do(p, shouldExist);
+			BaseEvent ev = eventSlots[slot];
+			doEvent(p, &ev);
+		}
+		u8 shouldExist = 0;
+		Do(p, shouldExist);
+	}
+}
+
 void DoState(PointerWrap &p)
 {
 	std::lock_guard<std::mutex> lk(externalEventLock);
@@ -686,10 +763,10 @@ void DoState(PointerWrap &p)
 	event_types.resize(n, EventType{ AntiCrashCallback, "INVALID EVENT" });
 
 	if (s >= 3) {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(p, first, (Event **) NULL);
+		DoEventQueue(p, &Event_DoState);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoState>(p, tsFirst, &tsLast);
 	} else {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoStateOld>(p, first, (Event **) NULL);
+		DoEventQueue(p, &Event_DoStateOld);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoStateOld>(p, tsFirst, &tsLast);
 	}
 
@@ -29,6 +29,8 @@
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/CommonWindows.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/FileLoaders/DiskCachingFileLoader.h"
 #include "Core/System.h"
 
@@ -62,6 +64,7 @@ void DiskCachingFileLoader::Prepare() {
 }
 
 DiskCachingFileLoader::~DiskCachingFileLoader() {
+	ShutdownPrefetch();
 	if (filesize_ > 0) {
 		ShutdownCache();
 	}
@@ -94,10 +97,19 @@ size_t DiskCachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data,
 	}
 
 	if (cache_ && cache_->IsValid() && (flags & Flags::HINT_UNCACHED) == 0) {
+		// Only reads from a running game are worth remembering, not from the game list.
+		if (PSP_IsIniting() || PSP_IsInited()) {
+			cache_->RecordAccess(absolutePos, bytes);
+			StartPrefetch();
+		}
+
 		readSize = cache_->ReadFromCache(absolutePos, bytes, data);
 		// While in case the cache size is too small for the entire read.
 		while (readSize < bytes) {
-			readSize += cache_->SaveIntoCache(backend_, absolutePos + readSize, bytes - readSize, (u8 *)data + readSize, flags);
+			{
+				std::lock_guard<std::mutex> guard(backendLock_);
+				readSize += cache_->SaveIntoCache(backend_, absolutePos + readSize, bytes - readSize, (u8 *)data + readSize, flags);
+			}
 			// If there are already-cached blocks afterward, we have to read them.
 			size_t bytesFromCache = cache_->ReadFromCache(absolutePos + readSize, bytes - readSize, (u8 *)data + readSize);
 			readSize += bytesFromCache;
@@ -107,12 +119,47 @@ size_t DiskCachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data,
 			}
 		}
 	} else {
+		std::lock_guard<std::mutex> guard(backendLock_);
 		readSize = backend_->ReadAt(absolutePos, bytes, data, flags);
 	}
 
 	return readSize;
 }
 
+void DiskCachingFileLoader::Cancel() {
+	prefetchCancel_ = true;
+	ProxiedFileLoader::Cancel();
+}
+
+void DiskCachingFileLoader::StartPrefetch() {
+	if (prefetchStarted_) {
+		return;
+	}
+	prefetchStarted_ = true;
+	if (!cache_->ClaimPrefetch()) {
+		return;
+	}
+
+	prefetchCancel_ = false;
+	prefetchThread_ = std::thread([this] {
+		setCurrentThreadName("DiskCachePrefetch");
+
+		u32 indexPos;
+		while (!prefetchCancel_ && cache_->NextPrefetchBlock(&indexPos)) {
+			if (!cache_->PrefetchBlock(backend_, backendLock_, indexPos)) {
+				break;
+			}
+		}
+	});
+}
+
+void DiskCachingFileLoader::ShutdownPrefetch() {
+	prefetchCancel_ = true;
+	if (prefetchThread_.joinable()) {
+		prefetchThread_.join();
+	}
+}
+
 std::vector<std::string> DiskCachingFileLoader::GetCachedPathsInUse() {
 	std::lock_guard<std::mutex> guard(cachesMutex_);
 
@@ -192,6 +239,8 @@ void DiskCachingFileLoaderCache::InitCache(const std::string &path) {
 
 void DiskCachingFileLoaderCache::ShutdownCache() {
 	if (f_) {
+		WriteTrace();
+
 		bool failed = false;
 		if (fseek(f_, sizeof(FileHeader), SEEK_SET) != 0) {
 			failed = true;
@@ -211,6 +260,10 @@ void DiskCachingFileLoaderCache::ShutdownCache() {
 
 	index_.clear();
 	blockIndexLookup_.clear();
+	trace_.clear();
+	tracePos_.clear();
+	newTrace_.clear();
+	traceSeen_.clear();
 	cacheSize_ = 0;
 }
 
@@ -328,6 +381,107 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 	return readSize;
 }
 
+void DiskCachingFileLoaderCache::RecordAccess(s64 pos, size_t bytes) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	if (!f_ || bytes == 0) {
+		return;
+	}
+
+	double now = time_now_d();
+	if (traceStart_ == 0.0) {
+		traceStart_ = now;
+	}
+	bool recording = now - traceStart_ < TRACE_RECORD_SECONDS;
+
+	s64 cacheStartPos = pos / blockSize_;
+	s64 cacheEndPos = (pos + bytes - 1) / blockSize_;
+	for (s64 i = cacheStartPos; i <= cacheEndPos && (size_t)i < indexCount_; ++i) {
+		if (recording && !traceSeen_[(size_t)i] && newTrace_.size() < MaxTraceEntries()) {
+			traceSeen_[(size_t)i] = true;
+			newTrace_.push_back((u32)i);
+		}
+
+		// If the game got ahead of the prefetch, skip to where it is now.  Reads of
+		// blocks earlier in the trace must not send the prefetch back over done work.
+		u32 tracePos = tracePos_[(size_t)i];
+		if (tracePos != INVALID_INDEX) {
+			prefetchCursor_ = std::max(prefetchCursor_, (size_t)tracePos + 1);
+		}
+	}
+}
+
+bool DiskCachingFileLoaderCache::ClaimPrefetch() {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	if (!f_ || trace_.empty() || prefetchClaimed_) {
+		return false;
+	}
+	prefetchClaimed_ = true;
+	return true;
+}
+
+bool DiskCachingFileLoaderCache::NextPrefetchBlock(u32 *indexPos) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	if (!f_) {
+		return false;
+	}
+
+	while (prefetchCursor_ < trace_.size()) {
+		u32 next = trace_[prefetchCursor_++];
+		if (index_[next].block == INVALID_BLOCK) {
+			*indexPos = next;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool DiskCachingFileLoaderCache::PrefetchBlock(FileLoader *backend, std::mutex &backendLock, u32 indexPos) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!f_) {
+			return false;
+		}
+		if (index_[indexPos].block != INVALID_BLOCK) {
+			return true;
+		}
+	}
+
+	// The backend might be slow (that's the point), so let demand reads proceed meanwhile.
+	// Backends aren't thread safe though, so demand reads still wait for this one.
+	std::vector<u8> buf(blockSize_);
+	size_t readBytes;
+	{
+		std::lock_guard<std::mutex> guard(backendLock);
+		readBytes = backend->ReadAt(indexPos * (u64)blockSize_, blockSize_, &buf[0], FileLoader::Flags::NONE);
+	}
+	if (readBytes == 0) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!f_) {
+		return false;
+	}
+
+	auto &info = index_[indexPos];
+	// A demand read may have cached it while we were busy.
+	if (info.block == INVALID_BLOCK && MakeCacheSpaceFor(1)) {
+		info.block = AllocateBlock(indexPos);
+		WriteBlockData(info, &buf[0]);
+		WriteIndexData(indexPos, info);
+		++cacheSize_;
+	}
+	return true;
+}
+
+u32 DiskCachingFileLoaderCache::MaxTraceEntries() const {
+	// Leave room in the cache for blocks outside the trace, or prefetch would just evict itself.
+	return std::min((u32)TRACE_MAX_ENTRIES, maxBlocks_ / 2);
+}
+
 bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
 	size_t goal = (size_t)maxBlocks_ - blocks;
 
@@ -430,9 +584,13 @@ std::string DiskCachingFileLoaderCache::MakeCacheFilePath(const std::string &pat
 	return dir + "/" + MakeCacheFilename(path);
 }
 
+s64 DiskCachingFileLoaderCache::GetTraceOffset() {
+	return (s64)sizeof(FileHeader) + (s64)indexCount_ * (s64)sizeof(BlockInfo);
+}
+
 s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 block) {
 	// This is where the blocks start.
-	s64 blockOffset = (s64)sizeof(FileHeader) + (s64)indexCount_ * (s64)sizeof(BlockInfo);
+	s64 blockOffset = GetTraceOffset() + (s64)sizeof(u32) * (1 + TRACE_MAX_ENTRIES);
 	// Now to the actual block.
 	return blockOffset + (s64)block * (s64)blockSize_;
 }
@@ -598,6 +756,79 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 
 		blockIndexLookup_[index_[i].block] = (u32)i;
 	}
+
+	LoadTrace();
+}
+
+void DiskCachingFileLoaderCache::LoadTrace() {
+	trace_.clear();
+	tracePos_.assign(indexCount_, INVALID_INDEX);
+	newTrace_.clear();
+	traceSeen_.assign(indexCount_, false);
+	traceStart_ = 0.0;
+	prefetchCursor_ = 0;
+
+	if (!f_) {
+		return;
+	}
+
+	u32_le count;
+	if (fseeko(f_, GetTraceOffset(), SEEK_SET) != 0 || fread(&count, sizeof(count), 1, f_) != 1) {
+		ERROR_LOG(LOADER, "Unable to read disk cache access trace.");
+		return;
+	}
+	if (count == 0 || count > TRACE_MAX_ENTRIES) {
+		return;
+	}
+
+	std::vector<u32_le> entries(count);
+	if (fread(&entries[0], sizeof(u32_le), count, f_) != count) {
+		ERROR_LOG(LOADER, "Unable to read disk cache access trace.");
+		return;
+	}
+
+	trace_.reserve(count);
+	for (u32 indexPos : entries) {
+		// Ignore anything out of range or repeated, it's only a hint.
+		if (indexPos < indexCount_ && tracePos_[indexPos] == INVALID_INDEX) {
+			tracePos_[indexPos] = (u32)trace_.size();
+			trace_.push_back(indexPos);
+		}
+	}
+
+	INFO_LOG(LOADER, "Loaded disk cache access trace with %d blocks for %s", (int)trace_.size(), origPath_.c_str());
+}
+
+void DiskCachingFileLoaderCache::WriteTrace() {
+	if (!f_ || newTrace_.empty()) {
+		// Nothing was read in game, so keep whatever trace we had.
+		return;
+	}
+
+	// Newest order first, then anything from previous boots this one didn't get to.
+	std::vector<u32_le> entries(newTrace_.begin(), newTrace_.end());
+	for (u32 indexPos : trace_) {
+		if (entries.size() >= MaxTraceEntries()) {
+			break;
+		}
+		if (!traceSeen_[indexPos]) {
+			entries.push_back(indexPos);
+		}
+	}
+
+	u32_le count = (u32)entries.size();
+	bool failed = false;
+	if (fseeko(f_, GetTraceOffset(), SEEK_SET) != 0) {
+		failed = true;
+	} else if (fwrite(&count, sizeof(count), 1, f_) != 1) {
+		failed = true;
+	} else if (fwrite(&entries[0], sizeof(u32_le), entries.size(), f_) != entries.size()) {
+		failed = true;
+	}
+
+	if (failed) {
+		ERROR_LOG(LOADER, "Unable to write disk cache access trace.");
+	}
 }
 
 void DiskCachingFileLoaderCache::CreateCacheFile(const std::string &path) {
@@ -649,11 +880,19 @@ void DiskCachingFileLoaderCache::CreateCacheFile(const std::string &path) {
 		CloseFileHandle();
 		return;
 	}
+	// An empty trace - it gets filled in when the game is first played.
+	std::vector<u32_le> emptyTrace(1 + TRACE_MAX_ENTRIES);
+	if (fwrite(&emptyTrace[0], sizeof(u32_le), emptyTrace.size(), f_) != emptyTrace.size()) {
+		CloseFileHandle();
+		return;
+	}
 	if (fflush(f_) != 0) {
 		CloseFileHandle();
 		return;
 	}
 
+	LoadTrace();
+
 	INFO_LOG(LOADER, "Created new disk cache file for %s", origPath_.c_str());
 }
 
@@ -17,9 +17,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <map>
 #include <mutex>
+#include <thread>
 
 #include "Common/Common.h"
 #include "Common/Swap.h"
@@ -41,17 +43,27 @@ class DiskCachingFileLoader : public ProxiedFileLoader {
 	}
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
 
+	void Cancel() override;
+
 	static std::vector<std::string> GetCachedPathsInUse();
 
 private:
 	void Prepare();
 	void InitCache();
 	void ShutdownCache();
+	void StartPrefetch();
+	void ShutdownPrefetch();
 
 	std::once_flag preparedFlag_;
 	s64 filesize_ = 0;
 	DiskCachingFileLoaderCache *cache_ = nullptr;
 
+	std::thread prefetchThread_;
+	std::atomic<bool> prefetchCancel_{};
+	// Held around backend reads, which the prefetch thread also makes.
+	std::mutex backendLock_;
+	bool prefetchStarted_ = false;
+
 	// We don't support concurrent disk cache access (we use memory cached indexes.)
 	// So we have to ensure there's only one of these per.
 	static std::map<std::string, DiskCachingFileLoaderCache *> caches_;
@@ -85,6 +97,16 @@ class DiskCachingFileLoaderCache {
 
 	bool HasData() const;
 
+	// Remembers which blocks the game reads shortly after boot, so they can be prefetched next time.
+	void RecordAccess(s64 pos, size_t bytes);
+	// Only one loader should run the prefetch for a given cache.
+	bool ClaimPrefetch();
+	// Returns false when there's nothing left in the recorded trace to prefetch.
+	bool NextPrefetchBlock(u32 *indexPos);
+	// Unlike SaveIntoCache, doesn't hold the lock while reading from the backend.
+	// Only holds backendLock, which callers of SaveIntoCache must also hold.
+	bool PrefetchBlock(FileLoader *backend, std::mutex &backendLock, u32 indexPos);
+
 private:
 	void InitCache(const std::string &path);
 	void ShutdownCache();
@@ -96,12 +118,16 @@ class DiskCachingFileLoaderCache {
 	bool ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size);
 	void WriteBlockData(BlockInfo &info, u8 *src);
 	void WriteIndexData(u32 indexPos, BlockInfo &info);
+	s64 GetTraceOffset();
 	s64 GetBlockOffset(u32 block);
 
 	std::string MakeCacheFilePath(const std::string &path);
 	std::string MakeCacheFilename(const std::string &path);
 	bool LoadCacheFile(const std::string &path);
 	void LoadCacheIndex();
+	void LoadTrace();
+	void WriteTrace();
+	u32 MaxTraceEntries() const;
 	void CreateCacheFile(const std::string &path);
 	bool LockCacheFile(bool lockStatus);
 	bool RemoveCacheFile(const std::string &path);
@@ -123,17 +149,22 @@ class DiskCachingFileLoaderCache {
 	//   32 (fileoffset - headersize) / blockSize -> -1=not present
 	//   16 generation?
 	//   16 hits?
+	// trace
+	//   32 count
+	//   32 indexPos[TRACE_MAX_ENTRIES] <-- first access order from the last boots
 	// blocks[up to maxBlocks]
 	//   8 * blockSize
 
 	enum {
-		CACHE_VERSION = 3,
+		CACHE_VERSION = 4,
 		DEFAULT_BLOCK_SIZE = 65536,
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_LOWER_BOUND = 256, // 16 MB
 		MAX_BLOCKS_UPPER_BOUND = 8192, // 512 MB
 		INVALID_BLOCK = 0xFFFFFFFF,
 		INVALID_INDEX = 0xFFFFFFFF,
+		TRACE_MAX_ENTRIES = MAX_BLOCKS_UPPER_BOUND / 2,
+		TRACE_RECORD_SECONDS = 300,
 	};
 
 	int refCount_ = 0;
@@ -173,6 +204,17 @@ class DiskCachingFileLoaderCache {
 	std::vector<BlockInfo> index_;
 	std::vector<u32> blockIndexLookup_;
 
+	// Trace loaded from the file, in the order blocks were first needed.
+	std::vector<u32> trace_;
+	// For each index entry, its position in trace_ (or INVALID_INDEX.)
+	std::vector<u32> tracePos_;
+	// Trace being recorded this session, and which blocks it already has.
+	std::vector<u32> newTrace_;
+	std::vector<bool> traceSeen_;
+	double traceStart_ = 0.0;
+	size_t prefetchCursor_ = 0;
+	bool prefetchClaimed_ = false;
+
 	FILE *f_ = nullptr;
 	int fd_ = 0;
 
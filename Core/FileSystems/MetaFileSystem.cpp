@@ -24,6 +24,7 @@
 #include "Common/StringUtils.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 #include "Core/HLE/sceKernelThread.h"
+#include "Core/MemMap.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 
@@ -561,9 +562,11 @@ size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
+	if (sys) {
+		// Most file systems read straight into PSP memory.
+		Memory::DirtyTrackingHostWrite hostWrite(pointer, (size_t)size);
 		return sys->ReadFile(handle, pointer, size);
-	else
+	} else
 		return 0;
 }
 
@@ -581,9 +584,10 @@ size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
+	if (sys) {
+		Memory::DirtyTrackingHostWrite hostWrite(pointer, (size_t)size);
 		return sys->ReadFile(handle, pointer, size, usec);
-	else
+	} else
 		return 0;
 }
 
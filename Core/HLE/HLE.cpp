@@ -689,11 +689,33 @@ void *GetQuickSyscallFunc(MIPSOpcode op) {
 	// TODO: Do this with a flag?
 	if (op == idleOp)
 		return (void *)info->func;
-	if (info->flags != 0)
+	if ((info->flags & ~0xFF) != 0)
 		return (void *)&CallSyscallWithFlags;
 	return (void *)&CallSyscallWithoutFlags;
 }
 
+static void FinishDirectSyscall(const HLEFunction *info) {
+	hleFinishSyscall(*info);
+}
+
+bool GetDirectSyscall(MIPSOpcode op, HLEDirectCall *call) {
+	if (coreCollectDebugStats)
+		return false;
+
+	const HLEFunction *info = GetSyscallFuncPointer(op);
+	// Any other flags need the checks in CallSyscallWithFlags.
+	if (!info || !info->func || op == idleOp || info->flags != HLE_DIRECT_CALL)
+		return false;
+	DEBUG_LOG(HLE, "Compiling direct syscall to %s", info->name);
+
+	call->info = info;
+	call->func = info->func;
+	call->latestSyscall = &latestSyscall;
+	call->afterSyscall = &hleAfterSyscall;
+	call->finish = &FinishDirectSyscall;
+	return true;
+}
+
 static double hleSteppingTime = 0.0;
 void hleSetSteppingTime(double t)
 {
@@ -717,7 +739,7 @@ void CallSyscall(MIPSOpcode op)
 	if (info->func) {
 		if (op == idleOp)
 			info->func();
-		else if (info->flags != 0)
+		else if ((info->flags & ~0xFF) != 0)
 			CallSyscallWithFlags(info);
 		else
 			CallSyscallWithoutFlags(info);
@@ -31,7 +31,10 @@ typedef void (* HLEFunc)();
 
 enum {
 	// The low 8 bits are a value, indicating special jit handling.
-	// Currently there are none.
+	// Simple and hot: the jit calls the handler straight and keeps going.  Only for functions that
+	// don't reschedule or run interrupts, since then the jit has to leave the block anyway.
+	// If one does (hleReSchedule(), hleEnqueueCall(), etc.), it still works, just isn't faster.
+	HLE_DIRECT_CALL = 1,
 
 	// The remaining 24 bits are flags.
 	// Don't allow the call within an interrupt.  Not yet implemented.
@@ -155,6 +158,19 @@ const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op);
 // For jit, takes arg: const HLEFunction *
 void *GetQuickSyscallFunc(MIPSOpcode op);
 
+// For jit, see HLE_DIRECT_CALL.  Set *latestSyscall to info and call func.  If *afterSyscall is
+// then non-zero, call finish(info) and leave the block, since threads may have switched.
+// Otherwise, the temp regs still need 0xDEADBEEF unless g_Config.bSkipDeadbeefFilling.
+struct HLEDirectCall {
+	const HLEFunction *info;
+	HLEFunc func;
+	const HLEFunction **latestSyscall;
+	const int *afterSyscall;
+	void (*finish)(const HLEFunction *info);
+};
+// For jit, returns false if the syscall has to go through GetQuickSyscallFunc() or CallSyscall().
+bool GetDirectSyscall(MIPSOpcode op, HLEDirectCall *call);
+
 void hleDoLogInternal(LogTypes::LOG_TYPE t, LogTypes::LOG_LEVELS level, u64 res, const char *file, int line, const char *reportTag, char retmask, const char *reason, const char *formatted_reason);
 
 template <typename T>
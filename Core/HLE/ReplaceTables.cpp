@@ -21,6 +21,8 @@
 
 #include "Common/Common.h"
 #include "Common/Log.h"
+#include "Common/Math/math_util.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/SymbolMap.h"
@@ -112,6 +114,40 @@ static int Replace_ceilf() {
 	return 30;  // guess number of cycles
 }
 
+// These are exact in IEEE arithmetic, so the host result matches the soft libm bit for bit.
+// TestReplacements in unittest checks them against the host libc, including NaN, inf and denormals.
+static int Replace_fmodf() {
+	float f1 = PARAMF(0);
+	float f2 = PARAMF(1);
+	RETURNF(fmodf(f1, f2));
+	return 80;  // guess number of cycles
+}
+
+static int Replace_copysignf() {
+	float f1 = PARAMF(0);
+	float f2 = PARAMF(1);
+	RETURNF(copysignf(f1, f2));
+	return 6;
+}
+
+static int Replace_isnanf() {
+	float f = PARAMF(0);
+	RETURN(my_isnan(f) ? 1 : 0);
+	return 6;
+}
+
+static int Replace_finitef() {
+	float f = PARAMF(0);
+	RETURN(my_isnanorinf(f) ? 0 : 1);
+	return 6;
+}
+
+static int Replace_roundf() {
+	float f = PARAMF(0);
+	RETURNF(roundf(f));
+	return 30;  // guess number of cycles
+}
+
 // Should probably do JIT versions of this, possibly ones that only delegate
 // large copies to a C function.
 static int Replace_memcpy() {
@@ -400,6 +436,76 @@ static int Replace_strncmp() {
 	return 10 + bytes / 4;  // approximation
 }
 
+// Like memcpy, reads of VRAM must see what the GPU rendered there.
+static void SyncVRAMForRead(u32 ptr, u32 bytes) {
+	if (bytes != 0 && Memory::IsVRAMAddress(ptr) && (skipGPUReplacements & (int)GPUReplacementSkip::MEMCPY) == 0) {
+		gpu->PerformMemoryDownload(ptr, bytes);
+	}
+}
+
+// The host memcmp/memchr are vectorized, so these are much faster than the byte loops games use.
+static int Replace_memcmp() {
+	u32 aPtr = PARAM(0);
+	u32 bPtr = PARAM(1);
+	u32 bytes = PARAM(2);
+	SyncVRAMForRead(aPtr, bytes);
+	SyncVRAMForRead(bPtr, bytes);
+
+	// Assumes the PSP's libc returns the difference of the first mismatched bytes, like newlib.
+	u32 pos = bytes;
+	int result = 0;
+	if (!Memory::IsValidRange(aPtr, bytes) || !Memory::IsValidRange(bPtr, bytes)) {
+		// Compare like the original loop would, bad reads report and read as 0.
+		for (u32 i = 0; i < bytes; ++i) {
+			u8 a = Memory::Read_U8(aPtr + i);
+			u8 b = Memory::Read_U8(bPtr + i);
+			if (a != b) {
+				pos = i;
+				result = (int)a - (int)b;
+				break;
+			}
+		}
+	} else if (bytes != 0) {
+		const u8 *a = Memory::GetPointerUnchecked(aPtr);
+		const u8 *b = Memory::GetPointerUnchecked(bPtr);
+		if (memcmp(a, b, bytes) != 0) {
+			auto diff = std::mismatch(a, a + bytes, b);
+			pos = (u32)(diff.first - a);
+			result = (int)*diff.first - (int)*diff.second;
+		}
+	}
+	RETURN(result);
+
+	CBreakPoints::ExecMemCheck(aPtr, false, pos, currentMIPS->pc);
+	CBreakPoints::ExecMemCheck(bPtr, false, pos, currentMIPS->pc);
+
+	return 10 + pos * 4;  // approximation
+}
+
+static int Replace_memchr() {
+	u32 srcPtr = PARAM(0);
+	u8 value = PARAM(1);
+	u32 bytes = PARAM(2);
+	SyncVRAMForRead(srcPtr, bytes);
+	if (!Memory::IsValidRange(srcPtr, bytes)) {
+		// Scan like the original loop would, bad reads report and read as 0.
+		u32 i = 0;
+		while (i < bytes && Memory::Read_U8(srcPtr + i) != value)
+			++i;
+		RETURN(i < bytes ? srcPtr + i : 0);
+		return 10 + i * 3;
+	}
+
+	const u8 *src = Memory::GetPointerUnchecked(srcPtr);
+	const u8 *found = bytes != 0 ? (const u8 *)memchr(src, value, bytes) : nullptr;
+	u32 scanned = found ? (u32)(found - src) + 1 : bytes;
+	RETURN(found ? srcPtr + (u32)(found - src) : 0);
+
+	CBreakPoints::ExecMemCheck(srcPtr, false, scanned, currentMIPS->pc);
+
+	return 10 + scanned * 3;  // approximation
+}
+
 static int Replace_fabsf() {
 	RETURNF(fabsf(PARAMF(0)));
 	return 4;
@@ -1259,6 +1365,11 @@ static const ReplacementTableEntry entries[] = {
 	{ "atan2f", &Replace_atan2f, 0, REPFLAG_DISABLED },
 	{ "floorf", &Replace_floorf, 0, REPFLAG_DISABLED },
 	{ "ceilf", &Replace_ceilf, 0, REPFLAG_DISABLED },
+	{ "fmodf", &Replace_fmodf, 0, 0 },
+	{ "copysignf", &Replace_copysignf, 0, 0 },
+	{ "isnanf", &Replace_isnanf, 0, 0 },
+	{ "finitef", &Replace_finitef, 0, 0 },
+	{ "roundf", &Replace_roundf, 0, 0 },
 
 	{ "memcpy", &Replace_memcpy, 0, 0 },
 	{ "memcpy_jak", &Replace_memcpy_jak, 0, 0 },
@@ -1272,6 +1383,10 @@ static const ReplacementTableEntry entries[] = {
 	{ "strncpy", &Replace_strncpy, 0, REPFLAG_DISABLED },
 	{ "strcmp", &Replace_strcmp, 0, REPFLAG_DISABLED },
 	{ "strncmp", &Replace_strncmp, 0, REPFLAG_DISABLED },
+	{ "memcmp", &Replace_memcmp, 0, 0 },
+	// bcmp only promises zero / non-zero, so memcmp's result works.
+	{ "bcmp", &Replace_memcmp, 0, 0 },
+	{ "memchr", &Replace_memchr, 0, 0 },
 	{ "fabsf", &Replace_fabsf, JITFUNC(Replace_fabsf), REPFLAG_ALLOWINLINE | REPFLAG_DISABLED },
 	{ "dl_write_matrix", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED }, // &MIPSComp::Jit::Replace_dl_write_matrix, REPFLAG_DISABLED },
 	{ "dl_write_matrix_2", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED },
@@ -1357,6 +1472,41 @@ static const ReplacementTableEntry entries[] = {
 static std::map<u32, u32> replacedInstructions;
 static std::unordered_map<std::string, std::vector<int> > replacementNameLookup;
 
+// Optional hit counting, used by headless to report which replacements run.
+// Each entry gets its own thunk so the jit can keep calling a plain ReplaceFunc.
+// The thunks aren't inlined by the jit, so inline replacements are counted too.
+static bool statsEnabled = false;
+static ReplacementStat stats[ARRAY_SIZE(entries)];
+static ReplacementTableEntry countedEntries[ARRAY_SIZE(entries)];
+
+template <int N>
+static int CountedReplaceFunc() {
+	double start = time_now_d();
+	int cycles = entries[N].replaceFunc();
+	stats[N].seconds += time_now_d() - start;
+	stats[N].hits++;
+	if (cycles > 0)
+		stats[N].cycles += cycles;
+	return cycles;
+}
+
+template <int N>
+struct CountedReplaceFuncs {
+	static void Fill(ReplacementTableEntry *out) {
+		CountedReplaceFuncs<N - 1>::Fill(out);
+		if (out[N - 1].replaceFunc) {
+			out[N - 1].replaceFunc = &CountedReplaceFunc<N - 1>;
+			out[N - 1].jitReplaceFunc = nullptr;
+			out[N - 1].flags &= ~REPFLAG_ALLOWINLINE;
+		}
+	}
+};
+
+template <>
+struct CountedReplaceFuncs<0> {
+	static void Fill(ReplacementTableEntry *out) {}
+};
+
 void Replacement_Init() {
 	for (int i = 0; i < (int)ARRAY_SIZE(entries); i++) {
 		const auto entry = &entries[i];
@@ -1366,6 +1516,15 @@ void Replacement_Init() {
 	}
 
 	skipGPUReplacements = 0;
+
+	for (int i = 0; i < (int)ARRAY_SIZE(entries); i++) {
+		stats[i].name = entries[i].name;
+		stats[i].hits = 0;
+		stats[i].cycles = 0;
+		stats[i].seconds = 0.0;
+		countedEntries[i] = entries[i];
+	}
+	CountedReplaceFuncs<ARRAY_SIZE(entries)>::Fill(countedEntries);
 }
 
 void Replacement_Shutdown() {
@@ -1392,9 +1551,27 @@ std::vector<int> GetReplacementFuncIndexes(u64 hash, int funcSize) {
 }
 
 const ReplacementTableEntry *GetReplacementFunc(int i) {
+	if (statsEnabled)
+		return &countedEntries[i];
 	return &entries[i];
 }
 
+void Replacement_EnableStats(bool enable) {
+	statsEnabled = enable;
+}
+
+std::vector<ReplacementStat> GetReplacementStats() {
+	std::vector<ReplacementStat> result;
+	for (int i = 0; i < (int)ARRAY_SIZE(entries); i++) {
+		if (stats[i].hits != 0)
+			result.push_back(stats[i]);
+	}
+	std::sort(result.begin(), result.end(), [](const ReplacementStat &a, const ReplacementStat &b) {
+		return a.hits > b.hits;
+	});
+	return result;
+}
+
 static bool WriteReplaceInstruction(u32 address, int index) {
 	u32 prevInstr = Memory::Read_Instruction(address, false).encoding;
 	if (MIPS_IS_REPLACEMENT(prevInstr)) {
@@ -34,6 +34,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
@@ -59,9 +60,22 @@ struct ReplacementTableEntry {
 	s32 hookOffset;
 };
 
+struct ReplacementStat {
+	const char *name;
+	u64 hits;
+	// Guest cycles charged by the replacement, an estimate of what the original code took.
+	u64 cycles;
+	// Host time spent in the replacement.
+	double seconds;
+};
+
 void Replacement_Init();
 void Replacement_Shutdown();
 
+// Must be set before code is jitted, since the jit bakes in the function pointers.
+void Replacement_EnableStats(bool enable);
+std::vector<ReplacementStat> GetReplacementStats();
+
 int GetNumReplacementFuncs();
 std::vector<int> GetReplacementFuncIndexes(u64 hash, int funcSize);
 const ReplacementTableEntry *GetReplacementFunc(int index);
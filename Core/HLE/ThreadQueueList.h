@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Core/HLE/sceKernel.h"
+#include "Common/BitSet.h"
 #include "Common/Serialize/Serializer.h"
 
 struct ThreadQueueList {
@@ -25,10 +26,10 @@ struct ThreadQueueList {
 	static const int NUM_QUEUES = 128;
 	// Initial number of threads a single queue can handle.
 	static const int INITIAL_CAPACITY = 32;
+	// Words in the bitmap of non-empty queues.
+	static const int READY_WORDS = NUM_QUEUES / 32;
 
 	struct Queue {
-		// Next ever-been-used queue (worse priority.)
-		Queue *next;
 		// First valid item in data.
 		int first;
 		// One after last valid item in data.
@@ -51,7 +52,7 @@ struct ThreadQueueList {
 
 	ThreadQueueList() {
 		memset(queues, 0, sizeof(queues));
-		first = invalid();
+		memset(ready, 0, sizeof(ready));
 	}
 
 	~ThreadQueueList() {
@@ -75,37 +76,27 @@ struct ThreadQueueList {
 	}
 
 	inline SceUID pop_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int priority = first_ready(NUM_QUEUES);
+		if (priority >= 0)
+			return pop(priority);
 
 		_dbg_assert_msg_(false, "ThreadQueueList should not be empty.");
 		return 0;
 	}
 
 	inline SceUID pop_first_better(u32 priority) {
-		Queue *cur = first;
 		// Don't bother looking past (worse than) this priority.
-		Queue *stop = &queues[priority];
-		while (cur < stop) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int best = first_ready(priority);
+		if (best >= 0)
+			return pop(best);
 
 		return 0;
 	}
 
 	inline SceUID peek_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first];
-			cur = cur->next;
-		}
+		int priority = first_ready(NUM_QUEUES);
+		if (priority >= 0)
+			return queues[priority].data[queues[priority].first];
 
 		return 0;
 	}
@@ -113,6 +104,7 @@ struct ThreadQueueList {
 	inline void push_front(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[--cur->first] = threadID;
+		ready[priority / 32] |= 1U << (priority & 31);
 		// If we ran out of room toward the front, add more room for next time.
 		if (cur->first == 0)
 			rebalance(priority);
@@ -121,13 +113,14 @@ struct ThreadQueueList {
 	inline void push_back(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[cur->end++] = threadID;
+		ready[priority / 32] |= 1U << (priority & 31);
 		if (cur->full())
 			rebalance(priority);
 	}
 
 	inline void remove(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
-		_dbg_assert_msg_(cur->next != nullptr, "ThreadQueueList::Queue should already be linked up.");
+		_dbg_assert_msg_(cur->data != nullptr, "ThreadQueueList::Queue should already be prepared.");
 
 		for (int i = cur->first; i < cur->end; ++i) {
 			if (cur->data[i] == threadID) {
@@ -139,6 +132,7 @@ struct ThreadQueueList {
 
 				// Now we're one shorter.
 				--cur->end;
+				update_ready(priority);
 				return;
 			}
 		}
@@ -148,7 +142,7 @@ struct ThreadQueueList {
 
 	inline void rotate(u32 priority) {
 		Queue *cur = &queues[priority];
-		_dbg_assert_msg_(cur->next != nullptr, "ThreadQueueList::Queue should already be linked up.");
+		_dbg_assert_msg_(cur->data != nullptr, "ThreadQueueList::Queue should already be prepared.");
 
 		if (cur->size() > 1) {
 			// Grab the front and push it on the end.
@@ -164,7 +158,7 @@ struct ThreadQueueList {
 				free(queues[i].data);
 		}
 		memset(queues, 0, sizeof(queues));
-		first = invalid();
+		memset(ready, 0, sizeof(ready));
 	}
 
 	inline bool empty(u32 priority) const {
@@ -174,7 +168,7 @@ struct ThreadQueueList {
 
 	inline void prepare(u32 priority) {
 		Queue *cur = &queues[priority];
-		if (cur->next == nullptr)
+		if (cur->data == nullptr)
 			link(priority, INITIAL_CAPACITY);
 	}
 
@@ -212,15 +206,39 @@ struct ThreadQueueList {
 
 			if (size != 0)
 				DoArray(p, &cur->data[cur->first], size);
+			if (p.mode == p.MODE_READ)
+				update_ready(i);
 		}
 	}
 
 private:
-	Queue *invalid() const {
-		return (Queue *)-1;
+	// Best (lowest) priority with threads ready that's better than limit, or -1.
+	inline int first_ready(u32 limit) const {
+		for (u32 i = 0; i < READY_WORDS && i * 32 < limit; ++i) {
+			if (ready[i] != 0) {
+				u32 priority = i * 32 + LeastSignificantSetBit(ready[i]);
+				return priority < limit ? (int)priority : -1;
+			}
+		}
+		return -1;
+	}
+
+	inline SceUID pop(u32 priority) {
+		Queue *cur = &queues[priority];
+		SceUID threadID = cur->data[cur->first++];
+		if (cur->empty())
+			ready[priority / 32] &= ~(1U << (priority & 31));
+		return threadID;
+	}
+
+	inline void update_ready(u32 priority) {
+		if (queues[priority].empty())
+			ready[priority / 32] &= ~(1U << (priority & 31));
+		else
+			ready[priority / 32] |= 1U << (priority & 31);
 	}
 
-	// Initialize a priority level and link to other queues.
+	// Initialize a priority level.
 	void link(u32 priority, int size) {
 		_dbg_assert_msg_(queues[priority].data == nullptr, "ThreadQueueList::Queue should only be initialized once.");
 
@@ -241,21 +259,6 @@ struct ThreadQueueList {
 		// Start smack in the middle so it can move both directions.
 		cur->first = size / 2;
 		cur->end = size / 2;
-
-		for (int i = (int)priority - 1; i >= 0; --i) {
-			// This queue is before ours, and points past us.
-			// We'll have it point to our new queue, inserting into the chain.
-			if (queues[i].next != nullptr) {
-				cur->next = queues[i].next;
-				queues[i].next = cur;
-				return;
-			}
-		}
-
-		// Never found above - that means there's no better queue yet.
-		// The new one is now first, and whoever was first is after it.
-		cur->next = first;
-		first = cur;
 	}
 
 	// Move or allocate as necessary to maintain free space on both sides.
@@ -282,8 +285,8 @@ struct ThreadQueueList {
 		}
 	}
 
-	// The first queue that's ever been used.
-	Queue *first;
+	// Bit per priority level, set when that queue has threads.  Picks the next thread without a scan.
+	u32 ready[READY_WORDS];
 	// The priority level queues of thread ids.
 	Queue queues[NUM_QUEUES];
 };
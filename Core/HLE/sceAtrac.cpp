@@ -16,9 +16,16 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Serialize/SerializeMap.h"
+#include "Common/Thread/ThreadPool.h"
+#include "Common/MakeUnique.h"
+#include "Common/TimeUtil.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
@@ -33,7 +40,9 @@
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/HLE/sceKernelMemory.h"
+#include "Core/HLE/sceKernelThread.h"
 #include "Core/HLE/sceAtrac.h"
+#include "Core/HLE/sceSas.h"
 
 // Notes about sceAtrac buffer management
 //
@@ -623,10 +632,49 @@ static bool atracInited = true;
 static Atrac *atracIDs[PSP_NUM_ATRAC_IDS];
 static u32 atracIDTypes[PSP_NUM_ATRAC_IDS];
 
+// With bSeparateAtracThread, sceAtracDecodeData only queues the decode, and the result is
+// applied on the emu thread when the calling thread's delay ends, or earlier if anything
+// else touches Atrac first.  Either way it happens at a deterministic point.
+struct AtracAsyncDecode {
+	Atrac *atrac;
+	u32 outAddr;
+	u32 numSamplesAddr;
+	u32 finishFlagAddr;
+	u32 remainAddr;
+	u32 pc;
+	SceUID threadID;
+
+	// Filled in by the worker.
+	u32 ret;
+	u32 numSamples;
+	u32 finish;
+	int remains;
+	bool updateContext;
+	double seconds;
+	u8 outbuf[ATRAC3PLUS_MAX_SAMPLES * 2 * sizeof(s16)];
+};
+
+static std::unique_ptr<WorkerThread> atracWorker;
+static AtracAsyncDecode atracAsyncDecode;
+static bool atracAsyncPending = false;
+// Results for threads still waiting on their decode delay.
+static std::map<SceUID, u32> atracDelayedResults;
+static int atracDecodeEvent = -1;
+
+static void __AtracDecodeFinish(u64 userdata, int cyclesLate);
+
 void __AtracInit() {
 	atracInited = true;
 	memset(atracIDs, 0, sizeof(atracIDs));
 
+	atracDecodeEvent = CoreTiming::RegisterEvent("AtracDecode", __AtracDecodeFinish);
+	atracAsyncPending = false;
+	atracDelayedResults.clear();
+	if (g_Config.bSeparateAtracThread) {
+		atracWorker = make_unique<WorkerThread>();
+		atracWorker->StartUp();
+	}
+
 	// Start with 2 of each in this order.
 	atracIDTypes[0] = PSP_MODE_AT_3_PLUS;
 	atracIDTypes[1] = PSP_MODE_AT_3_PLUS;
@@ -642,10 +690,13 @@ void __AtracInit() {
 }
 
 void __AtracDoState(PointerWrap &p) {
-	auto s = p.Section("sceAtrac", 1);
+	auto s = p.Section("sceAtrac", 1, 2);
 	if (!s)
 		return;
 
+	// SaveState already finished or dropped any queued decode, see __AtracFinishAsyncDecode().
+	_dbg_assert_(!atracAsyncPending);
+
 	Do(p, atracInited);
 	for (int i = 0; i < PSP_NUM_ATRAC_IDS; ++i) {
 		bool valid = atracIDs[i] != NULL;
@@ -658,16 +709,33 @@ void __AtracDoState(PointerWrap &p) {
 		}
 	}
 	DoArray(p, atracIDTypes, PSP_NUM_ATRAC_IDS);
+
+	if (s >= 2) {
+		Do(p, atracDecodeEvent);
+		Do(p, atracDelayedResults);
+	} else {
+		// Decodes will just be synchronous.
+		atracDecodeEvent = -1;
+		atracDelayedResults.clear();
+	}
+	if (atracDecodeEvent != -1) {
+		CoreTiming::RestoreRegisterEvent(atracDecodeEvent, "AtracDecode", __AtracDecodeFinish);
+	}
 }
 
 void __AtracShutdown() {
+	__AtracFinishAsyncDecode();
+	atracWorker.reset();
+	atracDelayedResults.clear();
+
 	for (size_t i = 0; i < ARRAY_SIZE(atracIDs); ++i) {
 		delete atracIDs[i];
 		atracIDs[i] = NULL;
 	}
 }
 
-static Atrac *getAtrac(int atracID) {
+// Doesn't wait for async decodes, only for use by _AtracDecodeData (which SAS calls from its own thread.)
+static Atrac *peekAtrac(int atracID) {
 	if (atracID < 0 || atracID >= PSP_NUM_ATRAC_IDS) {
 		return NULL;
 	}
@@ -684,6 +752,12 @@ static Atrac *getAtrac(int atracID) {
 	return atrac;
 }
 
+static Atrac *getAtrac(int atracID) {
+	// Anything the game can observe must include the result of a queued decode.
+	__AtracFinishAsyncDecode();
+	return peekAtrac(atracID);
+}
+
 static int createAtrac(Atrac *atrac) {
 	for (int i = 0; i < (int)ARRAY_SIZE(atracIDs); ++i) {
 		if (atracIDTypes[i] == atrac->codecType_ && atracIDs[i] == 0) {
@@ -697,6 +771,7 @@ static int createAtrac(Atrac *atrac) {
 }
 
 static int deleteAtrac(int atracID) {
+	__AtracFinishAsyncDecode();
 	if (atracID >= 0 && atracID < PSP_NUM_ATRAC_IDS) {
 		if (atracIDs[atracID] != nullptr) {
 			delete atracIDs[atracID];
@@ -1138,10 +1213,11 @@ static u32 sceAtracAddStreamData(int atracID, u32 bytesToAdd) {
 	return hleLogSuccessI(ME, 0);
 }
 
-u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u32 *finish, int *remains) {
-	Atrac *atrac = getAtrac(atracID);
-
+// Decodes one frame, but leaves refreshing the context to the caller (when *updateContext is set.)
+// This may run on the Atrac worker thread, so it must not write emulated memory except through outbuf.
+static u32 AtracDecodeFrame(Atrac *atrac, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u32 *finish, int *remains, bool *updateContext) {
 	u32 ret = 0;
+	*updateContext = false;
 	if (atrac == NULL) {
 		ret = ATRAC_ERROR_BAD_ATRACID;
 	} else if (!atrac->dataBuf_) {
@@ -1244,7 +1320,9 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 						u32 outBytes = numSamples * atrac->outputChannels_ * sizeof(s16);
 						if (outbuf != nullptr) {
 							memset(outbuf, 0, outBytes);
-							CBreakPoints::ExecMemCheck(outbufPtr, true, outBytes, currentMIPS->pc);
+							if (outbufPtr != 0) {
+								CBreakPoints::ExecMemCheck(outbufPtr, true, outBytes, currentMIPS->pc);
+							}
 						}
 					}
 				}
@@ -1287,23 +1365,25 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 			*finish = finishFlag;
 			*remains = atrac->RemainingFrames();
 		}
-		if (atrac->context_.IsValid()) {
-			// refresh context_
-			_AtracGenerateContext(atrac, atrac->context_);
-		}
+		// refresh context_
+		*updateContext = atrac->context_.IsValid();
 	}
 
 	return ret;
 }
 
-static u32 sceAtracDecodeData(int atracID, u32 outAddr, u32 numSamplesAddr, u32 finishFlagAddr, u32 remainAddr) {
-	// Note that outAddr being null is completely valid here, used to skip data.
+u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u32 *finish, int *remains) {
+	Atrac *atrac = peekAtrac(atracID);
+	bool updateContext = false;
+	u32 ret = AtracDecodeFrame(atrac, outbuf, outbufPtr, SamplesNum, finish, remains, &updateContext);
+	if (updateContext) {
+		_AtracGenerateContext(atrac, atrac->context_);
+	}
+	return ret;
+}
 
-	u32 numSamples = 0;
-	u32 finish = 0;
-	int remains = 0;
-	int ret = _AtracDecodeData(atracID, Memory::GetPointer(outAddr), outAddr, &numSamples, &finish, &remains);
-	if (ret != (int)ATRAC_ERROR_BAD_ATRACID && ret != (int)ATRAC_ERROR_NO_DATA) {
+static void AtracWriteDecodeResults(u32 ret, u32 numSamplesAddr, u32 numSamples, u32 finishFlagAddr, u32 finish, u32 remainAddr, int remains) {
+	if (ret != ATRAC_ERROR_BAD_ATRACID && ret != ATRAC_ERROR_NO_DATA) {
 		if (Memory::IsValidAddress(numSamplesAddr))
 			Memory::Write_U32(numSamples, numSamplesAddr);
 		if (Memory::IsValidAddress(finishFlagAddr))
@@ -1312,6 +1392,133 @@ static u32 sceAtracDecodeData(int atracID, u32 outAddr, u32 numSamplesAddr, u32
 		if (ret == 0 && Memory::IsValidAddress(remainAddr))
 			Memory::Write_U32(remains, remainAddr);
 	}
+}
+
+void __AtracWaitForAsyncDecode() {
+	if (atracAsyncPending) {
+		atracWorker->WaitForCompletion();
+	}
+}
+
+void __AtracFinishAsyncDecode() {
+	if (!atracAsyncPending) {
+		return;
+	}
+	atracWorker->WaitForCompletion();
+	atracAsyncPending = false;
+
+	const AtracAsyncDecode &job = atracAsyncDecode;
+	Atrac *atrac = job.atrac;
+	if (job.numSamples != 0 && Memory::IsValidAddress(job.outAddr)) {
+		u32 outBytes = job.numSamples * atrac->outputChannels_ * sizeof(s16);
+		Memory::Memcpy(job.outAddr, job.outbuf, outBytes);
+		CBreakPoints::ExecMemCheck(job.outAddr, true, outBytes, job.pc);
+	}
+	AtracWriteDecodeResults(job.ret, job.numSamplesAddr, job.numSamples, job.finishFlagAddr, job.finish, job.remainAddr, job.remains);
+	if (job.updateContext) {
+		_AtracGenerateContext(atrac, atrac->context_);
+	}
+
+	kernelStats.msInAudioWorkers += job.seconds;
+	atracDelayedResults[job.threadID] = job.ret;
+}
+
+void __AtracDiscardAsyncDecode() {
+	if (!atracAsyncPending) {
+		return;
+	}
+	atracWorker->WaitForCompletion();
+	atracAsyncPending = false;
+}
+
+static void __AtracDecodeFinish(u64 userdata, int cyclesLate) {
+	__AtracFinishAsyncDecode();
+
+	u32 error;
+	SceUID threadID = (SceUID)userdata;
+	SceUID verify = __KernelGetWaitID(threadID, WAITTYPE_HLEDELAY, error);
+	auto it = atracDelayedResults.find(threadID);
+	if (it == atracDelayedResults.end()) {
+		WARN_LOG(ME, "Atrac decode finished without a result for thread %d?", threadID);
+		return;
+	}
+	u32 result = it->second;
+	atracDelayedResults.erase(it);
+
+	if (error == 0 && verify == 1) {
+		__KernelResumeThreadFromWait(threadID, result);
+		__KernelReSchedule("woke from atrac decode");
+	} else {
+		WARN_LOG(ME, "Someone else woke up Atrac-blocked thread %d?", threadID);
+	}
+}
+
+static bool AtracQueueDecode(Atrac *atrac, u32 outAddr, u32 numSamplesAddr, u32 finishFlagAddr, u32 remainAddr) {
+	if (!atracWorker || atracDecodeEvent == -1 || !__KernelIsDispatchEnabled()) {
+		return false;
+	}
+	// Anything AtracDecodeFrame() rejects without decoding goes the synchronous way, so the error comes back
+	// right away.  Only a codec error in the middle of the stream is found late, at the end of the delay.
+	if (!atrac || !atrac->dataBuf_ || atrac->failedDecode_) {
+		return false;
+	}
+	if (atrac->codecType_ != PSP_MODE_AT_3 && atrac->codecType_ != PSP_MODE_AT_3_PLUS) {
+		return false;
+	}
+#ifdef USE_FFMPEG
+	if (!atrac->codecCtx_) {
+		return false;
+	}
+#endif
+	const int loopNum = atrac->bufferState_ == ATRAC_STATUS_FOR_SCESAS ? 0 : atrac->loopNum_;
+	if (atrac->currentSample_ >= atrac->endSample_ && loopNum == 0) {
+		return false;
+	}
+
+	// getAtrac() already waited for the previous one.
+	AtracAsyncDecode &job = atracAsyncDecode;
+	job.atrac = atrac;
+	job.outAddr = outAddr;
+	job.numSamplesAddr = numSamplesAddr;
+	job.finishFlagAddr = finishFlagAddr;
+	job.remainAddr = remainAddr;
+	job.pc = currentMIPS->pc;
+	job.threadID = __KernelGetCurThread();
+
+	atracAsyncPending = true;
+	atracWorker->Process([] {
+		AtracAsyncDecode &job = atracAsyncDecode;
+		double start = time_now_d();
+		job.numSamples = 0;
+		job.finish = 0;
+		job.remains = 0;
+		u8 *outbuf = Memory::IsValidAddress(job.outAddr) ? job.outbuf : nullptr;
+		job.ret = AtracDecodeFrame(job.atrac, outbuf, 0, &job.numSamples, &job.finish, &job.remains, &job.updateContext);
+		job.seconds = time_now_d() - start;
+	});
+
+	CoreTiming::ScheduleEvent(usToCycles(atracDecodeDelay), atracDecodeEvent, job.threadID);
+	__KernelWaitCurThread(WAITTYPE_HLEDELAY, 1, 0, 0, false, "atrac decode data");
+	return true;
+}
+
+static u32 sceAtracDecodeData(int atracID, u32 outAddr, u32 numSamplesAddr, u32 finishFlagAddr, u32 remainAddr) {
+	// Note that outAddr being null is completely valid here, used to skip data.
+
+	// SAS may be mixing this atrac on its thread.  Letting it finish first keeps the order the same every run.
+	__SasDrain();
+	Atrac *atrac = getAtrac(atracID);
+	if (AtracQueueDecode(atrac, outAddr, numSamplesAddr, finishFlagAddr, remainAddr)) {
+		// The result is set when the delay finishes.
+		DEBUG_LOG(ME, "sceAtracDecodeData(%i, %08x, %08x, %08x, %08x): queued", atracID, outAddr, numSamplesAddr, finishFlagAddr, remainAddr);
+		return 0;
+	}
+
+	u32 numSamples = 0;
+	u32 finish = 0;
+	int remains = 0;
+	int ret = _AtracDecodeData(atracID, Memory::GetPointer(outAddr), outAddr, &numSamples, &finish, &remains);
+	AtracWriteDecodeResults(ret, numSamplesAddr, numSamples, finishFlagAddr, finish, remainAddr, remains);
 	DEBUG_LOG(ME, "%08x=sceAtracDecodeData(%i, %08x, %08x[%08x], %08x[%08x], %08x[%d])", ret, atracID, outAddr, 
 			  numSamplesAddr, numSamples,
 			  finishFlagAddr, finish,
@@ -25,6 +25,11 @@ void Register_sceAtrac3plus();
 void __AtracInit();
 void __AtracDoState(PointerWrap &p);
 void __AtracShutdown();
+// Waits for a decode queued by sceAtracDecodeData, without writing the results yet.
+void __AtracWaitForAsyncDecode();
+// A queued decode writes RAM and kernel state, so save states finish (or on load, drop) it before serializing anything.
+void __AtracFinishAsyncDecode();
+void __AtracDiscardAsyncDecode();
 
 enum AtracStatus : u8 {
 	ATRAC_STATUS_NO_DATA = 1,
@@ -24,6 +24,7 @@
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSInt.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
@@ -392,6 +393,8 @@ int sceKernelDcacheInvalidateRange(u32 addr, int size)
 int sceKernelIcacheInvalidateRange(u32 addr, int size) {
 	DEBUG_LOG(CPU, "sceKernelIcacheInvalidateRange(%08x, %i)", addr, size);
 	currentMIPS->InvalidateICache(addr, size);
+	if (size > 0)
+		MIPSAnalyst::InvalidateHashes(addr, addr + size - 1);
 	return 0;
 }
 
@@ -456,6 +459,7 @@ u32 sceKernelIcacheInvalidateAll()
 #endif
 	// Note that this doesn't actually fully invalidate all with such a large range.
 	currentMIPS->InvalidateICache(0, 0x3FFFFFFF);
+	MIPSAnalyst::InvalidateHashes(0, 0xFFFFFFFF);
 	return 0;
 }
 
@@ -467,6 +471,7 @@ u32 sceKernelIcacheClearAll()
 	DEBUG_LOG(CPU, "Icache cleared - should clear JIT someday");
 	// Note that this doesn't actually fully invalidate all with such a large range.
 	currentMIPS->InvalidateICache(0, 0x3FFFFFFF);
+	MIPSAnalyst::InvalidateHashes(0, 0xFFFFFFFF);
 	return 0;
 }
 
@@ -476,73 +481,146 @@ void KernelObject::GetQuickInfo(char *ptr, int size)
 }
 
 KernelObjectPool::KernelObjectPool() {
-	memset(occupied, 0, sizeof(bool)*maxCount);
-	nextID = initialNextID;
+	memset(pool, 0, sizeof(pool));
+	memset(generation, 0, sizeof(generation));
+	ResetLists();
+	for (int i = initialNextID; i < maxCount; i++)
+		PushFree(i);
 }
 
-SceUID KernelObjectPool::Create(KernelObject *obj, int rangeBottom, int rangeTop) {
-	if (rangeTop > maxCount)
-		rangeTop = maxCount;
-	if (nextID >= rangeBottom && nextID < rangeTop)
-		rangeBottom = nextID++;
+int KernelObjectPool::TypeListOf(int type) {
+	if (type > 0 && type <= SCE_KERNEL_TMID_Tlspl)
+		return type;
+	if (type == SCE_KERNEL_TMID_Tlspl_v0)
+		return SCE_KERNEL_TMID_Tlspl + 1;
+	if (type >= PPSSPP_KERNEL_TMID_Module && type <= PPSSPP_KERNEL_TMID_Heap)
+		return SCE_KERNEL_TMID_Tlspl + 2 + (type - PPSSPP_KERNEL_TMID_Module);
+	// Anything else shares a list, lookups check the type anyway.
+	return 0;
+}
 
-	for (int i = rangeBottom; i < rangeTop; i++) {
-		if (!occupied[i]) {
-			occupied[i] = true;
-			pool[i] = obj;
-			pool[i]->uid = i + handleOffset;
-			return i + handleOffset;
-		}
+void KernelObjectPool::ResetLists() {
+	for (int i = 0; i < typeListCount; i++) {
+		typeHead[i] = -1;
+		typeTail[i] = -1;
 	}
+	freeHead = -1;
+	freeTail = -1;
+	count = 0;
+}
 
-	ERROR_LOG_REPORT(SCEKERNEL, "Unable to allocate kernel object, too many objects slots in use.");
-	return 0;
+void KernelObjectPool::PushFree(int slot) {
+	nextSlot[slot] = -1;
+	prevSlot[slot] = -1;
+	if (freeTail == -1)
+		freeHead = slot;
+	else
+		nextSlot[freeTail] = slot;
+	freeTail = slot;
 }
 
-bool KernelObjectPool::IsValid(SceUID handle) const {
-	int index = handle - handleOffset;
-	if (index < 0 || index >= maxCount)
-		return false;
+void KernelObjectPool::LinkType(int slot) {
+	int list = TypeListOf(pool[slot]->GetIDType());
+	slotTypeList[slot] = (u8)list;
+	nextSlot[slot] = -1;
+	prevSlot[slot] = typeTail[list];
+	if (typeTail[list] == -1)
+		typeHead[list] = slot;
+	else
+		nextSlot[typeTail[list]] = slot;
+	typeTail[list] = slot;
+	count++;
+}
+
+void KernelObjectPool::UnlinkType(int slot) {
+	int list = slotTypeList[slot];
+	if (prevSlot[slot] == -1)
+		typeHead[list] = nextSlot[slot];
+	else
+		nextSlot[prevSlot[slot]] = nextSlot[slot];
+	if (nextSlot[slot] == -1)
+		typeTail[list] = prevSlot[slot];
 	else
-		return occupied[index];
+		prevSlot[nextSlot[slot]] = prevSlot[slot];
+	count--;
+}
+
+SceUID KernelObjectPool::Create(KernelObject *obj) {
+	std::lock_guard<std::recursive_mutex> guard(lock_);
+	if (freeHead == -1) {
+		ERROR_LOG_REPORT(SCEKERNEL, "Unable to allocate kernel object, too many objects slots in use.");
+		return 0;
+	}
+
+	int slot = freeHead;
+	freeHead = nextSlot[slot];
+	if (freeHead == -1)
+		freeTail = -1;
+
+	pool[slot] = obj;
+	obj->uid = HandleOf(slot);
+	LinkType(slot);
+	return obj->uid;
+}
+
+void KernelObjectPool::Release(int slot) {
+	std::lock_guard<std::recursive_mutex> guard(lock_);
+	KernelObject *obj = pool[slot];
+	UnlinkType(slot);
+	pool[slot] = nullptr;
+	generation[slot] = (generation[slot] + 1) & generationMask;
+	PushFree(slot);
+	// Under the lock, so a debugger thread holding Mutex() never sees it half destroyed.
+	delete obj;
+}
+
+bool KernelObjectPool::IsValid(SceUID handle) const {
+	return SlotOf(handle) >= 0;
 }
 
 void KernelObjectPool::Clear() {
+	std::lock_guard<std::recursive_mutex> guard(lock_);
 	for (int i = 0; i < maxCount; i++) {
 		// brutally clear everything, no validation
-		if (occupied[i])
-			delete pool[i];
+		delete pool[i];
 		pool[i] = nullptr;
-		occupied[i] = false;
+		generation[i] = 0;
 	}
-	nextID = initialNextID;
+
+	// Hand out slots in order from initialNextID, like a fresh boot.
+	ResetLists();
+	for (int i = initialNextID; i < maxCount; i++)
+		PushFree(i);
 }
 
-void KernelObjectPool::List() {
-	for (int i = 0; i < maxCount; i++) {
-		if (occupied[i]) {
+std::vector<KernelObjectInfo> KernelObjectPool::Snapshot() const {
+	std::lock_guard<std::recursive_mutex> guard(lock_);
+	std::vector<KernelObjectInfo> objects;
+	objects.reserve(count);
+	for (int list = 0; list < typeListCount; list++) {
+		for (int i = typeHead[list]; i != -1; i = nextSlot[i]) {
 			char buffer[256];
-			if (pool[i]) {
-				pool[i]->GetQuickInfo(buffer, 256);
-				INFO_LOG(SCEKERNEL, "KO %i: %s \"%s\": %s", i + handleOffset, pool[i]->GetTypeName(), pool[i]->GetName(), buffer);
-			} else {
-				strcpy(buffer, "WTF? Zero Pointer");
-			}
+			pool[i]->GetQuickInfo(buffer, sizeof(buffer));
+			KernelObjectInfo info{ pool[i]->GetUID(), pool[i]->GetIDType(), pool[i]->GetTypeName(), pool[i]->GetName(), buffer };
+			objects.push_back(info);
 		}
 	}
+	return objects;
 }
 
-int KernelObjectPool::GetCount() const {
-	int count = 0;
-	for (int i = 0; i < maxCount; i++) {
-		if (occupied[i])
-			count++;
+void KernelObjectPool::List() {
+	for (const KernelObjectInfo &info : Snapshot()) {
+		INFO_LOG(SCEKERNEL, "KO %i: %s \"%s\": %s", info.uid, info.typeName.c_str(), info.name.c_str(), info.quickInfo.c_str());
 	}
+}
+
+int KernelObjectPool::GetCount() const {
+	std::lock_guard<std::recursive_mutex> guard(lock_);
 	return count;
 }
 
 void KernelObjectPool::DoState(PointerWrap &p) {
-	auto s = p.Section("KernelObjectPool", 1);
+	auto s = p.Section("KernelObjectPool", 1, 2);
 	if (!s)
 		return;
 
@@ -560,22 +638,77 @@ void KernelObjectPool::DoState(PointerWrap &p) {
 		kernelObjects.Clear();
 	}
 
-	Do(p, nextID);
-	DoArray(p, occupied, maxCount);
-	for (int i = 0; i < maxCount; ++i) {
-		if (!occupied[i])
-			continue;
+	// Slots in use in list order, and free slots in the order they'll be handed out.
+	std::vector<int> used;
+	std::vector<int> freeSlots;
+	if (s >= 2) {
+		if (p.mode != p.MODE_READ) {
+			std::lock_guard<std::recursive_mutex> guard(lock_);
+			used.reserve(count);
+			for (int list = 0; list < typeListCount; list++) {
+				for (int i = typeHead[list]; i != -1; i = nextSlot[i])
+					used.push_back(i);
+			}
+			for (int i = freeHead; i != -1; i = nextSlot[i])
+				freeSlots.push_back(i);
+		}
+		DoArray(p, generation, maxCount);
+		Do(p, used);
+		Do(p, freeSlots);
+	} else {
+		// Old states had no generations, handles were just the slot plus handleOffset.
+		int nextID = initialNextID;
+		bool occupied[maxCount];
+		Do(p, nextID);
+		DoArray(p, occupied, maxCount);
+		for (int i = 0; i < maxCount; i++) {
+			if (occupied[i])
+				used.push_back(i);
+		}
+		for (int i = std::max(nextID, (int)initialNextID); i < maxCount; i++) {
+			if (!occupied[i])
+				freeSlots.push_back(i);
+		}
+		for (int i = initialNextID; i < std::min(nextID, (int)maxCount); i++) {
+			if (!occupied[i])
+				freeSlots.push_back(i);
+		}
+	}
+
+	if (p.mode == p.MODE_READ) {
+		std::lock_guard<std::recursive_mutex> guard(lock_);
+		ResetLists();
+		for (int i : freeSlots) {
+			if (i < 0 || i >= maxCount) {
+				p.SetError(p.ERROR_FAILURE);
+				ERROR_LOG(SCEKERNEL, "Unable to load state: bad kernel object slot %d.", i);
+				return;
+			}
+			PushFree(i);
+		}
+	}
 
+	for (int i : used) {
 		int type;
 		if (p.mode == p.MODE_READ) {
 			Do(p, type);
-			pool[i] = CreateByIDType(type);
+			if (i < 0 || i >= maxCount) {
+				p.SetError(p.ERROR_FAILURE);
+				ERROR_LOG(SCEKERNEL, "Unable to load state: bad kernel object slot %d.", i);
+				return;
+			}
+			KernelObject *obj = CreateByIDType(type);
 
 			// Already logged an error.
-			if (pool[i] == nullptr)
+			if (obj == nullptr) {
+				p.SetError(p.ERROR_FAILURE);
 				return;
+			}
 
-			pool[i]->uid = i + handleOffset;
+			std::lock_guard<std::recursive_mutex> guard(lock_);
+			pool[i] = obj;
+			obj->uid = HandleOf(i);
+			LinkType(i);
 		} else {
 			type = pool[i]->GetIDType();
 			Do(p, type);
@@ -18,7 +18,9 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "Common/Common.h"
 #include "Common/Log.h"
@@ -428,14 +430,26 @@ class KernelObject
 	}
 };
 
-// TODO: Delete the "occupied" array, rely on non-zero pool entries?
+// For debugger views, copied out while the pool is locked.
+struct KernelObjectInfo {
+	SceUID uid;
+	int type;
+	std::string typeName;
+	std::string name;
+	std::string quickInfo;
+};
+
+// Handles carry a generation in the bits above the slot index, so a stale handle to a reused
+// slot is rejected.  Free slots and each object type are kept in intrusive lists.
+// Only the emu thread mutates the pool.  Lookups don't lock, so other threads either use Snapshot()
+// or hold Mutex() while they touch objects, since objects are only deleted with it held.
 class KernelObjectPool {
 public:
 	KernelObjectPool();
 	~KernelObjectPool() {}
 
-	// Allocates a UID within the range and inserts the object into the map.
-	SceUID Create(KernelObject *obj, int rangeBottom = initialNextID, int rangeTop = 0x7fffffff);
+	// Allocates a UID and inserts the object into the pool.
+	SceUID Create(KernelObject *obj);
 
 	void DoState(PointerWrap &p);
 	static KernelObject *CreateByIDType(int type);
@@ -444,10 +458,7 @@ class KernelObjectPool {
 	u32 Destroy(SceUID handle) {
 		u32 error;
 		if (Get<T>(handle, error)) {
-			occupied[handle-handleOffset] = false;
-			delete pool[handle-handleOffset];
-			// Why weren't we zeroing before?
-			pool[handle-handleOffset] = nullptr;
+			Release(SlotOf(handle));
 		}
 		return error;
 	};
@@ -456,7 +467,8 @@ class KernelObjectPool {
 
 	template <class T>
 	T* Get(SceUID handle, u32 &outError) {
-		if (handle < handleOffset || handle >= handleOffset+maxCount || !occupied[handle-handleOffset]) {
+		int slot = SlotOf(handle);
+		if (slot < 0) {
 			// Tekken 6 spams 0x80020001 gets wrong with no ill effects, also on the real PSP
 			if (handle != 0 && (u32)handle != 0x80020001) {
 				WARN_LOG(SCEKERNEL, "Kernel: Bad %s handle %d (%08x)", T::GetStaticTypeName(), handle, handle);
@@ -467,9 +479,9 @@ class KernelObjectPool {
 			// Previously we had a dynamic_cast here, but since RTTI was disabled traditionally,
 			// it just acted as a static cast and everything worked. This means that we will never
 			// see the Wrong type object error below, but we'll just have to live with that danger.
-			T* t = static_cast<T*>(pool[handle - handleOffset]);
-			if (t == nullptr || t->GetIDType() != T::GetStaticIDType()) {
-				WARN_LOG(SCEKERNEL, "Kernel: Wrong object type for %d (%08x), was %s, should have been %s", handle, handle, t ? t->GetTypeName() : "null", T::GetStaticTypeName());
+			T* t = static_cast<T*>(pool[slot]);
+			if (t->GetIDType() != T::GetStaticIDType()) {
+				WARN_LOG(SCEKERNEL, "Kernel: Wrong object type for %d (%08x), was %s, should have been %s", handle, handle, t->GetTypeName(), T::GetStaticTypeName());
 				outError = T::GetMissingErrorCode();
 				return 0;
 			}
@@ -481,17 +493,15 @@ class KernelObjectPool {
 	// ONLY use this when you KNOW the handle is valid.
 	template <class T>
 	T *GetFast(SceUID handle) {
-		const SceUID realHandle = handle - handleOffset;
-		_dbg_assert_(realHandle >= 0 && realHandle < maxCount && occupied[realHandle]);
-		return static_cast<T *>(pool[realHandle]);
+		const int slot = SlotOf(handle);
+		_dbg_assert_(slot >= 0);
+		return static_cast<T *>(pool[slot]);
 	}
 
 	template <class T, typename ArgT>
 	void Iterate(bool func(T *, ArgT), ArgT arg) {
 		int type = T::GetStaticIDType();
-		for (int i = 0; i < maxCount; i++) {
-			if (!occupied[i])
-				continue;
+		for (int i = typeHead[TypeListOf(type)]; i != -1; i = nextSlot[i]) {
 			T *t = static_cast<T *>(pool[i]);
 			if (t->GetIDType() == type) {
 				if (!func(t, arg))
@@ -500,12 +510,10 @@ class KernelObjectPool {
 		}
 	}
 
+	// Lists in creation order.
 	int ListIDType(int type, SceUID *uids, int count) const {
 		int total = 0;
-		for (int i = 0; i < maxCount; i++) {
-			if (!occupied[i]) {
-				continue;
-			}
+		for (int i = typeHead[TypeListOf(type)]; i != -1; i = nextSlot[i]) {
 			if (pool[i]->GetIDType() == type) {
 				if (total < count) {
 					*uids++ = pool[i]->GetUID();
@@ -517,15 +525,19 @@ class KernelObjectPool {
 	}
 
 	bool GetIDType(SceUID handle, int *type) const {
-		if (handle < handleOffset || handle >= handleOffset+maxCount || !occupied[handle-handleOffset]) {
+		int slot = SlotOf(handle);
+		if (slot < 0) {
 			ERROR_LOG(SCEKERNEL, "Kernel: Bad object handle %i (%08x)", handle, handle);
 			return false;
 		}
-		KernelObject *t = pool[handle - handleOffset];
-		*type = t->GetIDType();
+		*type = pool[slot]->GetIDType();
 		return true;
 	}
 
+	std::vector<KernelObjectInfo> Snapshot() const;
+	std::recursive_mutex &Mutex() const {
+		return lock_;
+	}
 	void List();
 	void Clear();
 	int GetCount() const;
@@ -533,12 +545,47 @@ class KernelObjectPool {
 private:
 	enum {
 		maxCount = 4096,
+		slotBits = 12,
+		generationMask = 0x3FFFF,
 		handleOffset = 0x100,
-		initialNextID = 0x10
+		initialNextID = 0x10,
+		typeListCount = 24,
 	};
+
+	// Returns the slot for a live handle, or -1.
+	int SlotOf(SceUID handle) const {
+		if (handle < handleOffset)
+			return -1;
+		u32 index = (u32)(handle - handleOffset);
+		int slot = index & (maxCount - 1);
+		if (pool[slot] == nullptr || generation[slot] != (index >> slotBits))
+			return -1;
+		return slot;
+	}
+	SceUID HandleOf(int slot) const {
+		return handleOffset + (slot | (generation[slot] << slotBits));
+	}
+	static int TypeListOf(int type);
+
+	void Release(int slot);
+	void LinkType(int slot);
+	void UnlinkType(int slot);
+	void PushFree(int slot);
+	void ResetLists();
+
 	KernelObject *pool[maxCount];
-	bool occupied[maxCount];
-	int nextID;
+	u32 generation[maxCount];
+	// Free slots (oldest first) or slots of one type list, linked by index.
+	int nextSlot[maxCount];
+	int prevSlot[maxCount];
+	u8 slotTypeList[maxCount];
+	int typeHead[typeListCount];
+	int typeTail[typeListCount];
+	int freeHead;
+	int freeTail;
+	int count;
+	// Held while the lists change or an object is deleted.  Recursive since destructors may release other objects.
+	mutable std::recursive_mutex lock_;
 };
 
 extern KernelObjectPool kernelObjects;
@@ -556,6 +603,7 @@ struct KernelStats {
 		summedMsInSyscalls.clear();
 		summedSlowestSyscallTime = 0;
 		summedSlowestSyscallName = 0;
+		msInAudioWorkers = 0;
 	}
 
 	double msInSyscalls;
@@ -564,6 +612,8 @@ struct KernelStats {
 	std::map<KernelStatsSyscall, double> summedMsInSyscalls;
 	double summedSlowestSyscallTime;
 	const char *summedSlowestSyscallName;
+	// SAS mixing and Atrac decoding done on worker threads instead of inside the syscall.
+	double msInAudioWorkers;
 };
 
 extern KernelStats kernelStats;
@@ -3572,6 +3572,8 @@ void __KernelRegisterWaitTypeFuncs(WaitType type, WaitBeginCallbackFunc beginFun
 
 std::vector<DebugThreadInfo> GetThreadsInfo() {
 	std::lock_guard<std::mutex> guard(threadqueueLock);
+	// Called from debugger threads, so keep the threads from being deleted while we read them.
+	std::lock_guard<std::recursive_mutex> objectsGuard(kernelObjects.Mutex());
 	std::vector<DebugThreadInfo> threadList;
 
 	u32 error;
@@ -3606,6 +3608,8 @@ DebugInterface *KernelDebugThread(SceUID threadID) {
 		return currentDebugMIPS;
 	}
 
+	// The lookup is safe from debugger threads, but the thread can only be used while stepping.
+	std::lock_guard<std::recursive_mutex> objectsGuard(kernelObjects.Mutex());
 	u32 error;
 	PSPThread *t = kernelObjects.Get<PSPThread>(threadID, error);
 	if (t) {
@@ -34,6 +34,7 @@
 
 #include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Log.h"
 #include "Core/Config.h"
@@ -45,6 +46,7 @@
 #include "Core/MemMap.h"
 #include "Core/Reporting.h"
 
+#include "Core/HLE/sceAtrac.h"
 #include "Core/HLE/sceSas.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelThread.h"
@@ -99,6 +101,8 @@ static std::condition_variable sasDone;
 static volatile int sasThreadState = SasThreadState::DISABLED;
 static SasThreadParams sasThreadParams;
 static int sasMixEvent = -1;
+// Time spent mixing on the SAS thread, only touched on the emu thread after a drain.
+static double sasThreadSeconds = 0.0;
 
 int __SasThread() {
 	setCurrentThreadName("SAS");
@@ -107,9 +111,11 @@ int __SasThread() {
 	while (sasThreadState != SasThreadState::DISABLED) {
 		sasWake.wait(guard);
 		if (sasThreadState == SasThreadState::QUEUED) {
+			double start = time_now_d();
 			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol);
 
 			sasDoneMutex.lock();
+			sasThreadSeconds += time_now_d() - start;
 			sasThreadState = SasThreadState::READY;
 			sasDone.notify_one();
 			sasDoneMutex.unlock();
@@ -118,13 +124,16 @@ int __SasThread() {
 	return 0;
 }
 
-static void __SasDrain() {
+void __SasDrain() {
 	std::unique_lock<std::mutex> guard(sasDoneMutex);
 	while (sasThreadState == SasThreadState::QUEUED)
 		sasDone.wait(guard);
 }
 
 static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0) {
+	// Voices may decode from an atrac that sceAtracDecodeData queued a frame for.  That frame always goes first.
+	__AtracWaitForAsyncDecode();
+
 	if (sasThreadState == SasThreadState::DISABLED) {
 		// No thread, call it immediately.
 		sas->Mix(outAddr, inAddr, leftVol, rightVol);
@@ -173,6 +182,8 @@ static void sasMixFinish(u64 userdata, int cycleslate) {
 	if (error == 0 && verify == 1) {
 		// Wait until it's actually complete before waking the thread.
 		__SasDrain();
+		kernelStats.msInAudioWorkers += sasThreadSeconds;
+		sasThreadSeconds = 0.0;
 
 		__KernelResumeThreadFromWait(threadID, result);
 		__KernelReSchedule("woke from sas mix");
@@ -20,6 +20,8 @@
 void __SasInit();
 void __SasDoState(PointerWrap &p);
 void __SasShutdown();
+// Waits for a mix queued on the SAS thread.
+void __SasDrain();
 
 void __SasGetDebugStats(char *stats, size_t bufsize);
 
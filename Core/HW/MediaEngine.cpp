@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/Config.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/HW/MediaEngine.h"
@@ -41,6 +42,9 @@ extern "C" {
 }
 #endif // USE_FFMPEG
 
+// How many frames the decode-ahead thread may keep ready.
+static const size_t DECODE_AHEAD_FRAMES = 3;
+
 #ifdef USE_FFMPEG
 static AVPixelFormat getSwsFormat(int pspFormat)
 {
@@ -242,6 +246,10 @@ static int MpegReadbuffer(void *opaque, uint8_t *buf, int buf_size) {
 		size = std::min(buf_size, mpeg->m_mpegheaderSize - mpeg->m_mpegheaderReadPos);
 		memcpy(buf, mpeg->m_mpegheader + mpeg->m_mpegheaderReadPos, size);
 		mpeg->m_mpegheaderReadPos += size;
+#ifdef USE_FFMPEG
+	} else if (mpeg->m_decodeAheadActive) {
+		size = mpeg->decodeAheadRead(buf, buf_size);
+#endif
 	} else {
 		size = mpeg->m_pdata->pop_front(buf, buf_size);
 		if (size > 0)
@@ -351,6 +359,7 @@ bool MediaEngine::openContext(bool keepReadPos) {
 void MediaEngine::closeContext()
 {
 #ifdef USE_FFMPEG
+	stopDecodeAhead(true);
 	if (m_buffer)
 		av_free(m_buffer);
 	if (m_pFrameRGB)
@@ -430,8 +439,15 @@ bool MediaEngine::addVideoStream(int streamNum, int streamId) {
 int MediaEngine::addStreamData(const u8 *buffer, int addSize) {
 	int size = addSize;
 	if (size > 0 && m_pdata) {
+#ifdef USE_FFMPEG
+		std::unique_lock<std::mutex> guard(m_decodeAheadLock);
+#endif
 		if (!m_pdata->push(buffer, size)) 
 			size  = 0;
+#ifdef USE_FFMPEG
+		guard.unlock();
+		m_decodeAheadCond.notify_all();
+#endif
 		if (m_demux) {
 			m_demux->addStreamData(buffer, addSize);
 		}
@@ -487,10 +503,25 @@ bool MediaEngine::seekTo(s64 timestamp, int videoPixelMode) {
 bool MediaEngine::setVideoStream(int streamNum, bool force) {
 	if (m_videoStream == streamNum && !force) {
 		// Yay, nothing to do.
+#ifdef USE_FFMPEG
+		m_decodeAheadPendingStream = -1;
+#endif
 		return true;
 	}
 
 #ifdef USE_FFMPEG
+	if (m_decodeAheadActive) {
+		// The worker is inside the demuxer, so the switch waits until it has stopped between frames.
+		// stepVideo applies it then.  Frames already decoded ahead stay queued, they're from before the switch.
+		if (!m_pFormatCtx || (u32)streamNum >= m_pFormatCtx->nb_streams)
+			return false;
+		if (m_pCodecCtxs.find(streamNum) == m_pCodecCtxs.end() && !avcodec_find_decoder(m_pFormatCtx->streams[streamNum]->codec->codec_id))
+			return false;
+		m_decodeAheadPendingStream = streamNum;
+		requestStopDecodeAhead();
+		return true;
+	}
+
 	if (m_pFormatCtx && m_pCodecCtxs.find(streamNum) == m_pCodecCtxs.end()) {
 		// Get a pointer to the codec context for the video stream
 		if ((u32)streamNum >= m_pFormatCtx->nb_streams) {
@@ -584,6 +615,37 @@ bool MediaEngine::setVideoDim(int width, int height)
 	return true;
 }
 
+#ifdef USE_FFMPEG
+static SwsContext *getSwsContext(SwsContext *ctx, AVCodecContext *codecCtx, int desWidth, int desHeight, AVPixelFormat fmt) {
+	ctx = sws_getCachedContext
+		(
+			ctx,
+			codecCtx->width,
+			codecCtx->height,
+			codecCtx->pix_fmt,
+			desWidth,
+			desHeight,
+			fmt,
+			SWS_BILINEAR,
+			NULL,
+			NULL,
+			NULL
+		);
+
+	int *inv_coefficients;
+	int *coefficients;
+	int srcRange, dstRange;
+	int brightness, contrast, saturation;
+
+	if (sws_getColorspaceDetails(ctx, &inv_coefficients, &srcRange, &coefficients, &dstRange, &brightness, &contrast, &saturation) != -1) {
+		srcRange = 0;
+		dstRange = 0;
+		sws_setColorspaceDetails(ctx, inv_coefficients, srcRange, coefficients, dstRange, brightness, contrast, saturation);
+	}
+	return ctx;
+}
+#endif
+
 void MediaEngine::updateSwsFormat(int videoPixelMode) {
 #ifdef USE_FFMPEG
 	auto codecIter = m_pCodecCtxs.find(m_videoStream);
@@ -592,51 +654,19 @@ void MediaEngine::updateSwsFormat(int videoPixelMode) {
 	AVPixelFormat swsDesired = getSwsFormat(videoPixelMode);
 	if (swsDesired != m_sws_fmt && m_pCodecCtx != 0) {
 		m_sws_fmt = swsDesired;
-		m_sws_ctx = sws_getCachedContext
-			(
-				m_sws_ctx,
-				m_pCodecCtx->width,
-				m_pCodecCtx->height,
-				m_pCodecCtx->pix_fmt,
-				m_desWidth,
-				m_desHeight,
-				(AVPixelFormat)m_sws_fmt,
-				SWS_BILINEAR,
-				NULL,
-				NULL,
-				NULL
-			);
-
-		int *inv_coefficients;
-		int *coefficients;
-		int srcRange, dstRange;
-		int brightness, contrast, saturation;
-
-		if (sws_getColorspaceDetails(m_sws_ctx, &inv_coefficients, &srcRange, &coefficients, &dstRange, &brightness, &contrast, &saturation) != -1) {
-			srcRange = 0;
-			dstRange = 0;
-			sws_setColorspaceDetails(m_sws_ctx, inv_coefficients, srcRange, coefficients, dstRange, brightness, contrast, saturation);
-		}
+		m_sws_ctx = getSwsContext(m_sws_ctx, m_pCodecCtx, m_desWidth, m_desHeight, (AVPixelFormat)m_sws_fmt);
 	}
 #endif
 }
 
-bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #ifdef USE_FFMPEG
-	auto codecIter = m_pCodecCtxs.find(m_videoStream);
-	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
-
-	if (!m_pFormatCtx)
-		return false;
-	if (!m_pCodecCtx)
-		return false;
-	if (!m_pFrame)
-		return false;
-
+// Reads packets until the decoder outputs a frame into m_pFrame, or the data runs out.
+bool MediaEngine::decodeFrame(AVCodecContext *codecCtx, bool *dataEndReached) {
 	AVPacket packet;
 	av_init_packet(&packet);
 	int frameFinished;
 	bool bGetFrame = false;
+	*dataEndReached = false;
 	while (!bGetFrame) {
 		bool dataEnd = av_read_frame(m_pFormatCtx, &packet) < 0;
 		// Even if we've read all frames, some may have been re-ordered frames at the end.
@@ -651,33 +681,12 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 				av_free_packet(&packet);
 #endif
 
-			int result = avcodec_decode_video2(m_pCodecCtx, m_pFrame, &frameFinished, &packet);
+			int result = avcodec_decode_video2(codecCtx, m_pFrame, &frameFinished, &packet);
 			if (frameFinished) {
-				if (!m_pFrameRGB) {
-					setVideoDim();
-				}
-				if (m_pFrameRGB && !skipFrame) {
-					updateSwsFormat(videoPixelMode);
-					// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
-					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
-					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
-
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
-				}
-
-				if (av_frame_get_best_effort_timestamp(m_pFrame) != AV_NOPTS_VALUE)
-					m_videopts = av_frame_get_best_effort_timestamp(m_pFrame) + av_frame_get_pkt_duration(m_pFrame) - m_firstTimeStamp;
-				else
-					m_videopts += av_frame_get_pkt_duration(m_pFrame);
 				bGetFrame = true;
 			}
 			if (result <= 0 && dataEnd) {
-				// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
-				// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
-				m_isVideoEnd = !bGetFrame && (m_pdata->getQueueSize() == 0);
-				if (m_isVideoEnd)
-					m_decodingsize = 0;
+				*dataEndReached = true;
 				break;
 			}
 		}
@@ -688,6 +697,84 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #endif
 	}
 	return bGetFrame;
+}
+
+void MediaEngine::updateVideoTimeStamp(s64 pts, s64 duration) {
+	if (pts != AV_NOPTS_VALUE)
+		m_videopts = pts + duration - m_firstTimeStamp;
+	else
+		m_videopts += duration;
+}
+#endif
+
+bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
+#ifdef USE_FFMPEG
+	auto codecIter = m_pCodecCtxs.find(m_videoStream);
+	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+
+	if (!m_pFormatCtx)
+		return false;
+	if (!m_pCodecCtx)
+		return false;
+	if (!m_pFrame)
+		return false;
+
+	if (m_decodeAheadActive && (!g_Config.bSeparateVideoThread || m_decodeAheadPendingStream != -1))
+		requestStopDecodeAhead();
+	bool gotFrame;
+	if ((m_decodeAheadActive || !m_decodedFrames.empty()) && stepVideoDecodeAhead(videoPixelMode, skipFrame, &gotFrame))
+		return gotFrame;
+
+	// The worker is stopped (or never ran) and every frame it decoded has been taken.
+	if (m_decodeAheadActive) {
+		stopDecodeAhead(false);
+		if (m_decodeAheadPendingStream != -1) {
+			int streamNum = m_decodeAheadPendingStream;
+			m_decodeAheadPendingStream = -1;
+			if (!setVideoStream(streamNum))
+				return false;
+			codecIter = m_pCodecCtxs.find(m_videoStream);
+			m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+			if (!m_pCodecCtx)
+				return false;
+		}
+	}
+	if (g_Config.bSeparateVideoThread) {
+		// Wait until the first frame has set up the output, and the header has been read.
+		if (m_pFrameRGB && m_mpegheaderReadPos >= m_mpegheaderSize) {
+			startDecodeAhead(m_pCodecCtx, videoPixelMode);
+			if (stepVideoDecodeAhead(videoPixelMode, skipFrame, &gotFrame))
+				return gotFrame;
+			stopDecodeAhead(false);
+		}
+	}
+
+	bool dataEnd;
+	bool bGetFrame = decodeFrame(m_pCodecCtx, &dataEnd);
+	if (bGetFrame) {
+		if (!m_pFrameRGB) {
+			setVideoDim();
+		}
+		if (m_pFrameRGB && !skipFrame) {
+			updateSwsFormat(videoPixelMode);
+			// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
+			// Update the linesize for the new format too.  We started with the largest size, so it should fit.
+			m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+
+			sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
+				m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+		}
+
+		updateVideoTimeStamp(av_frame_get_best_effort_timestamp(m_pFrame), av_frame_get_pkt_duration(m_pFrame));
+	}
+	if (dataEnd) {
+		// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
+		// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
+		m_isVideoEnd = !bGetFrame && (m_pdata->getQueueSize() == 0);
+		if (m_isVideoEnd)
+			m_decodingsize = 0;
+	}
+	return bGetFrame;
 #else
 	// If video engine is not available, just add to the timestamp at least.
 	m_videopts += 3003;
@@ -695,6 +782,169 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #endif // USE_FFMPEG
 }
 
+#ifdef USE_FFMPEG
+void MediaEngine::startDecodeAhead(AVCodecContext *codecCtx, int videoPixelMode) {
+	m_decodeAheadPixelMode = videoPixelMode;
+	m_decodeAheadStop = false;
+	m_decodeAheadAbort = false;
+	m_decodeAheadExited = false;
+	m_decodeAheadActive = true;
+	m_decodeAheadThread = std::thread([this, codecCtx] {
+		setCurrentThreadName("VideoDecode");
+		decodeAheadLoop(codecCtx);
+	});
+}
+
+// Asks the worker to stop before it starts another frame.  The frame it's on is finished normally
+// (a short read only once stepVideo wants it), so the demuxer never sees a read cut short.
+void MediaEngine::requestStopDecodeAhead() {
+	{
+		std::lock_guard<std::mutex> guard(m_decodeAheadLock);
+		m_decodeAheadStop = true;
+	}
+	m_decodeAheadCond.notify_all();
+}
+
+// With discard, also cuts short a read in progress.  Only for when the demuxer is being thrown away.
+void MediaEngine::stopDecodeAhead(bool discard) {
+	if (m_decodeAheadActive) {
+		{
+			std::lock_guard<std::mutex> guard(m_decodeAheadLock);
+			m_decodeAheadStop = true;
+			m_decodeAheadAbort = discard;
+		}
+		m_decodeAheadCond.notify_all();
+		m_decodeAheadThread.join();
+		m_decodeAheadActive = false;
+	}
+
+	if (discard) {
+		for (DecodedFrame &decoded : m_decodedFrames)
+			av_frame_free(&decoded.frame);
+		m_decodedFrames.clear();
+		m_decodeAheadOffset = 0;
+		m_decodeAheadPendingStream = -1;
+	}
+}
+
+int MediaEngine::decodeAheadRead(u8 *buf, int buf_size) {
+	std::unique_lock<std::mutex> guard(m_decodeAheadLock);
+	// A short read is only allowed once the frame is actually wanted, since that's when
+	// a synchronous decode would have done it.  Until then, wait for the game to add data.
+	m_decodeAheadCond.wait(guard, [&] {
+		return m_decodeAheadAbort || m_decodeAheadWaiting || m_pdata->getQueueSize() - m_decodeAheadOffset >= buf_size;
+	});
+
+	int size = m_pdata->get_front(buf, buf_size, m_decodeAheadOffset);
+	m_decodeAheadOffset += size;
+	m_decodeAheadFrameBytes += size;
+	if (size > 0)
+		m_decodeAheadLastRead = size;
+	return size;
+}
+
+void MediaEngine::decodeAheadLoop(AVCodecContext *codecCtx) {
+	SwsContext *swsCtx = nullptr;
+	AVPixelFormat swsFmt = AV_PIX_FMT_NONE;
+
+	while (true) {
+		int pixelMode;
+		{
+			std::unique_lock<std::mutex> guard(m_decodeAheadLock);
+			m_decodeAheadCond.wait(guard, [&] {
+				return m_decodeAheadStop || m_decodedFrames.size() < DECODE_AHEAD_FRAMES;
+			});
+			if (m_decodeAheadStop)
+				break;
+			pixelMode = m_decodeAheadPixelMode;
+			m_decodeAheadFrameBytes = 0;
+			m_decodeAheadLastRead = 0;
+		}
+
+		DecodedFrame decoded{};
+		decoded.gotFrame = decodeFrame(codecCtx, &decoded.dataEnd);
+		if (decoded.gotFrame) {
+			decoded.pts = av_frame_get_best_effort_timestamp(m_pFrame);
+			decoded.duration = av_frame_get_pkt_duration(m_pFrame);
+			// Keep the source too, in case the game asks for a different format.
+			decoded.frame = av_frame_clone(m_pFrame);
+
+			AVPixelFormat fmt = getSwsFormat(pixelMode);
+			if (fmt != swsFmt) {
+				swsCtx = getSwsContext(swsCtx, codecCtx, m_desWidth, m_desHeight, fmt);
+				swsFmt = fmt;
+			}
+			uint8_t *data[4] = {};
+			int linesize[4] = {};
+			decoded.pixelMode = pixelMode;
+			decoded.image.resize(getPixelFormatBytes(pixelMode) * m_desWidth * m_desHeight);
+			data[0] = decoded.image.data();
+			linesize[0] = getPixelFormatBytes(pixelMode) * m_desWidth;
+			sws_scale(swsCtx, m_pFrame->data, m_pFrame->linesize, 0, codecCtx->height, data, linesize);
+		}
+
+		std::lock_guard<std::mutex> guard(m_decodeAheadLock);
+		decoded.bytesRead = m_decodeAheadFrameBytes;
+		decoded.lastReadSize = m_decodeAheadLastRead;
+		m_decodedFrames.push_back(std::move(decoded));
+		m_decodeAheadFrameCond.notify_one();
+	}
+
+	sws_freeContext(swsCtx);
+	std::lock_guard<std::mutex> guard(m_decodeAheadLock);
+	m_decodeAheadExited = true;
+	m_decodeAheadFrameCond.notify_one();
+}
+
+// Returns false if the worker stopped and there's no frame left, then stepVideo decodes synchronously.
+bool MediaEngine::stepVideoDecodeAhead(int videoPixelMode, bool skipFrame, bool *gotFrame) {
+	DecodedFrame decoded;
+	{
+		std::unique_lock<std::mutex> guard(m_decodeAheadLock);
+		m_decodeAheadPixelMode = videoPixelMode;
+		if (m_decodedFrames.empty() && m_decodeAheadActive) {
+			m_decodeAheadWaiting = true;
+			m_decodeAheadCond.notify_all();
+			m_decodeAheadFrameCond.wait(guard, [&] { return !m_decodedFrames.empty() || m_decodeAheadExited; });
+			m_decodeAheadWaiting = false;
+		}
+		if (m_decodedFrames.empty())
+			return false;
+		decoded = std::move(m_decodedFrames.front());
+		m_decodedFrames.pop_front();
+
+		// Now consume the data this frame used, as a synchronous decode would have.
+		m_pdata->pop_front(0, decoded.bytesRead);
+		m_decodeAheadOffset -= decoded.bytesRead;
+	}
+	m_decodeAheadCond.notify_all();
+
+	if (decoded.lastReadSize > 0)
+		m_decodingsize = decoded.lastReadSize;
+	if (decoded.gotFrame) {
+		if (m_pFrameRGB && !skipFrame) {
+			m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+			if (decoded.pixelMode == videoPixelMode) {
+				memcpy(m_pFrameRGB->data[0], decoded.image.data(), decoded.image.size());
+			} else {
+				updateSwsFormat(videoPixelMode);
+				sws_scale(m_sws_ctx, decoded.frame->data, decoded.frame->linesize, 0,
+					decoded.frame->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+			}
+		}
+		updateVideoTimeStamp(decoded.pts, decoded.duration);
+		av_frame_free(&decoded.frame);
+	}
+	if (decoded.dataEnd) {
+		m_isVideoEnd = !decoded.gotFrame && (m_pdata->getQueueSize() == 0);
+		if (m_isVideoEnd)
+			m_decodingsize = 0;
+	}
+	*gotFrame = decoded.gotFrame;
+	return true;
+}
+#endif
+
 // Helpers that null out alpha (which seems to be the case on the PSP.)
 // Some games depend on this, for example Sword Art Online (doesn't clear A's from buffer.)
 inline void writeVideoLineRGBA(void *destp, const void *srcp, int width) {
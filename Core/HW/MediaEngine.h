@@ -24,7 +24,13 @@
 
 // An approximation of what the interface will look like. Similar to JPCSP's.
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/HLE/sceMpeg.h"
 #include "Core/HW/MpegDemux.h"
@@ -94,12 +100,43 @@ class MediaEngine
 
 	void DoState(PointerWrap &p);
 
+#ifdef USE_FFMPEG
+	// Called from the decode-ahead thread through the AVIO callback.
+	int decodeAheadRead(u8 *buf, int buf_size);
+#endif
+
 private:
 	bool SetupStreams();
 	bool setVideoDim(int width = 0, int height = 0);
 	void updateSwsFormat(int videoPixelMode);
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2);
 
+#ifdef USE_FFMPEG
+	bool decodeFrame(AVCodecContext *codecCtx, bool *dataEnd);
+	void updateVideoTimeStamp(s64 pts, s64 duration);
+
+	// With bSeparateVideoThread, the next frames are decoded and converted on a worker thread.
+	// It only peeks at m_pdata, and the bytes a frame used are removed once stepVideo takes it,
+	// so the game sees the same ringbuffer state as when decoding synchronously.
+	struct DecodedFrame {
+		bool gotFrame;
+		bool dataEnd;
+		int bytesRead;
+		int lastReadSize;
+		s64 pts;
+		s64 duration;
+		int pixelMode;
+		AVFrame *frame;
+		std::vector<u8> image;
+	};
+
+	void startDecodeAhead(AVCodecContext *codecCtx, int videoPixelMode);
+	void requestStopDecodeAhead();
+	void stopDecodeAhead(bool discard);
+	void decodeAheadLoop(AVCodecContext *codecCtx);
+	bool stepVideoDecodeAhead(int videoPixelMode, bool skipFrame, bool *gotFrame);
+#endif
+
 public:  // TODO: Very little of this below should be public.
 
 	// Video ffmpeg context - not used for audio
@@ -110,6 +147,26 @@ class MediaEngine
 	AVFrame *m_pFrameRGB;
 	AVIOContext *m_pIOContext;
 	SwsContext *m_sws_ctx;
+
+	std::thread m_decodeAheadThread;
+	std::mutex m_decodeAheadLock;
+	// Signals the worker: data added, frame taken, frame wanted, or stop.
+	std::condition_variable m_decodeAheadCond;
+	std::condition_variable m_decodeAheadFrameCond;
+	std::deque<DecodedFrame> m_decodedFrames;
+	// Bytes the worker has read past the front of m_pdata.
+	int m_decodeAheadOffset = 0;
+	int m_decodeAheadFrameBytes = 0;
+	int m_decodeAheadLastRead = 0;
+	int m_decodeAheadPixelMode = 0;
+	bool m_decodeAheadActive = false;
+	bool m_decodeAheadWaiting = false;
+	bool m_decodeAheadStop = false;
+	// Only set when tearing down, cuts short a read in progress.
+	bool m_decodeAheadAbort = false;
+	bool m_decodeAheadExited = false;
+	// A setVideoStream that has to wait for the worker to stop.
+	int m_decodeAheadPendingStream = -1;
 #endif
 
 	int m_sws_fmt;
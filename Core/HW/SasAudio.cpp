@@ -17,6 +17,8 @@
 
 #include <algorithm>
 
+#include "ppsspp_config.h"
+#include "Common/Common.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Serialize/SerializeFuncs.h"
@@ -27,6 +29,17 @@
 #include "Core/Util/AudioFormat.h"
 #include "SasAudio.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 // #define AUDIO_TO_FILE
 
 static const u8 f[16][2] = {
@@ -518,36 +531,11 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			voice.envelope.Step();
 		}
 
-		const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
-		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
-
-			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
-			int sample = s[0];
-			if (needsInterp) {
-				int f = sampleFrac & PSP_SAS_PITCH_MASK;
-				sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
-			}
-			sampleFrac += voicePitch;
-
-			// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
-			// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
-			int envelopeValue = voice.envelope.GetHeight();
-			voice.envelope.Step();
-			envelopeValue = (envelopeValue + (1 << 14)) >> 15;
-
-			// We just scale by the envelope before we scale by volumes.
-			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
-		}
+		// The envelope is walked for the whole grain first, so the samples can be mixed several at a time.
+		const int count = std::max(0, grainSize - delay);
+		voice.envelope.StepBlock(envelopeTemp_, count);
+		SasMixSamples(voice, mixBuffer + delay * 2, sendBuffer + delay * 2, mixTemp_, sampleFrac, envelopeTemp_, count);
+		sampleFrac += voicePitch * count;
 
 		voice.resampleHist[0] = mixTemp_[tempPos - 2];
 		voice.resampleHist[1] = mixTemp_[tempPos - 1];
@@ -564,6 +552,147 @@ void SasInstance::MixVoice(SasVoice &voice) {
 	}
 }
 
+static inline void SasMixSample(const SasVoice &voice, int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, bool needsInterp, int envelopeValue) {
+	const int16_t *s = src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+
+	// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
+	int sample = s[0];
+	if (needsInterp) {
+		int f = sampleFrac & PSP_SAS_PITCH_MASK;
+		sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+	}
+
+	// We just scale by the envelope before we scale by volumes.
+	// Again, we round up by adding (1 << 14) first (*after* multiplying.)
+	sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
+
+	// We mix into this 32-bit temp buffer and clip in a second loop
+	// Ideally, the shift right should be there too but for now I'm concerned about
+	// not overflowing.
+	mixBuffer[0] += (sample * voice.volumeLeft) >> 12;
+	mixBuffer[1] += (sample * voice.volumeRight) >> 12;
+	sendBuffer[0] += sample * voice.effectLeft >> 12;
+	sendBuffer[1] += sample * voice.effectRight >> 12;
+}
+
+void SasMixSamples_Scalar(const SasVoice &voice, int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, const int *envelope, int count) {
+	const bool needsInterp = voice.pitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
+	for (int i = 0; i < count; i++) {
+		SasMixSample(voice, mixBuffer + i * 2, sendBuffer + i * 2, src, sampleFrac, needsInterp, envelope[i]);
+		sampleFrac += voice.pitch;
+	}
+}
+
+#ifdef _M_SSE
+// Low 32 bits of each product, same as a plain int multiply.  SSE2 lacks _mm_mullo_epi32.
+static inline __m128i SasMulLo32(__m128i a, __m128i b) {
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline void SasAccumulate(int *dest, __m128i samples, __m128i vol) {
+	__m128i *destp = (__m128i *)dest;
+	__m128i scaled = _mm_srai_epi32(SasMulLo32(samples, vol), 12);
+	_mm_storeu_si128(destp, _mm_add_epi32(_mm_loadu_si128(destp), scaled));
+}
+#endif
+
+void SasMixSamples(const SasVoice &voice, int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, const int *envelope, int count) {
+	const int pitch = voice.pitch;
+	const bool needsInterp = pitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
+	int i = 0;
+
+#ifdef _M_SSE
+	const __m128i fracMask = _mm_set1_epi32(PSP_SAS_PITCH_MASK);
+	const __m128i round = _mm_set1_epi32(1 << 14);
+	const __m128i volMix = _mm_setr_epi32(voice.volumeLeft, voice.volumeRight, voice.volumeLeft, voice.volumeRight);
+	const __m128i volSend = _mm_setr_epi32(voice.effectLeft, voice.effectRight, voice.effectLeft, voice.effectRight);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i sample;
+		if (needsInterp) {
+			const u32 f0 = sampleFrac;
+			const u32 f1 = f0 + pitch;
+			const u32 f2 = f1 + pitch;
+			const u32 f3 = f2 + pitch;
+			const s16 *s0 = src + (f0 >> PSP_SAS_PITCH_BASE_SHIFT);
+			const s16 *s1 = src + (f1 >> PSP_SAS_PITCH_BASE_SHIFT);
+			const s16 *s2 = src + (f2 >> PSP_SAS_PITCH_BASE_SHIFT);
+			const s16 *s3 = src + (f3 >> PSP_SAS_PITCH_BASE_SHIFT);
+			// Pairs of (s[0], s[1]) and (MASK - f, f), so a single madd does the interpolation.
+			__m128i pairs = _mm_setr_epi16(s0[0], s0[1], s1[0], s1[1], s2[0], s2[1], s3[0], s3[1]);
+			__m128i f = _mm_and_si128(_mm_setr_epi32(f0, f1, f2, f3), fracMask);
+			__m128i weights = _mm_or_si128(_mm_sub_epi32(fracMask, f), _mm_slli_epi32(f, 16));
+			sample = _mm_srai_epi32(_mm_madd_epi16(pairs, weights), PSP_SAS_PITCH_BASE_SHIFT);
+		} else {
+			__m128i raw = _mm_loadl_epi64((const __m128i *)(src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT)));
+			sample = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+		}
+		sampleFrac += pitch * 4;
+
+		__m128i env = _mm_loadu_si128((const __m128i *)(envelope + i));
+		sample = _mm_srai_epi32(_mm_add_epi32(SasMulLo32(sample, env), round), 15);
+
+		// Now duplicate each sample for left and right.
+		__m128i samplesLo = _mm_unpacklo_epi32(sample, sample);
+		__m128i samplesHi = _mm_unpackhi_epi32(sample, sample);
+		SasAccumulate(mixBuffer + i * 2, samplesLo, volMix);
+		SasAccumulate(mixBuffer + i * 2 + 4, samplesHi, volMix);
+		SasAccumulate(sendBuffer + i * 2, samplesLo, volSend);
+		SasAccumulate(sendBuffer + i * 2 + 4, samplesHi, volSend);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const int32x4_t fracMask = vdupq_n_s32(PSP_SAS_PITCH_MASK);
+	const int32x4_t round = vdupq_n_s32(1 << 14);
+	const int32_t volMixArr[4] = { voice.volumeLeft, voice.volumeRight, voice.volumeLeft, voice.volumeRight };
+	const int32_t volSendArr[4] = { voice.effectLeft, voice.effectRight, voice.effectLeft, voice.effectRight };
+	const int32x4_t volMix = vld1q_s32(volMixArr);
+	const int32x4_t volSend = vld1q_s32(volSendArr);
+
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t sample;
+		if (needsInterp) {
+			int32_t fracs[4];
+			int32_t first[4];
+			int32_t second[4];
+			for (int j = 0; j < 4; ++j) {
+				const u32 f = sampleFrac + pitch * j;
+				const s16 *s = src + (f >> PSP_SAS_PITCH_BASE_SHIFT);
+				fracs[j] = f;
+				first[j] = s[0];
+				second[j] = s[1];
+			}
+			int32x4_t f = vandq_s32(vld1q_s32(fracs), fracMask);
+			int32x4_t interp = vmulq_s32(vld1q_s32(first), vsubq_s32(fracMask, f));
+			interp = vmlaq_s32(interp, vld1q_s32(second), f);
+			sample = vshrq_n_s32(interp, PSP_SAS_PITCH_BASE_SHIFT);
+		} else {
+			sample = vmovl_s16(vld1_s16(src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT)));
+		}
+		sampleFrac += pitch * 4;
+
+		int32x4_t env = vld1q_s32(envelope + i);
+		sample = vshrq_n_s32(vmlaq_s32(round, sample, env), 15);
+
+		// Now duplicate each sample for left and right.
+		int32x4x2_t samples = vzipq_s32(sample, sample);
+		int *mix = mixBuffer + i * 2;
+		int *send = sendBuffer + i * 2;
+		vst1q_s32(mix, vaddq_s32(vld1q_s32(mix), vshrq_n_s32(vmulq_s32(samples.val[0], volMix), 12)));
+		vst1q_s32(mix + 4, vaddq_s32(vld1q_s32(mix + 4), vshrq_n_s32(vmulq_s32(samples.val[1], volMix), 12)));
+		vst1q_s32(send, vaddq_s32(vld1q_s32(send), vshrq_n_s32(vmulq_s32(samples.val[0], volSend), 12)));
+		vst1q_s32(send + 4, vaddq_s32(vld1q_s32(send + 4), vshrq_n_s32(vmulq_s32(samples.val[1], volSend), 12)));
+	}
+#endif
+
+	// This does the remainder if SIMD was used, otherwise it does it all.
+	for (; i < count; i++) {
+		SasMixSample(voice, mixBuffer + i * 2, sendBuffer + i * 2, src, sampleFrac, needsInterp, envelope[i]);
+		sampleFrac += pitch;
+	}
+}
+
 void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
 	int voicesPlayingCount = 0;
 
@@ -921,6 +1050,23 @@ inline void ADSREnvelope::Step() {
 	}
 }
 
+void ADSREnvelope::StepBlock(int *envelope, int count) {
+	for (int i = 0; i < count; ++i) {
+		// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
+		// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
+		envelope[i] = (GetHeight() + (1 << 14)) >> 15;
+
+		const ADSRState prevState = state_;
+		const s64 prevHeight = height_;
+		Step();
+		if (state_ == prevState && height_ == prevHeight) {
+			// Step() only depends on the state and height, so nothing will change for the rest of the block.
+			std::fill(envelope + i + 1, envelope + count, envelope[i]);
+			return;
+		}
+	}
+}
+
 void ADSREnvelope::KeyOn() {
 	SetState(STATE_KEYON);
 }
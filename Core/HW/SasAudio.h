@@ -159,6 +159,8 @@ class ADSREnvelope {
 	void End();
 
 	inline void Step();
+	// Steps count times, storing the rounded 15-bit height from before each step.
+	void StepBlock(int *envelope, int count);
 
 	int GetHeight() const {
 		return height_ > (s64)PSP_SAS_ENVELOPE_HEIGHT_MAX ? PSP_SAS_ENVELOPE_HEIGHT_MAX : height_;
@@ -312,4 +314,12 @@ class SasInstance {
 	SasReverb reverb_;
 	int grainSize = 0;
 	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	int envelopeTemp_[PSP_SAS_MAX_GRAIN];
 };
+
+// Resamples count samples of the voice from src (starting at sampleFrac), scales them by the
+// already stepped envelope, and mixes them into the mix and send buffers.
+// The scalar version is the reference, the other uses SSE2/NEON where available.
+// They must produce exactly the same output.
+void SasMixSamples(const SasVoice &voice, int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, const int *envelope, int count);
+void SasMixSamples_Scalar(const SasVoice &voice, int *mixBuffer, int *sendBuffer, const s16 *src, u32 sampleFrac, const int *envelope, int count);
@@ -27,6 +27,33 @@
 
 struct AudioDebugStats;
 
+// Kaiser windowed sinc interpolation filter, one set of taps per fractional phase.
+struct PolyphaseFilter {
+	enum {
+		TAPS = 8,
+		PHASE_BITS = 8,
+		PHASES = 1 << PHASE_BITS,
+		// Coefficients are Q14, each phase sums to exactly 1 << COEF_SHIFT.
+		COEF_SHIFT = 14,
+		// The output lags the read position by this many frames, since it reads taps ahead only.
+		DELAY = TAPS / 2 - 1,
+	};
+
+	// Cutoff is relative to the input Nyquist frequency, 1.0 to keep the full band.
+	void Build(double cutoff);
+
+	s16 taps[PHASES][TAPS];
+	// Same taps, ordered to match interleaved stereo for the SIMD paths.
+	s16 packed[PHASES][TAPS * 2];
+};
+
+// These read interleaved stereo from a ring buffer with indices in samples (two per frame.)
+// For the polyphase variants, the ring must repeat its first TAPS frames after the end.
+// They return the number of frames written, which is less than numFrames on underrun.
+u32 ResampleLinear(s16 *out, u32 numFrames, const s16 *ring, u32 indexMask, u32 &indexR, u32 indexW, u32 &frac, u32 ratio);
+u32 ResamplePolyphase(s16 *out, u32 numFrames, const s16 *ring, u32 indexMask, u32 &indexR, u32 indexW, u32 &frac, u32 ratio, const PolyphaseFilter &filter);
+u32 ResamplePolyphase_Scalar(s16 *out, u32 numFrames, const s16 *ring, u32 indexMask, u32 &indexR, u32 indexW, u32 &frac, u32 ratio, const PolyphaseFilter &filter);
+
 class StereoResampler {
 public:
 	StereoResampler();
@@ -64,6 +91,9 @@ class StereoResampler {
 	int lastPushSize_ = 0;
 	u32 ratio_ = 0;
 
+	PolyphaseFilter filter_;
+	int filterSampleRate_ = 0;
+
 	int underrunCount_ = 0;
 	int overrunCount_ = 0;
 	int underrunCountTotal_ = 0;
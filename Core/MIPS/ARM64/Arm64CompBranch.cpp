@@ -653,6 +653,13 @@ void Arm64Jit::Comp_Syscall(MIPSOpcode op)
 	MOVI2R(W0, op.encoding);
 	QuickCallFunction(X1, (void *)&CallSyscall);
 #else
+	// Simple syscalls can skip the wrappers, and usually the exit too.
+	HLEDirectCall direct;
+	if (!js.inDelaySlot && GetDirectSyscall(op, &direct)) {
+		CompDirectSyscall(direct);
+		return;
+	}
+
 	// Skip the CallSyscall where possible.
 	void *quickFunc = GetQuickSyscallFunc(op);
 	if (quickFunc) {
@@ -671,6 +678,39 @@ void Arm64Jit::Comp_Syscall(MIPSOpcode op)
 	js.compiling = false;
 }
 
+void Arm64Jit::CompDirectSyscall(const HLEDirectCall &direct) {
+	// Static registers were already saved.
+	MOVP2R(SCRATCH1_64, direct.latestSyscall);
+	MOVP2R(SCRATCH2_64, direct.info);
+	STR(INDEX_UNSIGNED, SCRATCH2_64, SCRATCH1_64, 0);
+	QuickCallFunction(SCRATCH1_64, (const void *)direct.func);
+
+	// If it wants to reschedule or similar, let HLE finish it and leave the block.
+	MOVP2R(SCRATCH1_64, direct.afterSyscall);
+	LDR(INDEX_UNSIGNED, SCRATCH1, SCRATCH1_64, 0);
+	FixupBranch simple = CBZ(SCRATCH1);
+	MOVP2R(X0, direct.info);
+	QuickCallFunction(SCRATCH1_64, (const void *)direct.finish);
+	LoadStaticRegisters();
+	ApplyRoundingMode();
+	WriteSyscallExit();
+
+	SetJumpTarget(simple);
+	LoadStaticRegisters();
+	ApplyRoundingMode();
+	if (!g_Config.bSkipDeadbeefFilling) {
+		static const MIPSGPReg deadbeefRegs[] = {
+			MIPS_REG_COMPILER_SCRATCH, MIPS_REG_A0, MIPS_REG_A1, MIPS_REG_A2, MIPS_REG_A3,
+			MIPS_REG_T0, MIPS_REG_T1, MIPS_REG_T2, MIPS_REG_T3, MIPS_REG_T4, MIPS_REG_T5,
+			MIPS_REG_T6, MIPS_REG_T7, MIPS_REG_T8, MIPS_REG_T9, MIPS_REG_HI, MIPS_REG_LO,
+		};
+		MOVI2R(SCRATCH1, 0xDEADBEEF);
+		for (MIPSGPReg reg : deadbeefRegs)
+			STR(INDEX_UNSIGNED, SCRATCH1, CTXREG, gpr.GetMipsRegOffset(reg));
+	}
+	// Everything was flushed, so we can just keep going with the block.
+}
+
 void Arm64Jit::Comp_Break(MIPSOpcode op)
 {
 	Comp_Generic(op);
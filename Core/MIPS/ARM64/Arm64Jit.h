@@ -31,6 +31,8 @@
 #include "stddef.h"
 #endif
 
+struct HLEDirectCall;
+
 namespace MIPSComp {
 
 class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MIPSFrontendInterface {
@@ -216,6 +218,7 @@ class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MI
 	void WriteExit(u32 destination, int exit_num);
 	void WriteExitDestInR(Arm64Gen::ARM64Reg Reg);
 	void WriteSyscallExit();
+	void CompDirectSyscall(const HLEDirectCall &direct);
 	bool CheckJitBreakpoint(u32 addr, int downcountOffset);
 	bool CheckMemoryBreakpoint(int instructionOffset = 0);
 
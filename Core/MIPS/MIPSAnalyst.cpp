@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -24,12 +25,15 @@
 #include "ext/cityhash/city.h"
 #include "ext/xxhash.h"
 
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
+#include "Core/ThreadPools.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "Core/MIPS/MIPSTables.h"
@@ -875,40 +879,50 @@ namespace MIPSAnalyst {
 		return DetermineRegisterUsage(reg, addr, instrs) == USAGE_CLOBBERED;
 	}
 
-	void HashFunctions() {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-		std::vector<u32> buffer;
+	static void HashFunction(AnalyzedFunction &f, std::vector<u32> &buffer) {
+		if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
+			return;
+		}
 
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			AnalyzedFunction &f = *iter;
-			if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
-				continue;
+		// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
+		buffer.resize((f.end - f.start + 4) / 4);
+		size_t pos = 0;
+		for (u32 addr = f.start; addr <= f.end; addr += 4) {
+			u32 validbits = 0xFFFFFFFF;
+			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
+			if (MIPS_IS_EMUHACK(instr)) {
+				f.hasHash = false;
+				return;
 			}
 
-			// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
-			buffer.resize((f.end - f.start + 4) / 4);
-			size_t pos = 0;
-			for (u32 addr = f.start; addr <= f.end; addr += 4) {
-				u32 validbits = 0xFFFFFFFF;
-				MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
-				if (MIPS_IS_EMUHACK(instr)) {
-					f.hasHash = false;
-					goto skip;
-				}
+			MIPSInfo flags = MIPSGetInfo(instr);
+			if (flags & IN_IMM16)
+				validbits &= ~0xFFFF;
+			if (flags & IN_IMM26)
+				validbits &= ~0x03FFFFFF;
+			buffer[pos++] = instr & validbits;
+		}
 
-				MIPSInfo flags = MIPSGetInfo(instr);
-				if (flags & IN_IMM16)
-					validbits &= ~0xFFFF;
-				if (flags & IN_IMM26)
-					validbits &= ~0x03FFFFFF;
-				buffer[pos++] = instr & validbits;
+		f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
+		f.hasHash = true;
+	}
+
+	// Functions are independent, so this runs on the thread pool.  Already hashed ones are skipped,
+	// so earlier modules aren't hashed again every time one loads.
+	static void HashFunctionList(FunctionsVector &funcs) {
+		GlobalThreadPool::Loop([&](int lower, int upper) {
+			std::vector<u32> buffer;
+			for (int i = lower; i < upper; ++i) {
+				if (!funcs[i].hasHash) {
+					HashFunction(funcs[i], buffer);
+				}
 			}
+		}, 0, (int)funcs.size());
+	}
 
-			f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
-			f.hasHash = true;
-skip:
-			;
-		}
+	void HashFunctions() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		HashFunctionList(functions);
 	}
 
 	void PrecompileFunction(u32 startAddr, u32 length) {
@@ -1021,12 +1035,14 @@ namespace MIPSAnalyst {
 		return furthestJumpbackAddr;
 	}
 
-	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-
-		FunctionsVector new_functions;
-
+	// Scans for functions from a clean state at startAddr.  The state is fully reset after each
+	// function, so two scans that reset at the same address agree from there on.
+	// Stops at the first reset at or after stopAt, or at one listed in the sorted syncAt.
+	// Returns where it stopped, which is past endAddr if it ran off the end.
+	static u32 ScanFunctionRange(u32 startAddr, u32 endAddr, u32 stopAt, const std::vector<u32> *syncAt, FunctionsVector &new_functions, std::vector<u32> *resets) {
 		AnalyzedFunction currentFunction = {startAddr};
+		if (resets)
+			resets->push_back(startAddr);
 
 		u32 furthestBranch = 0;
 		bool looking = false;
@@ -1131,21 +1147,6 @@ namespace MIPSAnalyst {
 				currentFunction.end = addr + 4;
 				currentFunction.isStraightLeaf = isStraightLeaf;
 
-				// Check if we already have symbol info starting here.  If so, skip insertion.
-				// We used to use the symbols to find the functions, but sometimes we'd find
-				// wrong ones due to two modules with the same name.
-				u32 existingSize = g_symbolMap->GetFunctionSize(currentFunction.start);
-				if (existingSize != SymbolMap::INVALID_ADDRESS) {
-					currentFunction.foundInSymbolMap = true;
-
-					// If we run into a func with a different size, skip updating the hash map.
-					// This will prevent us saving incorrectly named funcs with wrong hashes.
-					u32 detectedSize = currentFunction.end - currentFunction.start + 4;
-					if (existingSize != detectedSize) {
-						insertSymbols = false;
-					}
-				}
-
 				new_functions.push_back(currentFunction);
 
 				furthestBranch = 0;
@@ -1155,7 +1156,12 @@ namespace MIPSAnalyst {
 				isStraightLeaf = true;
 				decreasedSp = false;
 				currentFunction.start = addr + 4;
-				currentFunction.foundInSymbolMap = false;
+
+				if (currentFunction.start >= stopAt || (syncAt && std::binary_search(syncAt->begin(), syncAt->end(), currentFunction.start))) {
+					return currentFunction.start;
+				}
+				if (resets)
+					resets->push_back(currentFunction.start);
 			}
 		}
 
@@ -1163,6 +1169,196 @@ namespace MIPSAnalyst {
 			currentFunction.end = addr + 4;
 			new_functions.push_back(currentFunction);
 		}
+		return addr;
+	}
+
+	struct FunctionScanChunk {
+		FunctionsVector functions;
+		// Address the scan state was reset at for each function, before skipping nop padding.
+		std::vector<u32> resets;
+		u32 stoppedAt;
+	};
+
+	// Big modules are scanned in chunks on the thread pool.  Each chunk is scanned from its own start,
+	// and the results are stitched together at the first function boundary both scans agree on, which
+	// gives exactly the same functions as a single scan.
+	static void ScanFunctionsParallel(u32 startAddr, u32 endAddr, FunctionsVector &new_functions) {
+		static const u32 CHUNK_SIZE = 0x10000;
+		int numChunks = (int)((endAddr + 4 - startAddr + CHUNK_SIZE - 1) / CHUNK_SIZE);
+		if (numChunks <= 1) {
+			ScanFunctionRange(startAddr, endAddr, endAddr + 4, nullptr, new_functions, nullptr);
+			return;
+		}
+
+		std::vector<FunctionScanChunk> chunks(numChunks);
+		GlobalThreadPool::Loop([&](int lower, int upper) {
+			for (int i = lower; i < upper; ++i) {
+				u32 chunkStart = startAddr + i * CHUNK_SIZE;
+				u32 stopAt = i + 1 < numChunks ? chunkStart + CHUNK_SIZE : endAddr + 4;
+				chunks[i].stoppedAt = ScanFunctionRange(chunkStart, endAddr, stopAt, nullptr, chunks[i].functions, &chunks[i].resets);
+			}
+		}, 0, numChunks);
+
+		u32 pos = startAddr;
+		for (const FunctionScanChunk &chunk : chunks) {
+			if (pos >= chunk.stoppedAt) {
+				continue;
+			}
+
+			auto it = std::lower_bound(chunk.resets.begin(), chunk.resets.end(), pos);
+			if (it == chunk.resets.end() || *it != pos) {
+				// We came into this chunk in the middle of a function, scan until we line up with it.
+				pos = ScanFunctionRange(pos, endAddr, chunk.stoppedAt, &chunk.resets, new_functions, nullptr);
+				if (pos >= chunk.stoppedAt) {
+					continue;
+				}
+				it = std::lower_bound(chunk.resets.begin(), chunk.resets.end(), pos);
+			}
+
+			size_t index = it - chunk.resets.begin();
+			if (index < chunk.functions.size()) {
+				new_functions.insert(new_functions.end(), chunk.functions.begin() + index, chunk.functions.end());
+			}
+			pos = chunk.stoppedAt;
+		}
+	}
+
+	static const u32 SCAN_CACHE_MAGIC = 0x4E435346;  // FSCN
+	static const u32 SCAN_CACHE_VERSION = 1;
+	// One file per module seen, so this is plenty.  Past it, the cache starts over.
+	static const size_t MAX_SCAN_CACHE_FILES = 256;
+
+	struct ScanCacheHeader {
+		u32 magic;
+		u32 version;
+		u32 startAddr;
+		u32 endAddr;
+		u32 count;
+	};
+
+	struct ScanCacheEntry {
+		u32 start;
+		u32 end;
+		u64 hash;
+		u32 isStraightLeaf;
+		u32 hasHash;
+	};
+
+	// The scan only depends on the code, so a hash of it identifies a module across boots.
+	static std::string ScanCacheFilename(u32 startAddr, u32 endAddr) {
+		if (PSP_CoreParameter().headLess || endAddr < startAddr || !Memory::IsValidRange(startAddr, endAddr + 4 - startAddr)) {
+			return "";
+		}
+		u64 codeHash = XXH3_64bits(Memory::GetPointer(startAddr), endAddr + 4 - startAddr);
+		return StringFromFormat("%s/FuncScan/%08x_%016llx.funcscan", GetSysDirectory(DIRECTORY_APP_CACHE).c_str(), startAddr, (unsigned long long)codeHash);
+	}
+
+	static bool LoadScanCache(const std::string &filename, u32 startAddr, u32 endAddr, FunctionsVector &new_functions) {
+		if (filename.empty()) {
+			return false;
+		}
+		FILE *f = File::OpenCFile(filename, "rb");
+		if (!f) {
+			return false;
+		}
+
+		ScanCacheHeader header;
+		bool success = fread(&header, sizeof(header), 1, f) == 1;
+		success = success && header.magic == SCAN_CACHE_MAGIC && header.version == SCAN_CACHE_VERSION;
+		success = success && header.startAddr == startAddr && header.endAddr == endAddr;
+		// There can't be more functions than instructions, don't trust the count further than that.
+		success = success && header.count <= (endAddr - startAddr) / 4 + 1;
+		std::vector<ScanCacheEntry> entries;
+		if (success) {
+			entries.resize(header.count);
+			success = header.count == 0 || fread(&entries[0], sizeof(ScanCacheEntry), header.count, f) == header.count;
+		}
+		fclose(f);
+		if (!success) {
+			WARN_LOG(LOADER, "Ignoring bad function scan cache: %s", filename.c_str());
+			return false;
+		}
+
+		for (const ScanCacheEntry &entry : entries) {
+			AnalyzedFunction func = { entry.start };
+			func.end = entry.end;
+			func.hash = entry.hash;
+			func.isStraightLeaf = entry.isStraightLeaf != 0;
+			func.hasHash = entry.hasHash != 0;
+			new_functions.push_back(func);
+		}
+		return true;
+	}
+
+	static void SaveScanCache(const std::string &filename, u32 startAddr, u32 endAddr, const FunctionsVector &new_functions) {
+		if (filename.empty()) {
+			return;
+		}
+		const std::string dir = GetSysDirectory(DIRECTORY_APP_CACHE) + "/FuncScan";
+		File::CreateFullPath(dir);
+
+		std::vector<FileInfo> files;
+		if (getFilesInDir(dir.c_str(), &files, "funcscan:") >= MAX_SCAN_CACHE_FILES) {
+			INFO_LOG(LOADER, "Clearing function scan cache (%d files)", (int)files.size());
+			for (const FileInfo &file : files) {
+				if (!file.isDirectory)
+					File::Delete(file.fullName);
+			}
+		}
+
+		FILE *f = File::OpenCFile(filename, "wb");
+		if (!f) {
+			return;
+		}
+
+		ScanCacheHeader header = { SCAN_CACHE_MAGIC, SCAN_CACHE_VERSION, startAddr, endAddr, (u32)new_functions.size() };
+		std::vector<ScanCacheEntry> entries;
+		entries.reserve(new_functions.size());
+		for (const AnalyzedFunction &func : new_functions) {
+			ScanCacheEntry entry = { func.start, func.end, func.hash, func.isStraightLeaf ? 1U : 0U, func.hasHash ? 1U : 0U };
+			entries.push_back(entry);
+		}
+
+		bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+		success = success && (entries.empty() || fwrite(&entries[0], sizeof(ScanCacheEntry), entries.size(), f) == entries.size());
+		fclose(f);
+		if (!success) {
+			WARN_LOG(LOADER, "Could not write function scan cache: %s", filename.c_str());
+			File::Delete(filename);
+		}
+	}
+
+	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		// Code here may have changed without ForgetFunctions (like a module loaded at the same address.)
+		InvalidateHashes(startAddr, endAddr);
+
+		FunctionsVector new_functions;
+		std::string cacheFilename = ScanCacheFilename(startAddr, endAddr);
+		if (!LoadScanCache(cacheFilename, startAddr, endAddr, new_functions)) {
+			ScanFunctionsParallel(startAddr, endAddr, new_functions);
+			// Hash now, so the hashes go in the cache too.
+			HashFunctionList(new_functions);
+			SaveScanCache(cacheFilename, startAddr, endAddr, new_functions);
+		}
+
+		for (AnalyzedFunction &func : new_functions) {
+			// Check if we already have symbol info starting here.  If so, skip insertion.
+			// We used to use the symbols to find the functions, but sometimes we'd find
+			// wrong ones due to two modules with the same name.
+			u32 existingSize = g_symbolMap->GetFunctionSize(func.start);
+			if (existingSize != SymbolMap::INVALID_ADDRESS) {
+				func.foundInSymbolMap = true;
+
+				// If we run into a func with a different size, skip updating the hash map.
+				// This will prevent us saving incorrectly named funcs with wrong hashes.
+				u32 detectedSize = func.end - func.start + 4;
+				if (existingSize != detectedSize) {
+					insertSymbols = false;
+				}
+			}
+		}
 
 		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
 			iter->size = iter->end - iter->start + 4;
@@ -1218,7 +1414,7 @@ namespace MIPSAnalyst {
 		}
 
 		// Cheats a little.
-		AnalyzedFunction fun;
+		AnalyzedFunction fun{};
 		fun.start = startAddr;
 		fun.end = startAddr + size - 4;
 		fun.isStraightLeaf = false;  // dunno really
@@ -1229,6 +1425,14 @@ namespace MIPSAnalyst {
 		HashFunctions();
 	}
 
+	void InvalidateHashes(u32 startAddr, u32 endAddr) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		for (AnalyzedFunction &f : functions) {
+			if (f.start <= endAddr && f.end >= startAddr)
+				f.hasHash = false;
+		}
+	}
+
 	void ForgetFunctions(u32 startAddr, u32 endAddr) {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 
@@ -1270,6 +1474,10 @@ namespace MIPSAnalyst {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 
 		for (size_t i = 0; i < functions.size(); i++) {
+			// Code changed since the hash was taken (or it never was), so it may not be that function anymore.
+			if (!functions[i].hasHash) {
+				continue;
+			}
 			WriteReplaceInstructions(functions[i].start, functions[i].hash, functions[i].size);
 		}
 	}
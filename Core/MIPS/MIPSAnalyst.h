@@ -109,6 +109,8 @@ namespace MIPSAnalyst
 	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols);
 	void FinalizeScan(bool insertSymbols);
 	void ForgetFunctions(u32 startAddr, u32 endAddr);
+	// The code changed, so these are hashed again next time.  Inclusive range.
+	void InvalidateHashes(u32 startAddr, u32 endAddr);
 	void PrecompileFunctions();
 	void PrecompileFunction(u32 startAddr, u32 length);
 
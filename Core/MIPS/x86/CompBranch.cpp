@@ -799,6 +799,13 @@ void Jit::Comp_Syscall(MIPSOpcode op)
 	// When profiling, we can't skip CallSyscall, since it times syscalls.
 	ABI_CallFunctionC(&CallSyscall, op.encoding);
 #else
+	// Simple syscalls can skip the wrappers, and usually the exit too.
+	HLEDirectCall direct;
+	if (!js.inDelaySlot && GetDirectSyscall(op, &direct)) {
+		CompDirectSyscall(direct);
+		return;
+	}
+
 	// Skip the CallSyscall where possible.
 	void *quickFunc = GetQuickSyscallFunc(op);
 	if (quickFunc)
@@ -812,6 +819,34 @@ void Jit::Comp_Syscall(MIPSOpcode op)
 	js.compiling = false;
 }
 
+void Jit::CompDirectSyscall(const HLEDirectCall &direct) {
+	MOV(PTRBITS, R(RAX), ImmPtr(direct.latestSyscall));
+	MOV(PTRBITS, R(RDX), ImmPtr(direct.info));
+	MOV(PTRBITS, MatR(RAX), R(RDX));
+	ABI_CallFunction((const void *)direct.func);
+
+	// If it wants to reschedule or similar, let HLE finish it and leave the block.
+	MOV(PTRBITS, R(RAX), ImmPtr(direct.afterSyscall));
+	CMP(32, MatR(RAX), Imm32(0));
+	FixupBranch simple = J_CC(CC_Z, true);
+	ABI_CallFunctionP((const void *)direct.finish, (void *)direct.info);
+	ApplyRoundingMode();
+	WriteSyscallExit();
+
+	SetJumpTarget(simple);
+	ApplyRoundingMode();
+	if (!g_Config.bSkipDeadbeefFilling) {
+		static const MIPSGPReg deadbeefRegs[] = {
+			MIPS_REG_COMPILER_SCRATCH, MIPS_REG_A0, MIPS_REG_A1, MIPS_REG_A2, MIPS_REG_A3,
+			MIPS_REG_T0, MIPS_REG_T1, MIPS_REG_T2, MIPS_REG_T3, MIPS_REG_T4, MIPS_REG_T5,
+			MIPS_REG_T6, MIPS_REG_T7, MIPS_REG_T8, MIPS_REG_T9, MIPS_REG_HI, MIPS_REG_LO,
+		};
+		for (MIPSGPReg reg : deadbeefRegs)
+			MOV(32, gpr.GetDefaultLocation(reg), Imm32(0xDEADBEEF));
+	}
+	// Everything was flushed, so we can just keep going with the block.
+}
+
 void Jit::Comp_Break(MIPSOpcode op)
 {
 	Comp_Generic(op);
@@ -33,6 +33,7 @@
 #include "Core/MIPS/x86/RegCacheFPU.h"
 
 class PointerWrap;
+struct HLEDirectCall;
 
 namespace MIPSComp {
 
@@ -206,6 +207,7 @@ class Jit : public Gen::XCodeBlock, public JitInterface, public MIPSFrontendInte
 
 //	void WriteRfiExitDestInEAX();
 	void WriteSyscallExit();
+	void CompDirectSyscall(const HLEDirectCall &direct);
 	bool CheckJitBreakpoint(u32 addr, int downcountOffset);
 
 	// Utility compilation functions
@@ -21,6 +21,7 @@
 #include <unordered_set>
 
 #include "Common/MachineContext.h"
+#include "Common/MemoryUtil.h"
 
 #if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
 #include "Common/x64Analyzer.h"
@@ -57,6 +58,16 @@ void MemFault_IgnoreLastCrash() {
 	g_ignoredAddresses.insert(g_lastCrashAddress);
 }
 
+bool DirtyTracking_Supported() {
+	// The Mach exception port is only set up for the emu thread, so writes from other threads
+	// (like the GPU thread) would not be caught on Apple platforms.
+#if defined(MACHINE_CONTEXT_SUPPORTED) && !defined(__APPLE__)
+	return GetMemoryProtectPageSize() <= SCRATCHPAD_SIZE;
+#else
+	return false;
+#endif
+}
+
 #ifdef MACHINE_CONTEXT_SUPPORTED
 
 static bool DisassembleNativeAt(const uint8_t *codePtr, int instructionSize, std::string *dest) {
@@ -86,6 +97,10 @@ bool HandleFault(uintptr_t hostAddress, void *ctx) {
 	SContext *context = (SContext *)ctx;
 	const uint8_t *codePtr = (uint8_t *)(context->CTX_PC);
 
+	// Write tracking faults can come from any code on any thread, just let them through.
+	if (DirtyTracking_HandleFault(hostAddress))
+		return true;
+
 	// We set this later if we think it can be resumed from.
 	g_lastCrashAddress = nullptr;
 
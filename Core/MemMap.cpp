@@ -17,11 +17,15 @@
 
 #include "ppsspp_config.h"
 
-#if PPSSPP_PLATFORM(UWP)
+#ifdef _WIN32
 #include "Common/CommonWindows.h"
+#else
+#include <sys/mman.h>
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <mutex>
 
 #include "Common/Common.h"
@@ -314,7 +318,7 @@ void Reinit() {
 	Core_NotifyLifecycle(CoreLifecycle::MEMORY_REINITED);
 }
 
-void DoState(PointerWrap &p) {
+void DoState(PointerWrap &p, bool includeContents) {
 	auto s = p.Section("Memory", 1, 3);
 	if (!s)
 		return;
@@ -346,17 +350,21 @@ void DoState(PointerWrap &p) {
 		}
 	}
 
-	DoArray(p, GetPointer(PSP_GetKernelMemoryBase()), g_MemorySize);
+	if (!includeContents)
+		return;
+
+	p.DoRegion(GetPointer(PSP_GetKernelMemoryBase()), g_MemorySize);
 	p.DoMarker("RAM");
 
-	DoArray(p, m_pPhysicalVRAM1, VRAM_SIZE);
+	p.DoRegion(m_pPhysicalVRAM1, VRAM_SIZE);
 	p.DoMarker("VRAM");
-	DoArray(p, m_pPhysicalScratchPad, SCRATCHPAD_SIZE);
+	p.DoRegion(m_pPhysicalScratchPad, SCRATCHPAD_SIZE);
 	p.DoMarker("ScratchPad");
 }
 
 void Shutdown() {
 	std::lock_guard<std::recursive_mutex> guard(g_shutdownLock);
+	DirtyTracking_Stop();
 	u32 flags = 0;
 	MemoryMap_Shutdown(flags);
 	base = nullptr;
@@ -376,6 +384,214 @@ bool IsActive() {
 	return base != nullptr;
 }
 
+struct DirtyTrackingView {
+	u8 *ptr;
+	u32 size;
+	u32 firstPage;
+};
+
+static std::vector<DirtyTrackingView> g_dirtyViews;
+static std::unique_ptr<std::atomic<u8>[]> g_dirtyPages;
+static u32 g_dirtyNumPages;
+static u32 g_dirtyPageSize;
+static std::atomic<bool> g_dirtyTracking;
+// Pages the OS is currently writing into (file reads on the IO thread, socket receives.)
+// Protected by g_dirtyLock, and DirtyTracking_Protect leaves these alone.
+static std::unique_ptr<u16[]> g_dirtyPins;
+static std::mutex g_dirtyLock;
+
+// Applies to every view of the pages, clipping the range to each.
+static void DirtyTracking_SetWritable(u32 page, u32 count, bool writable) {
+	const u32 prot = writable ? (MEM_PROT_READ | MEM_PROT_WRITE) : MEM_PROT_READ;
+	for (const DirtyTrackingView &view : g_dirtyViews) {
+		u32 lo = std::max(page, view.firstPage);
+		u32 hi = std::min(page + count, view.firstPage + view.size / g_dirtyPageSize);
+		if (lo < hi)
+			ProtectMemoryPages(view.ptr + (lo - view.firstPage) * g_dirtyPageSize, (hi - lo) * g_dirtyPageSize, prot);
+	}
+}
+
+// Only for the fault handler: no logging, and mprotect is safe in a signal handler.
+static bool DirtyTracking_UnprotectFromFault(u8 *ptr) {
+#if PPSSPP_PLATFORM(UWP)
+	DWORD oldValue;
+	return VirtualProtectFromApp(ptr, g_dirtyPageSize, PAGE_READWRITE, &oldValue) != 0;
+#elif defined(_WIN32)
+	DWORD oldValue;
+	return VirtualProtect(ptr, g_dirtyPageSize, PAGE_READWRITE, &oldValue) != 0;
+#else
+	return mprotect(ptr, g_dirtyPageSize, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+bool DirtyTracking_Start() {
+	std::lock_guard<std::mutex> guard(g_dirtyLock);
+	if (g_dirtyTracking)
+		return true;
+	if (!DirtyTracking_Supported() || !base)
+		return false;
+
+	g_dirtyPageSize = std::max(GetMemoryProtectPageSize(), 4096);
+	g_dirtyViews.clear();
+	u32 numPages = 0;
+	u32 chainFirstPage = 0;
+	for (int i = 0; i < num_views; i++) {
+		const MemoryView &view = views[i];
+		if (view.size == 0 || !*view.out_ptr)
+			continue;
+		// Masked-out mirrors share the pointer of the view before.
+		if (!g_dirtyViews.empty() && g_dirtyViews.back().ptr == *view.out_ptr)
+			continue;
+		_dbg_assert_((view.size % g_dirtyPageSize) == 0);
+		if (!(view.flags & MV_MIRROR_PREVIOUS)) {
+			chainFirstPage = numPages;
+			numPages += view.size / g_dirtyPageSize;
+		}
+		g_dirtyViews.push_back({ *view.out_ptr, view.size, chainFirstPage });
+	}
+
+	g_dirtyNumPages = numPages;
+	g_dirtyPages.reset(new std::atomic<u8>[numPages]);
+	g_dirtyPins.reset(new u16[numPages]);
+	for (u32 i = 0; i < numPages; ++i) {
+		g_dirtyPages[i] = 0;
+		g_dirtyPins[i] = 0;
+	}
+
+	g_dirtyTracking = true;
+	DirtyTracking_SetWritable(0, numPages, false);
+	INFO_LOG(MEMMAP, "Tracking writes to %d pages of %d bytes", numPages, g_dirtyPageSize);
+	return true;
+}
+
+void DirtyTracking_Stop() {
+	std::lock_guard<std::mutex> guard(g_dirtyLock);
+	if (!g_dirtyTracking)
+		return;
+	// Keep the views around, a late fault from another thread may still look at them.
+	DirtyTracking_SetWritable(0, g_dirtyNumPages, true);
+	g_dirtyTracking = false;
+}
+
+bool DirtyTracking_Active() {
+	return g_dirtyTracking;
+}
+
+u32 DirtyTracking_PageSize() {
+	return g_dirtyPageSize;
+}
+
+u32 DirtyTracking_NumPages() {
+	return g_dirtyNumPages;
+}
+
+u8 *DirtyTracking_PagePointer(u32 page) {
+	for (const DirtyTrackingView &view : g_dirtyViews) {
+		if (page >= view.firstPage && page < view.firstPage + view.size / g_dirtyPageSize)
+			return view.ptr + (page - view.firstPage) * g_dirtyPageSize;
+	}
+	return nullptr;
+}
+
+void DirtyTracking_GetDirty(std::vector<u32> *pages) {
+	for (u32 i = 0; i < g_dirtyNumPages; ++i) {
+		if (g_dirtyPages[i])
+			pages->push_back(i);
+	}
+}
+
+void DirtyTracking_Protect(const std::vector<u32> &pages) {
+	std::lock_guard<std::mutex> guard(g_dirtyLock);
+	// Clear first: a write that sneaks in before the protect still ends up in the copy
+	// the caller makes next, and anything after it faults and marks the page again.
+	// Pinned pages stay writable and dirty, the OS would fail the write instead of faulting.
+	for (u32 page : pages) {
+		if (g_dirtyPins[page] == 0)
+			g_dirtyPages[page] = 0;
+	}
+	for (size_t i = 0; i < pages.size(); ) {
+		if (g_dirtyPins[pages[i]] != 0) {
+			++i;
+			continue;
+		}
+		size_t end = i + 1;
+		while (end < pages.size() && pages[end] == pages[end - 1] + 1 && g_dirtyPins[pages[end]] == 0)
+			++end;
+		DirtyTracking_SetWritable(pages[i], (u32)(end - i), false);
+		i = end;
+	}
+}
+
+void DirtyTracking_MarkDirty(const std::vector<u32> &pages) {
+	std::lock_guard<std::mutex> guard(g_dirtyLock);
+	for (u32 page : pages) {
+		if (!g_dirtyPages[page]) {
+			DirtyTracking_SetWritable(page, 1, true);
+			g_dirtyPages[page] = 1;
+		}
+	}
+}
+
+static void DirtyTracking_PinHostWrite(const void *ptr, size_t size, bool pin) {
+	uintptr_t start = (uintptr_t)ptr;
+	for (const DirtyTrackingView &view : g_dirtyViews) {
+		uintptr_t viewStart = (uintptr_t)view.ptr;
+		uintptr_t lo = std::max(start, viewStart);
+		uintptr_t hi = std::min(start + size, viewStart + view.size);
+		if (lo >= hi)
+			continue;
+		u32 first = view.firstPage + (u32)((lo - viewStart) / g_dirtyPageSize);
+		u32 last = view.firstPage + (u32)((hi - 1 - viewStart) / g_dirtyPageSize);
+		for (u32 page = first; page <= last; ++page) {
+			if (!pin) {
+				if (g_dirtyPins[page] != 0)
+					g_dirtyPins[page]--;
+				continue;
+			}
+			g_dirtyPins[page]++;
+			if (!g_dirtyPages[page]) {
+				DirtyTracking_SetWritable(page, 1, true);
+				g_dirtyPages[page] = 1;
+			}
+		}
+	}
+}
+
+void DirtyTracking_BeginHostWrite(const void *ptr, size_t size) {
+	if (!g_dirtyTracking || size == 0)
+		return;
+	std::lock_guard<std::mutex> guard(g_dirtyLock);
+	if (g_dirtyTracking)
+		DirtyTracking_PinHostWrite(ptr, size, true);
+}
+
+void DirtyTracking_EndHostWrite(const void *ptr, size_t size) {
+	if (!g_dirtyTracking || size == 0)
+		return;
+	std::lock_guard<std::mutex> guard(g_dirtyLock);
+	if (g_dirtyTracking)
+		DirtyTracking_PinHostWrite(ptr, size, false);
+}
+
+bool DirtyTracking_HandleFault(uintptr_t hostAddress) {
+	if (!g_dirtyTracking)
+		return false;
+	for (const DirtyTrackingView &view : g_dirtyViews) {
+		uintptr_t viewStart = (uintptr_t)view.ptr;
+		if (hostAddress >= viewStart && hostAddress < viewStart + view.size) {
+			u32 page = view.firstPage + (u32)((hostAddress - viewStart) / g_dirtyPageSize);
+			// Unprotect before flagging, so a concurrent DirtyTracking_Protect can't leave
+			// the page writable without the flag.  Mirrors fault on their own.
+			u8 *pagePtr = view.ptr + (page - view.firstPage) * g_dirtyPageSize;
+			if (!DirtyTracking_UnprotectFromFault(pagePtr))
+				return false;
+			g_dirtyPages[page] = 1;
+			return true;
+		}
+	}
+	return false;
+}
+
 // Wanting to avoid include pollution, MemMap.h is included a lot.
 MemoryInitedLock::MemoryInitedLock()
 {
@@ -21,6 +21,7 @@
 
 #include <cstring>
 #include <cstdint>
+#include <vector>
 #ifndef offsetof
 #include <stddef.h>
 #endif
@@ -128,11 +129,51 @@ void MemoryMap_Shutdown(u32 flags);
 // Init and Shutdown
 bool Init();
 void Shutdown();
-void DoState(PointerWrap &p);
+// Without contents, only the layout is saved and RAM, VRAM and scratchpad are left alone.
+void DoState(PointerWrap &p, bool includeContents = true);
 void Clear();
 // False when shutdown has already been called.
 bool IsActive();
 
+// Write tracking, used for incremental rewind snapshots.  While active, RAM, VRAM and
+// scratchpad are write protected in all views, and the first write to a page is caught by
+// the fault handler, which marks the page dirty and lets the write through.
+// Pages are numbered across all three areas, in the order of the views.
+bool DirtyTracking_Supported();
+bool DirtyTracking_Start();
+void DirtyTracking_Stop();
+bool DirtyTracking_Active();
+u32 DirtyTracking_PageSize();
+u32 DirtyTracking_NumPages();
+u8 *DirtyTracking_PagePointer(u32 page);
+// Appends the pages written since they were last protected, in ascending order.
+void DirtyTracking_GetDirty(std::vector<u32> *pages);
+// Clears the dirty flag on the pages (which must be sorted) and write protects them again.
+void DirtyTracking_Protect(const std::vector<u32> &pages);
+// Makes the pages writable and marks them dirty.
+void DirtyTracking_MarkDirty(const std::vector<u32> &pages);
+// Writes by the OS itself (like file or socket reads) fail instead of faulting.
+// Wrap passing PSP memory to such a call in these (or use DirtyTrackingHostWrite), which
+// keep the pages writable until the write is done, even if a snapshot is taken meanwhile.
+void DirtyTracking_BeginHostWrite(const void *ptr, size_t size);
+void DirtyTracking_EndHostWrite(const void *ptr, size_t size);
+// Called from the fault handler.  Returns true if the fault was a write to a protected page.
+bool DirtyTracking_HandleFault(uintptr_t hostAddress);
+
+class DirtyTrackingHostWrite {
+public:
+	DirtyTrackingHostWrite(const void *ptr, size_t size) : ptr_(ptr), size_(size) {
+		DirtyTracking_BeginHostWrite(ptr, size);
+	}
+	~DirtyTrackingHostWrite() {
+		DirtyTracking_EndHostWrite(ptr_, size_);
+	}
+
+private:
+	const void *ptr_;
+	size_t size_;
+};
+
 class MemoryInitedLock {
 public:
 	MemoryInitedLock();
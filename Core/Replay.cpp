@@ -17,15 +17,20 @@
 
 #include <cstring>
 #include <ctime>
+#include <thread>
 #include <vector>
 
 #include "Common/Common.h"
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
+#include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
+#include "Core/CoreTiming.h"
 #include "Core/Replay.h"
+#include "Core/SaveState.h"
 #include "Core/FileSystems/FileSystem.h"
 #include "Core/HLE/sceCtrl.h"
+#include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceKernelTime.h"
 #include "Core/HLE/sceRtc.h"
 
@@ -46,13 +51,17 @@ enum class ReplayState {
 // appended to the file as they occur.  It is usually near, and always less than:
 //
 // (fileSize - sizeof(ReplayFileHeader)) / sizeof(ReplayItemHeader)
+//
+// Since version 2, KEYFRAME events are recorded periodically.  Their side data is a
+// ReplayKeyframeHeader followed by a chunk compressed savestate.  Item headers can be
+// walked without touching side data, so the keyframe index is built when loading.
 
 // File data formats below.
 #pragma pack(push, 1)
 
 static const char *REPLAY_MAGIC = "PPREPLAY";
 static const int REPLAY_VERSION_MIN = 1;
-static const int REPLAY_VERSION_CURRENT = 1;
+static const int REPLAY_VERSION_CURRENT = 2;
 
 struct ReplayFileHeader {
 	char magic[8];
@@ -91,6 +100,11 @@ struct ReplayItemHeader {
 	}
 };
 
+struct ReplayKeyframeHeader {
+	u32_le frame;
+	u32_le reserved;
+};
+
 static const int REPLAY_MAX_FILENAME = 256;
 
 struct ReplayFileInfo {
@@ -129,6 +143,37 @@ static uint8_t lastAnalog[2][2]{};
 static size_t replayDiskPos = 0;
 static bool diskFailed = false;
 
+struct ReplayKeyframe {
+	size_t itemIndex;
+	int frame;
+};
+
+// Index of the keyframes in replayItems, in order.
+static std::vector<ReplayKeyframe> replayKeyframes;
+static int replayKeyframeInterval = 1800;
+static int lastKeyframeFrame = -1;
+
+// While recording, keyframes are compressed on a thread and filled into their item later.
+static std::thread keyframeThread;
+static std::vector<u8> keyframeCompressed;
+static size_t keyframePendingIndex = 0;
+static bool keyframePending = false;
+// Buffered keyframe items, thinned out (and spaced further apart) when there are too many.
+static const size_t REPLAY_MAX_BUFFERED_KEYFRAMES = 16;
+static std::vector<size_t> keyframeSaveIndexes;
+static int keyframeSpacing = 1;
+
+static void ReplayIndexKeyframes() {
+	replayKeyframes.clear();
+	for (size_t i = 0; i < replayItems.size(); ++i) {
+		const ReplayItem &item = replayItems[i];
+		if (item.info.action != ReplayAction::KEYFRAME || item.data.size() < sizeof(ReplayKeyframeHeader))
+			continue;
+		const ReplayKeyframeHeader *kh = (const ReplayKeyframeHeader *)&item.data[0];
+		replayKeyframes.push_back({ i, (int)kh->frame });
+	}
+}
+
 void ReplayExecuteBlob(const std::vector<u8> &data) {
 	ReplayAbort();
 
@@ -158,8 +203,9 @@ void ReplayExecuteBlob(const std::vector<u8> &data) {
 		replayItems.push_back(item);
 	}
 
+	ReplayIndexKeyframes();
 	replayState = ReplayState::EXECUTE;
-	INFO_LOG(SYSTEM, "Executing replay with %lld items", (long long)replayItems.size());
+	INFO_LOG(SYSTEM, "Executing replay with %lld items, %d keyframes", (long long)replayItems.size(), (int)replayKeyframes.size());
 }
 
 bool ReplayExecuteFile(const std::string &filename) {
@@ -223,7 +269,164 @@ bool ReplayHasMoreEvents() {
 	return replayExecPos < replayItems.size();
 }
 
+int ReplayKeyframeCount() {
+	return (int)replayKeyframes.size();
+}
+
+static bool ReplayKeyframeState(const ReplayKeyframe &keyframe, std::vector<u8> *state) {
+	const ReplayItem &item = replayItems[keyframe.itemIndex];
+	const size_t headerSize = sizeof(ReplayKeyframeHeader);
+	if (!CChunkFileReader::DecompressChunks(&item.data[headerSize], item.data.size() - headerSize, state)) {
+		ERROR_LOG(SYSTEM, "Replay keyframe at frame %d is corrupt", keyframe.frame);
+		return false;
+	}
+	return true;
+}
+
+bool ReplayGetKeyframe(int index, int *frame, std::vector<u8> *state) {
+	if (replayState != ReplayState::EXECUTE || index < 0 || index >= (int)replayKeyframes.size())
+		return false;
+	*frame = replayKeyframes[index].frame;
+	return ReplayKeyframeState(replayKeyframes[index], state);
+}
+
+int ReplaySeekFrame(int frame) {
+	if (replayState != ReplayState::EXECUTE)
+		return -1;
+
+	const ReplayKeyframe *keyframe = nullptr;
+	for (const ReplayKeyframe &kf : replayKeyframes) {
+		if (kf.frame > frame)
+			break;
+		keyframe = &kf;
+	}
+	if (!keyframe)
+		return -1;
+
+	std::vector<u8> state;
+	if (!ReplayKeyframeState(*keyframe, &state))
+		return -1;
+
+	std::string errorString;
+	if (SaveState::LoadFromRam(state, &errorString) != CChunkFileReader::ERROR_NONE) {
+		ERROR_LOG(SYSTEM, "Could not load replay keyframe at frame %d: %s", keyframe->frame, errorString.c_str());
+		return -1;
+	}
+
+	// Everything before the keyframe has already happened in the loaded state.
+	replayCtrlPos = keyframe->itemIndex + 1;
+	replayDiskPos = keyframe->itemIndex + 1;
+	replayExecPos = keyframe->itemIndex + 1;
+	diskFailed = false;
+
+	// The last input before the keyframe is still held.
+	bool foundButtons = false;
+	bool foundAnalog = false;
+	lastButtons = 0;
+	memset(lastAnalog, 0, sizeof(lastAnalog));
+	for (size_t i = keyframe->itemIndex; i > 0 && (!foundButtons || !foundAnalog); --i) {
+		const ReplayItem &prev = replayItems[i - 1];
+		if (prev.info.action == ReplayAction::BUTTONS && !foundButtons) {
+			lastButtons = prev.info.buttons;
+			foundButtons = true;
+		} else if (prev.info.action == ReplayAction::ANALOG && !foundAnalog) {
+			memcpy(lastAnalog, prev.info.analog, sizeof(lastAnalog));
+			foundAnalog = true;
+		}
+	}
+
+	INFO_LOG(SYSTEM, "Replay seeked to keyframe at frame %d", keyframe->frame);
+	return keyframe->frame;
+}
+
+void ReplaySetKeyframeInterval(int frames) {
+	replayKeyframeInterval = frames;
+}
+
+// Waits for the keyframe being compressed, and fills in its item.
+static void ReplayFinishKeyframe() {
+	if (keyframeThread.joinable())
+		keyframeThread.join();
+	if (!keyframePending)
+		return;
+	keyframePending = false;
+
+	// The items may have been discarded in the meantime.
+	if (keyframePendingIndex < replayItems.size()) {
+		ReplayItem &item = replayItems[keyframePendingIndex];
+		item.data.resize(sizeof(ReplayKeyframeHeader) + keyframeCompressed.size());
+		if (!keyframeCompressed.empty())
+			memcpy(&item.data[sizeof(ReplayKeyframeHeader)], &keyframeCompressed[0], keyframeCompressed.size());
+		item.info.size = (u32)item.data.size();
+	}
+	keyframeCompressed.clear();
+}
+
+// Drops every other buffered keyframe, keeping the newest.  Dropped ones stay as empty items.
+static void ReplayThinKeyframes() {
+	size_t kept = 0;
+	size_t count = keyframeSaveIndexes.size();
+	for (size_t i = 0; i < count; ++i) {
+		if (((count - 1 - i) & 1) == 0) {
+			keyframeSaveIndexes[kept++] = keyframeSaveIndexes[i];
+			continue;
+		}
+		ReplayItem &item = replayItems[keyframeSaveIndexes[i]];
+		item.data.clear();
+		item.data.shrink_to_fit();
+		item.info.size = 0;
+	}
+	keyframeSaveIndexes.resize(kept);
+	keyframeSpacing *= 2;
+	DEBUG_LOG(SYSTEM, "Thinned replay keyframes, now every %d frames", replayKeyframeInterval * keyframeSpacing);
+}
+
+void ReplaySaveKeyframe(int frame, std::vector<u8> &&state) {
+	if (replayState != ReplayState::SAVE)
+		return;
+	ReplayFinishKeyframe();
+
+	// The frame goes in now, the compressed state when it's ready.
+	ReplayItem item(ReplayItemHeader(ReplayAction::KEYFRAME, CoreTiming::GetGlobalTimeUs()));
+	item.data.resize(sizeof(ReplayKeyframeHeader));
+	ReplayKeyframeHeader kh{};
+	kh.frame = frame;
+	memcpy(&item.data[0], &kh, sizeof(kh));
+	item.info.size = (u32)item.data.size();
+
+	keyframePendingIndex = replayItems.size();
+	keyframePending = true;
+	replayItems.push_back(item);
+
+	keyframeSaveIndexes.push_back(keyframePendingIndex);
+	if (keyframeSaveIndexes.size() > REPLAY_MAX_BUFFERED_KEYFRAMES)
+		ReplayThinKeyframes();
+
+	keyframeThread = std::thread([](std::vector<u8> state) {
+		CChunkFileReader::CompressChunks(&state[0], state.size(), CChunkFileReader::Compression::DENSE, &keyframeCompressed);
+	}, std::move(state));
+}
+
+void ReplayProcessFrame() {
+	if (replayState != ReplayState::SAVE || replayKeyframeInterval <= 0)
+		return;
+
+	int frame = __DisplayGetNumVblanks();
+	if (lastKeyframeFrame >= 0 && frame - lastKeyframeFrame < replayKeyframeInterval * keyframeSpacing)
+		return;
+	lastKeyframeFrame = frame;
+
+	// Only the save has to happen between frames, compression runs alongside emulation.
+	std::vector<u8> state;
+	if (SaveState::SaveToRam(state) != CChunkFileReader::ERROR_NONE) {
+		ERROR_LOG(SYSTEM, "Could not save replay keyframe at frame %d", frame);
+		return;
+	}
+	ReplaySaveKeyframe(frame, std::move(state));
+}
+
 void ReplayBeginSave() {
+	ReplayFinishKeyframe();
 	if (replayState != ReplayState::EXECUTE) {
 		// Restart any save operation.
 		ReplayAbort();
@@ -237,6 +440,8 @@ void ReplayBeginSave() {
 }
 
 void ReplayFlushBlob(std::vector<u8> *data) {
+	ReplayFinishKeyframe();
+
 	size_t sz = replayItems.size() * sizeof(ReplayItemHeader);
 	// Add in any side data.
 	for (const auto &item : replayItems) {
@@ -252,7 +457,7 @@ void ReplayFlushBlob(std::vector<u8> *data) {
 		memcpy(&(*data)[pos], &item.info, sizeof(item.info));
 		pos += sizeof(item.info);
 
-		if ((int)item.info.action & (int)ReplayAction::MASK_SIDEDATA) {
+		if (((int)item.info.action & (int)ReplayAction::MASK_SIDEDATA) && !item.data.empty()) {
 			memcpy(&(*data)[pos], &item.data[0], item.data.size());
 			pos += item.data.size();
 		}
@@ -260,6 +465,8 @@ void ReplayFlushBlob(std::vector<u8> *data) {
 
 	// Keep recording, but throw away our buffered items.
 	replayItems.clear();
+	keyframeSaveIndexes.clear();
+	keyframeSpacing = 1;
 }
 
 bool ReplayFlushFile(const std::string &filename) {
@@ -298,6 +505,7 @@ bool ReplayFlushFile(const std::string &filename) {
 }
 
 void ReplayAbort() {
+	ReplayFinishKeyframe();
 	replayItems.clear();
 	replayExecPos = 0;
 	replaySaveWroteHeader = false;
@@ -310,6 +518,11 @@ void ReplayAbort() {
 
 	replayDiskPos = 0;
 	diskFailed = false;
+
+	replayKeyframes.clear();
+	lastKeyframeFrame = -1;
+	keyframeSaveIndexes.clear();
+	keyframeSpacing = 1;
 }
 
 static void ReplaySaveCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t) {
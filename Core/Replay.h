@@ -40,6 +40,9 @@ enum class ReplayAction : uint8_t {
 	RMDIR = 0x48,
 	FREESPACE = 0x49,
 
+	// A compressed savestate taken at a frame boundary, for seeking.
+	KEYFRAME = 0x82,
+
 	MASK_FILE = 0x40,
 	MASK_SIDEDATA = 0x80,
 };
@@ -52,6 +55,14 @@ void ReplayExecuteBlob(const std::vector<u8> &data);
 bool ReplayExecuteFile(const std::string &filename);
 // Returns whether there are unexected events to replay.
 bool ReplayHasMoreEvents();
+// Jumps to the last keyframe at or before the frame (vblank count) while executing.
+// Returns the keyframe's frame, or -1 if there's none and the replay must run from boot.
+// Only call between frames on the emu thread.
+int ReplaySeekFrame(int frame);
+// Number of keyframes in the replay being executed.
+int ReplayKeyframeCount();
+// Gets a keyframe's frame and decompressed savestate from the replay being executed.
+bool ReplayGetKeyframe(int index, int *frame, std::vector<u8> *state);
 
 // Begin recording.  If currently executing, discards unexecuted events.
 void ReplayBeginSave();
@@ -65,6 +76,13 @@ bool ReplayFlushFile(const std::string &filename);
 // Abort any execute or record operation in progress.
 void ReplayAbort();
 
+// While recording, a keyframe is saved every this many frames (vblanks.)  0 disables them.
+void ReplaySetKeyframeInterval(int frames);
+// Called at frame boundaries, from SaveState::Process().
+void ReplayProcessFrame();
+// Records a keyframe from a savestate taken at the frame.  Compression happens on a thread.
+void ReplaySaveKeyframe(int frame, std::vector<u8> &&state);
+
 void ReplayApplyCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t);
 uint32_t ReplayApplyDisk(ReplayAction action, uint32_t result, uint64_t t);
 uint64_t ReplayApplyDisk64(ReplayAction action, uint64_t result, uint64_t t);
@@ -16,6 +16,8 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <functional>
+#include <map>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -35,6 +37,7 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/Host.h"
+#include "Core/Replay.h"
 #include "Core/Screenshot.h"
 #include "Core/System.h"
 #include "Core/FileSystems/MetaFileSystem.h"
@@ -42,6 +45,7 @@
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/ReplaceTables.h"
+#include "Core/HLE/sceAtrac.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/MemMap.h"
@@ -60,6 +64,19 @@ namespace SaveState
 	struct SaveStart
 	{
 		void DoState(PointerWrap &p);
+
+		// If set, RAM, VRAM and scratchpad are left out of the state and this takes care of them,
+		// at the point they would have been saved or loaded (so with emuhacks cleared.)
+		std::function<void(PointerWrap &p)> trackedMemory;
+
+		// When saving with p.regions, RAM is only referenced and has to stay free of emuhacks
+		// and replacements until the file is written.  This puts them back afterward.
+		void FinishSave();
+
+	private:
+		bool restorePending_ = false;
+		std::vector<u32> savedBlocks_;
+		std::map<u32, u32> savedReplacements_;
 	};
 
 	enum OperationType
@@ -105,11 +122,20 @@ namespace SaveState
 		{
 			states_.resize(size);
 			baseMapping_.resize(size);
+			undo_.resize(size);
+			tracked_ = Memory::DirtyTracking_Supported();
+		}
+
+		bool TracksWrites() const
+		{
+			return tracked_;
 		}
 
 		CChunkFileReader::Error Save()
 		{
 			std::lock_guard<std::mutex> guard(lock_);
+			if (tracked_)
+				return SaveTracked();
 
 			int n = next_++ % size_;
 			if ((next_ % size_) == first_)
@@ -145,13 +171,16 @@ namespace SaveState
 			// No valid states left.
 			if (Empty())
 				return CChunkFileReader::ERROR_BAD_FILE;
+			if (tracked_)
+				return RestoreTracked(errorString);
 
 			int n = (--next_ + size_) % size_;
 			if (states_[n].empty())
 				return CChunkFileReader::ERROR_BAD_FILE;
 
 			static std::vector<u8> buffer;
-			LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]);
+			if (!LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]))
+				return CChunkFileReader::ERROR_BROKEN_STATE;
 			return LoadFromRam(buffer, errorString);
 		}
 
@@ -172,23 +201,29 @@ namespace SaveState
 			if (first_ == 0 && next_ == 0)
 				return;
 
-			result.clear();
+			StateBuffer &diff = compressDiff_;
+			diff.clear();
 			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
 			{
 				int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
 				if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0)
 				{
-					result.push_back(1);
-					result.insert(result.end(), state.begin() + i, state.begin() +i + blockSize);
+					diff.push_back(1);
+					diff.insert(diff.end(), state.begin() + i, state.begin() +i + blockSize);
 				}
 				else
-					result.push_back(0);
+					diff.push_back(0);
 			}
+			CChunkFileReader::CompressChunks(&diff[0], diff.size(), CChunkFileReader::Compression::FAST, &result);
 		}
 
-		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
+		bool LockedDecompress(std::vector<u8> &result, const std::vector<u8> &chunks, const std::vector<u8> &base)
 		{
+			StateBuffer &compressed = decompressBuffer_;
 			result.clear();
+			if (!CChunkFileReader::DecompressChunks(&chunks[0], chunks.size(), &compressed))
+				return false;
+
 			result.reserve(base.size());
 			auto basePos = base.begin();
 			for (size_t i = 0; i < compressed.size(); )
@@ -209,6 +244,126 @@ namespace SaveState
 					basePos += blockSize;
 				}
 			}
+			return !result.empty();
+		}
+
+		// With write tracking, memory stays out of the states.  shadow_ is memory as of the newest
+		// state, and each state keeps the previous contents of the pages that changed after it.
+		// A snapshot then only looks at the pages written since the last one.
+		// Here first_ and next_ simply count, the ring holds [first_, next_).
+		CChunkFileReader::Error SaveTracked()
+		{
+			const bool fresh = !Memory::DirtyTracking_Active();
+			if (fresh) {
+				// Either the first snapshot, or tracking was stopped and older states are useless.
+				ClearTracked();
+				if (!Memory::DirtyTracking_Start())
+					return CChunkFileReader::ERROR_BAD_FILE;
+				shadow_.resize((size_t)Memory::DirtyTracking_NumPages() * Memory::DirtyTracking_PageSize());
+			}
+
+			int prev = Empty() ? -1 : (next_ - 1) % size_;
+			if (next_ - first_ == size_)
+				++first_;
+			int n = next_++ % size_;
+			undo_[n].clear();
+
+			SaveStart state;
+			state.trackedMemory = [&](PointerWrap &p) {
+				const u32 pageSize = Memory::DirtyTracking_PageSize();
+				if (fresh) {
+					for (u32 page = 0; page < Memory::DirtyTracking_NumPages(); ++page)
+						memcpy(&shadow_[(size_t)page * pageSize], Memory::DirtyTracking_PagePointer(page), pageSize);
+					return;
+				}
+
+				dirty_.clear();
+				Memory::DirtyTracking_GetDirty(&dirty_);
+				Memory::DirtyTracking_Protect(dirty_);
+				for (u32 page : dirty_) {
+					u8 *shadowPage = &shadow_[(size_t)page * pageSize];
+					const u8 *livePage = Memory::DirtyTracking_PagePointer(page);
+					// Pages only touched by emuhacks come back clean here, no need to keep them.
+					if (memcmp(shadowPage, livePage, pageSize) == 0)
+						continue;
+					if (prev != -1) {
+						undo_[prev].pages.push_back(page);
+						undo_[prev].data.insert(undo_[prev].data.end(), shadowPage, shadowPage + pageSize);
+					}
+					memcpy(shadowPage, livePage, pageSize);
+				}
+			};
+
+			size_t sz = CChunkFileReader::MeasurePtr(state);
+			states_[n].resize(sz);
+			CChunkFileReader::Error err = CChunkFileReader::SavePtr(&states_[n][0], state);
+			if (err != CChunkFileReader::ERROR_NONE)
+				states_[n].clear();
+			return err;
+		}
+
+		CChunkFileReader::Error RestoreTracked(std::string *errorString)
+		{
+			if (!Memory::DirtyTracking_Active()) {
+				ClearTracked();
+				return CChunkFileReader::ERROR_BAD_FILE;
+			}
+
+			int n = --next_ % size_;
+			int prev = Empty() ? -1 : (next_ - 1) % size_;
+			bool memoryDone = false;
+
+			// Takes memory back to shadow_, then moves shadow_ back one state.
+			auto restoreMemory = [&]() {
+				memoryDone = true;
+				const u32 pageSize = Memory::DirtyTracking_PageSize();
+				dirty_.clear();
+				Memory::DirtyTracking_GetDirty(&dirty_);
+				for (u32 page : dirty_)
+					memcpy(Memory::DirtyTracking_PagePointer(page), &shadow_[(size_t)page * pageSize], pageSize);
+				Memory::DirtyTracking_Protect(dirty_);
+
+				if (prev == -1)
+					return;
+				PageUndo &undo = undo_[prev];
+				for (size_t i = 0; i < undo.pages.size(); ++i)
+					memcpy(&shadow_[(size_t)undo.pages[i] * pageSize], &undo.data[i * pageSize], pageSize);
+				// Memory is still at this state, so those pages now differ from shadow_.
+				std::sort(undo.pages.begin(), undo.pages.end());
+				Memory::DirtyTracking_MarkDirty(undo.pages);
+				undo.clear();
+			};
+
+			SaveStart state;
+			state.trackedMemory = [&](PointerWrap &p) {
+				if (!Memory::DirtyTracking_Active()) {
+					// Memory was reinitialized with a different size, nothing to restore into.
+					p.SetError(PointerWrap::ERROR_FAILURE);
+					return;
+				}
+				restoreMemory();
+			};
+
+			CChunkFileReader::Error err;
+			if (states_[n].empty())
+				err = CChunkFileReader::ERROR_BAD_FILE;
+			else
+				err = CChunkFileReader::LoadPtr(&states_[n][0], state, errorString);
+			// Even if the state was broken, keep shadow_ in line with the ring.
+			if (!memoryDone && Memory::DirtyTracking_Active())
+				restoreMemory();
+			return err;
+		}
+
+		void ClearTracked()
+		{
+			Memory::DirtyTracking_Stop();
+			first_ = 0;
+			next_ = 0;
+			for (PageUndo &undo : undo_)
+				undo.clear();
+			shadow_.clear();
+			shadow_.shrink_to_fit();
 		}
 
 		void Clear()
@@ -218,6 +373,8 @@ namespace SaveState
 
 			// This lock is mainly for shutdown.
 			std::lock_guard<std::mutex> guard(lock_);
+			if (tracked_)
+				ClearTracked();
 			first_ = 0;
 			next_ = 0;
 		}
@@ -233,6 +390,16 @@ namespace SaveState
 
 		typedef std::vector<u8> StateBuffer;
 
+		struct PageUndo {
+			std::vector<u32> pages;
+			std::vector<u8> data;
+
+			void clear() {
+				pages.clear();
+				data.clear();
+			}
+		};
+
 		int first_;
 		int next_;
 		int size_;
@@ -242,9 +409,17 @@ namespace SaveState
 		std::vector<int> baseMapping_;
 		std::mutex lock_;
 		std::thread compressThread_;
+		// Scratch for Compress and LockedDecompress, both used under lock_.
+		StateBuffer compressDiff_;
+		StateBuffer decompressBuffer_;
 
 		int base_;
 		int baseUsage_;
+
+		bool tracked_;
+		std::vector<PageUndo> undo_;
+		std::vector<u8> shadow_;
+		std::vector<u32> dirty_;
 	};
 
 	static bool needsProcess = false;
@@ -264,6 +439,8 @@ namespace SaveState
 	static StateRingbuffer rewindStates(REWIND_NUM_STATES);
 	// TODO: Any reason for this to be configurable?
 	const static float rewindMaxWallFrequency = 1.0f;
+	// Snapshots with write tracking are cheap enough to take more often.
+	const static float rewindMaxWallFrequencyTracked = 0.25f;
 	static double rewindLastTime = 0.0f;
 	const int StateRingbuffer::BLOCK_SIZE = 8192;
 	const int StateRingbuffer::BASE_USAGE_INTERVAL = 15;
@@ -286,21 +463,40 @@ namespace SaveState
 			saveStateGeneration = 1;
 		}
 
+		// A queued atrac decode would write RAM and kernel state after those were serialized or loaded.
+		if (p.mode == p.MODE_READ)
+			__AtracDiscardAsyncDecode();
+		else
+			__AtracFinishAsyncDecode();
+
 		// Gotta do CoreTiming first since we'll restore into it.
 		CoreTiming::DoState(p);
 
+		auto doMemory = [&] {
+			if (trackedMemory) {
+				Memory::DoState(p, false);
+				if (p.mode == p.MODE_READ || p.mode == p.MODE_WRITE)
+					trackedMemory(p);
+			} else {
+				Memory::DoState(p);
+			}
+		};
+
 		// Memory is a bit tricky when jit is enabled, since there's emuhacks in it.
 		auto savedReplacements = SaveAndClearReplacements();
+		std::vector<u32> savedBlocks;
 		if (MIPSComp::jit && p.mode == p.MODE_WRITE)
-		{
-			std::vector<u32> savedBlocks;
 			savedBlocks = MIPSComp::jit->SaveAndClearEmuHackOps();
-			Memory::DoState(p);
-			MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
+		doMemory();
+		if (p.mode == p.MODE_WRITE && p.regions) {
+			savedBlocks_ = std::move(savedBlocks);
+			savedReplacements_ = std::move(savedReplacements);
+			restorePending_ = true;
+		} else {
+			if (MIPSComp::jit && p.mode == p.MODE_WRITE)
+				MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
+			RestoreSavedReplacements(savedReplacements);
 		}
-		else
-			Memory::DoState(p);
-		RestoreSavedReplacements(savedReplacements);
 
 		MemoryStick_DoState(p);
 		currentMIPS->DoState(p);
@@ -310,6 +506,17 @@ namespace SaveState
 		pspFileSystem.DoState(p);
 	}
 
+	void SaveStart::FinishSave() {
+		if (!restorePending_)
+			return;
+		if (MIPSComp::jit)
+			MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks_);
+		RestoreSavedReplacements(savedReplacements_);
+		savedBlocks_.clear();
+		savedReplacements_.clear();
+		restorePending_ = false;
+	}
+
 	void Enqueue(SaveState::Operation op)
 	{
 		std::lock_guard<std::mutex> guard(mutex);
@@ -684,7 +891,7 @@ namespace SaveState
 		// For fast-forwarding, otherwise they may be useless and too close.
 		double now = time_now_d();
 		float diff = now - rewindLastTime;
-		if (diff < rewindMaxWallFrequency)
+		if (diff < (rewindStates.TracksWrites() ? rewindMaxWallFrequencyTracked : rewindMaxWallFrequency))
 			return;
 
 		rewindLastTime = now;
@@ -719,6 +926,11 @@ namespace SaveState
 	{
 		if (g_Config.iRewindFlipFrequency != 0 && gpuStats.numFlips != 0)
 			CheckRewindState();
+		else if (g_Config.iRewindFlipFrequency == 0 && Memory::DirtyTracking_Active())
+			rewindStates.Clear();
+
+		if (__KernelIsRunning())
+			ReplayProcessFrame();
 
 		if (!needsProcess)
 			return;
@@ -808,7 +1020,13 @@ namespace SaveState
 					std::size_t lslash = title.find_last_of("/");
 					title = title.substr(lslash + 1);
 				}
-				result = CChunkFileReader::Save(op.filename, title, PPSSPP_GIT_VERSION, state);
+				{
+					// RAM is compressed in place, so it can't change until the file is written.  This thread
+					// is busy saving, and debugger threads only write memory while holding this lock.
+					auto memLock = Memory::Lock();
+					result = CChunkFileReader::Save(op.filename, title, PPSSPP_GIT_VERSION, state, CChunkFileReader::Compression::DENSE);
+					state.FinishSave();
+				}
 				if (result == CChunkFileReader::ERROR_NONE) {
 					callbackMessage = slot_prefix + sc->T("Saved State");
 					callbackResult = Status::SUCCESS;
@@ -334,6 +334,8 @@ PSP_LoadingLock::~PSP_LoadingLock() {
 }
 
 void CPU_Shutdown() {
+	// Protected pages would crash without the handler.
+	Memory::DirtyTracking_Stop();
 	UninstallExceptionHandler();
 
 	// Since we load on a background thread, wait for startup to complete.
@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "Core/WaveFile.h"
@@ -102,3 +104,70 @@ void WaveFileWriter::AddStereoSamples(const short* sample_data, uint32_t count)
 	file.WriteBytes(sample_data, count * 4);
 	audio_size += count * 4;
 }
+
+bool ReadWaveFile(const std::string& filename, std::vector<short>* samples, unsigned int* sample_rate)
+{
+	File::IOFile file(filename, "rb");
+	if (!file)
+	{
+		ERROR_LOG(IO, "The file %s could not be opened for reading.", filename.c_str());
+		return false;
+	}
+
+	char id[4];
+	uint32_t size = 0;
+	if (!file.ReadBytes(id, 4) || memcmp(id, "RIFF", 4) != 0 || !file.ReadArray(&size, 1) || !file.ReadBytes(id, 4) || memcmp(id, "WAVE", 4) != 0)
+	{
+		ERROR_LOG(IO, "%s is not a wave file.", filename.c_str());
+		return false;
+	}
+
+	uint16_t channels = 0;
+	uint16_t bits = 0;
+	*sample_rate = 0;
+	while (file.ReadBytes(id, 4) && file.ReadArray(&size, 1))
+	{
+		if (!memcmp(id, "fmt ", 4) && size >= 16)
+		{
+			uint16_t format = 0;
+			uint32_t byte_rate = 0;
+			uint16_t block_align = 0;
+			file.ReadArray(&format, 1);
+			file.ReadArray(&channels, 1);
+			file.ReadArray(sample_rate, 1);
+			file.ReadArray(&byte_rate, 1);
+			file.ReadArray(&block_align, 1);
+			file.ReadArray(&bits, 1);
+			if (format != 1 || bits != 16 || (channels != 1 && channels != 2))
+			{
+				ERROR_LOG(IO, "%s: only 16-bit mono or stereo PCM is supported.", filename.c_str());
+				return false;
+			}
+			file.Seek(size - 16 + (size & 1), SEEK_CUR);
+		}
+		else if (!memcmp(id, "data", 4) && channels != 0)
+		{
+			// The writer above leaves a large placeholder size if not stopped, so clamp to the file.
+			uint64_t remaining = file.GetSize() - file.Tell();
+			uint32_t frames = (uint32_t)(std::min((uint64_t)size, remaining) / (2 * channels));
+			std::vector<short> data(frames * channels);
+			if (!file.ReadArray(data.data(), data.size()))
+				return false;
+
+			samples->resize(frames * 2);
+			for (uint32_t i = 0; i < frames; i++)
+			{
+				(*samples)[i * 2] = data[i * channels];
+				(*samples)[i * 2 + 1] = data[i * channels + channels - 1];
+			}
+			return true;
+		}
+		else
+		{
+			file.Seek(size + (size & 1), SEEK_CUR);
+		}
+	}
+
+	ERROR_LOG(IO, "%s: no sample data found.", filename.c_str());
+	return false;
+}
@@ -14,6 +14,7 @@
 
 #include <array>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 #include "Common/File/FileUtil.h"
@@ -40,3 +41,7 @@ class WaveFileWriter
 	void Write(uint32_t value);
 	void Write4(const char* ptr);
 };
+
+// Reads a whole 16-bit PCM file into interleaved stereo, duplicating mono.
+// Only meant for offline tools and tests, it doesn't stream.
+bool ReadWaveFile(const std::string& filename, std::vector<short>* samples, unsigned int* sample_rate);
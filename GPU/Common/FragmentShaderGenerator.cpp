@@ -116,6 +116,10 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 		*errorString = "depal requires a texture";
 		return false;
 	}
+	if (shaderDepal && !compat.bitwiseOps) {
+		*errorString = "depal requires integer ops";
+		return false;
+	}
 
 	if (readFramebuffer && compat.shaderLanguage == HLSL_D3D9) {
 		*errorString = "Framebuffer read not yet supported in HLSL D3D9";
@@ -205,6 +209,10 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 		} else {
 			WRITE(p, "SamplerState samp : register(s0);\n");
 			WRITE(p, "Texture2D<vec4> tex : register(t0);\n");
+			if (shaderDepal) {
+				// Same slot as the separate depal pass uses.
+				WRITE(p, "Texture2D<vec4> pal : register(t3);\n");
+			}
 			if (readFramebufferTex) {
 				// No sampler required, we Load
 				WRITE(p, "Texture2D<vec4> fboTex : register(t1);\n");
@@ -567,25 +575,46 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 				} else {
 					WRITE(p, "  vec2 uv = %s.xy;\n  vec2 uv_round;\n", texcoord);
 				}
-				WRITE(p, "  vec2 tsize = vec2(textureSize(tex, 0));\n");
-				WRITE(p, "  vec2 fraction;\n");
+				const bool hlsl = compat.shaderLanguage == HLSL_D3D11;
+				if (hlsl) {
+					WRITE(p, "  vec2 tsize;\n");
+					WRITE(p, "  tex.GetDimensions(tsize.x, tsize.y);\n");
+				} else {
+					WRITE(p, "  vec2 tsize = vec2(textureSize(tex, 0));\n");
+				}
+				WRITE(p, "  vec2 fraction%s;\n", hlsl ? " = vec2(0.0, 0.0)" : "");
 				WRITE(p, "  bool bilinear = (u_depal_mask_shift_off_fmt >> 31) != 0U;\n");
 				WRITE(p, "  if (bilinear) {\n");
 				WRITE(p, "    uv_round = uv * tsize - vec2(0.5, 0.5);\n");
-				WRITE(p, "    fraction = fract(uv_round);\n");
+				WRITE(p, "    fraction = %s(uv_round);\n", hlsl ? "frac" : "fract");
 				WRITE(p, "    uv_round = (uv_round - fraction + vec2(0.5, 0.5)) / tsize;\n");  // We want to take our four point samples at pixel centers.
 				WRITE(p, "  } else {\n");
 				WRITE(p, "    uv_round = uv;\n");
 				WRITE(p, "  }\n");
-				WRITE(p, "  highp vec4 t = %s(tex, uv_round);\n", compat.texture);
-				WRITE(p, "  highp vec4 t1 = %sOffset(tex, uv_round, ivec2(1, 0));\n", compat.texture);
-				WRITE(p, "  highp vec4 t2 = %sOffset(tex, uv_round, ivec2(0, 1));\n", compat.texture);
-				WRITE(p, "  highp vec4 t3 = %sOffset(tex, uv_round, ivec2(1, 1));\n", compat.texture);
+				if (hlsl) {
+					WRITE(p, "  highp vec4 t = tex.Sample(samp, uv_round);\n");
+					WRITE(p, "  highp vec4 t1 = tex.Sample(samp, uv_round, int2(1, 0));\n");
+					WRITE(p, "  highp vec4 t2 = tex.Sample(samp, uv_round, int2(0, 1));\n");
+					WRITE(p, "  highp vec4 t3 = tex.Sample(samp, uv_round, int2(1, 1));\n");
+				} else {
+					WRITE(p, "  highp vec4 t = %s(tex, uv_round);\n", compat.texture);
+					WRITE(p, "  highp vec4 t1 = %sOffset(tex, uv_round, ivec2(1, 0));\n", compat.texture);
+					WRITE(p, "  highp vec4 t2 = %sOffset(tex, uv_round, ivec2(0, 1));\n", compat.texture);
+					WRITE(p, "  highp vec4 t3 = %sOffset(tex, uv_round, ivec2(1, 1));\n", compat.texture);
+				}
+				// The CLUT texture is in a BGRA format on D3D11, like other textures there.
+				const char *palFetch = hlsl ? "pal.Load(int3(" : "texelFetch(pal, ivec2(";
+				const char *palFetchEnd = hlsl ? ", 0, 0)).bgra" : ", 0), 0)";
 				WRITE(p, "  uint depalMask = (u_depal_mask_shift_off_fmt & 0xFFU);\n");
 				WRITE(p, "  uint depalShift = (u_depal_mask_shift_off_fmt >> 8) & 0xFFU;\n");
 				WRITE(p, "  uint depalOffset = ((u_depal_mask_shift_off_fmt >> 16) & 0xFFU) << 4;\n");
 				WRITE(p, "  uint depalFmt = (u_depal_mask_shift_off_fmt >> 24) & 0x3U;\n");
-				WRITE(p, "  uvec4 col; uint index0; uint index1; uint index2; uint index3;\n");
+				if (hlsl) {
+					// HLSL doesn't short circuit the bilinear check below.
+					WRITE(p, "  uvec4 col; uint index0; uint index1 = 0U; uint index2 = 0U; uint index3 = 0U;\n");
+				} else {
+					WRITE(p, "  uvec4 col; uint index0; uint index1; uint index2; uint index3;\n");
+				}
 				WRITE(p, "  switch (depalFmt) {\n");  // We might want to include fmt in the shader ID if this is a performance issue.
 				WRITE(p, "  case 0U:\n");  // 565
 				WRITE(p, "    col = uvec4(t.rgb * vec3(31.99, 63.99, 31.99), 0);\n");
@@ -637,14 +666,14 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 				WRITE(p, "    break;\n");
 				WRITE(p, "  };\n");
 				WRITE(p, "  index0 = ((index0 >> depalShift) & depalMask) | depalOffset;\n");
-				WRITE(p, "  t = texelFetch(pal, ivec2(index0, 0), 0);\n");
+				WRITE(p, "  t = %sindex0%s;\n", palFetch, palFetchEnd);
 				WRITE(p, "  if (bilinear && !(index0 == index1 && index1 == index2 && index2 == index3)) {\n");
 				WRITE(p, "    index1 = ((index1 >> depalShift) & depalMask) | depalOffset;\n");
 				WRITE(p, "    index2 = ((index2 >> depalShift) & depalMask) | depalOffset;\n");
 				WRITE(p, "    index3 = ((index3 >> depalShift) & depalMask) | depalOffset;\n");
-				WRITE(p, "    t1 = texelFetch(pal, ivec2(index1, 0), 0);\n");
-				WRITE(p, "    t2 = texelFetch(pal, ivec2(index2, 0), 0);\n");
-				WRITE(p, "    t3 = texelFetch(pal, ivec2(index3, 0), 0);\n");
+				WRITE(p, "    t1 = %sindex1%s;\n", palFetch, palFetchEnd);
+				WRITE(p, "    t2 = %sindex2%s;\n", palFetch, palFetchEnd);
+				WRITE(p, "    t3 = %sindex3%s;\n", palFetch, palFetchEnd);
 				WRITE(p, "    t = mix(t, t1, fraction.x);\n");
 				WRITE(p, "    t2 = mix(t2, t3, fraction.x);\n");
 				WRITE(p, "    t = mix(t, t2, fraction.y);\n");
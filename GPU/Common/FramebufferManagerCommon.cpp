@@ -24,6 +24,7 @@
 #include "Common/Data/Text/I18n.h"
 #include "Common/ColorConv.h"
 #include "Common/Common.h"
+#include "Common/Profiler/Trace.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
@@ -1019,6 +1020,7 @@ void FramebufferManagerCommon::SetViewport2D(int x, int y, int w, int h) {
 }
 
 void FramebufferManagerCommon::CopyDisplayToOutput(bool reallyDirty) {
+	TRACE_SCOPE("CopyDisplayToOutput", "present");
 	DownloadFramebufferOnSwitch(currentRenderVfb_);
 	shaderManager_->DirtyLastShader();
 
@@ -2149,6 +2151,7 @@ void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int
 }
 
 void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+	TRACE_SCOPE("ReadFramebufferToMemory", "framebuffer");
 	// Clamp to bufferWidth. Sometimes block transfers can cause this to hit.
 	if (x + w >= vfb->bufferWidth) {
 		w = vfb->bufferWidth - x;
@@ -2212,6 +2215,7 @@ void FramebufferManagerCommon::FlushBeforeCopy() {
 }
 
 void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 loadBytes) {
+	TRACE_SCOPE("DownloadFramebufferForClut", "framebuffer");
 	VirtualFramebuffer *vfb = GetVFBAt(fb_address);
 	if (vfb && vfb->fb_stride != 0) {
 		const u32 bpp = vfb->drawnFormat == GE_FORMAT_8888 ? 4 : 2;
@@ -204,8 +204,88 @@ void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 	}
 }
 
+// Like the strip offsets, but the first vertex of each triangle stays put.
+alignas(16) static const u16 fan_offsets_clockwise[24] = {
+	0, 1, 2,
+	0, 2, 3,
+	0, 3, 4,
+	0, 4, 5,
+	0, 5, 6,
+	0, 6, 7,
+	0, 7, 8,
+	0, 8, 9,
+};
+
+alignas(16) static const u16 fan_offsets_counter_clockwise[24] = {
+	0, 2, 1,
+	0, 3, 2,
+	0, 4, 3,
+	0, 5, 4,
+	0, 6, 5,
+	0, 7, 6,
+	0, 8, 7,
+	0, 9, 8,
+};
+
+alignas(16) static const u16 fan_increments[24] = {
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+};
+
 void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 	const int numTris = numVerts - 2;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	// Same idea as AddStrip: 8 triangles per iteration, and we may write a few extra indices.
+	const int numChunks = (numTris + 7) / 8;
+	const u16 *offsets = clockwise ? fan_offsets_clockwise : fan_offsets_counter_clockwise;
+#endif
+#ifdef _M_SSE
+	const __m128i ibase8 = _mm_set1_epi16(index_);
+	__m128i offsets0 = _mm_add_epi16(ibase8, _mm_load_si128((const __m128i *)offsets));
+	__m128i offsets1 = _mm_add_epi16(ibase8, _mm_load_si128((const __m128i *)offsets + 1));
+	__m128i offsets2 = _mm_add_epi16(ibase8, _mm_load_si128((const __m128i *)offsets + 2));
+	const __m128i increment0 = _mm_load_si128((const __m128i *)fan_increments);
+	const __m128i increment1 = _mm_load_si128((const __m128i *)fan_increments + 1);
+	const __m128i increment2 = _mm_load_si128((const __m128i *)fan_increments + 2);
+	__m128i *dst = (__m128i *)inds_;
+	for (int i = 0; i < numChunks; i++) {
+		_mm_storeu_si128(dst, offsets0);
+		_mm_storeu_si128(dst + 1, offsets1);
+		_mm_storeu_si128(dst + 2, offsets2);
+		offsets0 = _mm_add_epi16(offsets0, increment0);
+		offsets1 = _mm_add_epi16(offsets1, increment1);
+		offsets2 = _mm_add_epi16(offsets2, increment2);
+		dst += 3;
+	}
+	if (numTris > 0)
+		inds_ += numTris * 3;
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t ibase8 = vdupq_n_u16(index_);
+	uint16x8_t offsets0 = vaddq_u16(ibase8, vld1q_u16(offsets));
+	uint16x8_t offsets1 = vaddq_u16(ibase8, vld1q_u16(offsets + 8));
+	uint16x8_t offsets2 = vaddq_u16(ibase8, vld1q_u16(offsets + 16));
+	const uint16x8_t increment0 = vld1q_u16(fan_increments);
+	const uint16x8_t increment1 = vld1q_u16(fan_increments + 8);
+	const uint16x8_t increment2 = vld1q_u16(fan_increments + 16);
+	u16 *dst = inds_;
+	for (int i = 0; i < numChunks; i++) {
+		vst1q_u16(dst, offsets0);
+		vst1q_u16(dst + 8, offsets1);
+		vst1q_u16(dst + 16, offsets2);
+		offsets0 = vaddq_u16(offsets0, increment0);
+		offsets1 = vaddq_u16(offsets1, increment1);
+		offsets2 = vaddq_u16(offsets2, increment2);
+		dst += 3 * 8;
+	}
+	if (numTris > 0)
+		inds_ += numTris * 3;
+#else
 	u16 *outInds = inds_;
 	const int startIndex = index_;
 	const int v1 = clockwise ? 1 : 2;
@@ -216,6 +296,7 @@ void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 		*outInds++ = startIndex + i + v2;
 	}
 	inds_ = outInds;
+#endif
 	index_ += numVerts;
 	count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
@@ -272,11 +353,162 @@ void IndexGenerator::AddRectangles(int numVerts) {
 	seenPrims_ |= 1 << GE_PRIM_RECTANGLES;
 }
 
+// SIMD kernels for the indexed paths. Each handles as much as it can in whole vector steps
+// and returns how far it got, leaving the rest to the scalar loops. 32-bit indices are rare
+// and always take the scalar path.
+#ifdef _M_SSE
+typedef __m128i IndexVec;
+
+static inline IndexVec LoadIndices8(const u16_le *inds) {
+	return _mm_loadu_si128((const __m128i *)inds);
+}
+
+static inline IndexVec LoadIndices8(const u8 *inds) {
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)inds), _mm_setzero_si128());
+}
+
+// Loads four indices into both halves of the register.
+static inline IndexVec LoadIndices4x2(const u16_le *inds) {
+	const __m128i x = _mm_loadl_epi64((const __m128i *)inds);
+	return _mm_unpacklo_epi64(x, x);
+}
+
+static inline IndexVec LoadIndices4x2(const u8 *inds) {
+	u32 packed;
+	memcpy(&packed, inds, sizeof(packed));
+	const __m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), _mm_setzero_si128());
+	return _mm_unpacklo_epi64(x, x);
+}
+
+static inline IndexVec ReplaceFirstIndex(IndexVec x, u16 first) {
+	x = _mm_insert_epi16(x, first, 0);
+	return _mm_insert_epi16(x, first, 4);
+}
+
+// Picks lanes (l0, l1, l2, l3) from the low half and (h0, h1) from the high half.
+#define SHUFFLE_INDICES(x, l0, l1, l2, l3, h0, h1) \
+	_mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(l3, l2, l1, l0)), _MM_SHUFFLE(0, 0, h1, h0))
+
+static inline void StoreIndices8(u16 *out, IndexVec x, u16 offset) {
+	_mm_storeu_si128((__m128i *)out, _mm_add_epi16(x, _mm_set1_epi16(offset)));
+}
+#elif PPSSPP_ARCH(ARM_NEON)
+typedef uint16x8_t IndexVec;
+
+static inline IndexVec LoadIndices8(const u16_le *inds) {
+	return vld1q_u16((const u16 *)inds);
+}
+
+static inline IndexVec LoadIndices8(const u8 *inds) {
+	return vmovl_u8(vld1_u8(inds));
+}
+
+static inline IndexVec LoadIndices4x2(const u16_le *inds) {
+	const uint16x4_t x = vld1_u16((const u16 *)inds);
+	return vcombine_u16(x, x);
+}
+
+static inline IndexVec LoadIndices4x2(const u8 *inds) {
+	u32 packed;
+	memcpy(&packed, inds, sizeof(packed));
+	const uint16x4_t x = vget_low_u16(vmovl_u8(vcreate_u8(packed)));
+	return vcombine_u16(x, x);
+}
+
+static inline IndexVec ReplaceFirstIndex(IndexVec x, u16 first) {
+	x = vsetq_lane_u16(first, x, 0);
+	return vsetq_lane_u16(first, x, 4);
+}
+
+static inline uint8x8_t ShuffleTable(int l0, int l1, int l2, int l3) {
+	const uint64_t table =
+		(uint64_t)(l0 * 2) | ((uint64_t)(l0 * 2 + 1) << 8) |
+		((uint64_t)(l1 * 2) << 16) | ((uint64_t)(l1 * 2 + 1) << 24) |
+		((uint64_t)(l2 * 2) << 32) | ((uint64_t)(l2 * 2 + 1) << 40) |
+		((uint64_t)(l3 * 2) << 48) | ((uint64_t)(l3 * 2 + 1) << 56);
+	return vcreate_u8(table);
+}
+
+#define SHUFFLE_INDICES(x, l0, l1, l2, l3, h0, h1) \
+	vcombine_u16( \
+		vreinterpret_u16_u8(vtbl1_u8(vreinterpret_u8_u16(vget_low_u16(x)), ShuffleTable(l0, l1, l2, l3))), \
+		vreinterpret_u16_u8(vtbl1_u8(vreinterpret_u8_u16(vget_high_u16(x)), ShuffleTable(h0, h1, 0, 0))))
+
+static inline void StoreIndices8(u16 *out, IndexVec x, u16 offset) {
+	vst1q_u16(out, vaddq_u16(x, vdupq_n_u16(offset)));
+}
+#endif
+
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+// Plain copy with an offset added, used by points, lines, rectangles and clockwise lists.
+template <class ITypeLE>
+static int TranslateOffsetSIMD(u16 *out, const ITypeLE *inds, int count, u16 offset) {
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		StoreIndices8(out + i, LoadIndices8(inds + i), offset);
+	}
+	return i;
+}
+
+// Two strip triangles per step: from indices (a, b, c, d), clockwise gives abc bdc and
+// counter-clockwise acb bcd. Each step stores 8 indices of which 6 are used, the next step
+// or the scalar tail overwrites the other two. Returns the number of triangles done.
+template <class ITypeLE>
+static int TranslateStripSIMD(u16 *out, const ITypeLE *inds, int numTris, u16 offset, bool clockwise) {
+	const int numPairs = numTris / 2;
+	if (clockwise) {
+		for (int i = 0; i < numPairs; i++) {
+			const IndexVec x = LoadIndices4x2(inds + i * 2);
+			StoreIndices8(out + i * 6, SHUFFLE_INDICES(x, 0, 1, 2, 1, 3, 2), offset);
+		}
+	} else {
+		for (int i = 0; i < numPairs; i++) {
+			const IndexVec x = LoadIndices4x2(inds + i * 2);
+			StoreIndices8(out + i * 6, SHUFFLE_INDICES(x, 0, 2, 1, 1, 2, 3), offset);
+		}
+	}
+	return numPairs * 2;
+}
+
+// Two fan triangles per step. Loads (x, b, c, d) and swaps in the hub index h for x, then
+// clockwise gives hbc hcd and counter-clockwise hcb hdc. Returns the number of triangles done.
+template <class ITypeLE>
+static int TranslateFanSIMD(u16 *out, const ITypeLE *inds, int numTris, u16 offset, bool clockwise) {
+	const int numPairs = numTris / 2;
+	const u16 hub = inds[0];
+	if (clockwise) {
+		for (int i = 0; i < numPairs; i++) {
+			const IndexVec x = ReplaceFirstIndex(LoadIndices4x2(inds + i * 2), hub);
+			StoreIndices8(out + i * 6, SHUFFLE_INDICES(x, 0, 1, 2, 0, 2, 3), offset);
+		}
+	} else {
+		for (int i = 0; i < numPairs; i++) {
+			const IndexVec x = ReplaceFirstIndex(LoadIndices4x2(inds + i * 2), hub);
+			StoreIndices8(out + i * 6, SHUFFLE_INDICES(x, 0, 2, 1, 0, 3, 2), offset);
+		}
+	}
+	return numPairs * 2;
+}
+
+static int TranslateOffsetSIMD(u16 *out, const u32_le *inds, int count, u16 offset) { return 0; }
+static int TranslateStripSIMD(u16 *out, const u32_le *inds, int numTris, u16 offset, bool clockwise) { return 0; }
+static int TranslateFanSIMD(u16 *out, const u32_le *inds, int numTris, u16 offset, bool clockwise) { return 0; }
+#else
+template <class ITypeLE>
+static int TranslateOffsetSIMD(u16 *out, const ITypeLE *inds, int count, u16 offset) { return 0; }
+template <class ITypeLE>
+static int TranslateStripSIMD(u16 *out, const ITypeLE *inds, int numTris, u16 offset, bool clockwise) { return 0; }
+template <class ITypeLE>
+static int TranslateFanSIMD(u16 *out, const ITypeLE *inds, int numTris, u16 offset, bool clockwise) { return 0; }
+#endif
+
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
+	const int done = TranslateOffsetSIMD(outInds, inds, numInds, indexOffset);
+	outInds += done;
+	for (int i = done; i < numInds; i++)
 		*outInds++ = indexOffset + inds[i];
 	inds_ = outInds;
 	count_ += numInds;
@@ -289,7 +521,9 @@ void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int ind
 	indexOffset = index_ - indexOffset;
 	u16 *outInds = inds_;
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
+	const int done = TranslateOffsetSIMD(outInds, inds, numInds, indexOffset);
+	outInds += done;
+	for (int i = done; i < numInds; i += 2) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + 1];
 	}
@@ -329,7 +563,14 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 		numInds = numTris * 3;
 		const int v1 = clockwise ? 1 : 2;
 		const int v2 = clockwise ? 2 : 1;
-		for (int i = 0; i < numInds; i += 3) {
+		int i = 0;
+		if (clockwise) {
+			// Stop at a whole triangle so the scalar loop below stays in step.
+			i = TranslateOffsetSIMD(outInds, inds, numInds, indexOffset);
+			i -= i % 3;
+			outInds += i;
+		}
+		for (; i < numInds; i += 3) {
 			*outInds++ = indexOffset + inds[i];
 			*outInds++ = indexOffset + inds[i + v1];
 			*outInds++ = indexOffset + inds[i + v2];
@@ -347,7 +588,10 @@ void IndexGenerator::TranslateStrip(int numInds, const ITypeLE *inds, int indexO
 	indexOffset = index_ - indexOffset;
 	int numTris = numInds - 2;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numTris; i++) {
+	// Handles an even number of triangles, so the winding is unchanged for the rest.
+	const int done = numTris > 0 ? TranslateStripSIMD(outInds, inds, numTris, indexOffset, clockwise) : 0;
+	outInds += done * 3;
+	for (int i = done; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + wind];
 		wind ^= 3;  // Toggle between 1 and 2
@@ -367,7 +611,9 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 	u16 *outInds = inds_;
 	const int v1 = clockwise ? 1 : 2;
 	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
+	const int done = numTris > 0 ? TranslateFanSIMD(outInds, inds, numTris, indexOffset, clockwise) : 0;
+	outInds += done * 3;
+	for (int i = done; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[0];
 		*outInds++ = indexOffset + inds[i + v1];
 		*outInds++ = indexOffset + inds[i + v2];
@@ -384,7 +630,9 @@ inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds
 	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
+	const int done = TranslateOffsetSIMD(outInds, inds, numInds, indexOffset);
+	outInds += done;
+	for (int i = done; i < numInds; i += 2) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i+1];
 	}
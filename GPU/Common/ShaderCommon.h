@@ -20,6 +20,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "GPU/Common/ShaderUsage.h"
+
 namespace Draw {
 	class DrawContext;
 }
@@ -118,8 +120,12 @@ class ShaderManagerCommon {
 
 	virtual void DirtyLastShader() = 0;
 
+	// Per-game shader usage, persisted next to the backend's shader cache.
+	ShaderUsage &Usage() { return usage_; }
+
 protected:
 	Draw::DrawContext *draw_ = nullptr;
+	ShaderUsage usage_;
 };
 
 enum DoLightComputation {
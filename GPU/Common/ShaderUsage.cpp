@@ -0,0 +1,183 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "GPU/Common/ShaderUsage.h"
+
+static const uint32_t USAGE_HEADER_MAGIC = 0x45535553;  // SUSE
+static const uint32_t USAGE_VERSION = 1;
+// Counts are halved on save once any passes this, so older sessions slowly fade out.
+static const uint32_t USAGE_DECAY_LIMIT = 1 << 20;
+
+struct ShaderUsageHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numVertexShaders;
+	uint32_t numFragmentShaders;
+	uint32_t numPrograms;
+};
+
+template <class K>
+static uint32_t LookupCount(const std::map<K, uint32_t> &counts, const K &key) {
+	auto iter = counts.find(key);
+	return iter == counts.end() ? 0 : iter->second;
+}
+
+template <class K>
+static void BumpCount(std::map<K, uint32_t> &counts, const K &key) {
+	uint32_t &count = counts[key];
+	if (count != 0xFFFFFFFF)
+		count++;
+}
+
+void ShaderUsage::NoteShaders(const VShaderID &vsid, const FShaderID &fsid) {
+	BumpCount(vert_, vsid);
+	BumpCount(frag_, fsid);
+	BumpCount(programs_, std::make_pair(vsid, fsid));
+	dirty_ = true;
+}
+
+uint32_t ShaderUsage::VertexShaderCount(const VShaderID &id) const {
+	return LookupCount(vert_, id);
+}
+
+uint32_t ShaderUsage::FragmentShaderCount(const FShaderID &id) const {
+	return LookupCount(frag_, id);
+}
+
+uint32_t ShaderUsage::ProgramCount(const VShaderID &vsid, const FShaderID &fsid) const {
+	return LookupCount(programs_, std::make_pair(vsid, fsid));
+}
+
+void ShaderUsage::SortVertexShaders(std::vector<VShaderID> &ids) const {
+	std::stable_sort(ids.begin(), ids.end(), [&](const VShaderID &a, const VShaderID &b) {
+		return VertexShaderCount(a) > VertexShaderCount(b);
+	});
+}
+
+void ShaderUsage::SortFragmentShaders(std::vector<FShaderID> &ids) const {
+	std::stable_sort(ids.begin(), ids.end(), [&](const FShaderID &a, const FShaderID &b) {
+		return FragmentShaderCount(a) > FragmentShaderCount(b);
+	});
+}
+
+void ShaderUsage::SortPrograms(std::vector<std::pair<VShaderID, FShaderID>> &programs) const {
+	std::stable_sort(programs.begin(), programs.end(), [&](const std::pair<VShaderID, FShaderID> &a, const std::pair<VShaderID, FShaderID> &b) {
+		return LookupCount(programs_, a) > LookupCount(programs_, b);
+	});
+}
+
+template <class K>
+static bool ReadCounts(FILE *f, uint32_t num, std::map<K, uint32_t> &counts) {
+	for (uint32_t i = 0; i < num; i++) {
+		K key;
+		uint32_t count;
+		if (fread(&key, sizeof(key), 1, f) != 1 || fread(&count, sizeof(count), 1, f) != 1)
+			return false;
+		counts[key] = count;
+	}
+	return true;
+}
+
+template <class K>
+static bool WriteCounts(FILE *f, const std::map<K, uint32_t> &counts) {
+	for (const auto &entry : counts) {
+		if (fwrite(&entry.first, sizeof(entry.first), 1, f) != 1 || fwrite(&entry.second, sizeof(entry.second), 1, f) != 1)
+			return false;
+	}
+	return true;
+}
+
+template <class K>
+static void DecayCounts(std::map<K, uint32_t> &counts) {
+	for (auto iter = counts.begin(); iter != counts.end(); ) {
+		iter->second /= 2;
+		if (iter->second == 0)
+			iter = counts.erase(iter);
+		else
+			++iter;
+	}
+}
+
+bool ShaderUsage::Load(const std::string &filename) {
+	Clear();
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return false;
+
+	ShaderUsageHeader header{};
+	bool success = fread(&header, sizeof(header), 1, f) == 1;
+	success = success && header.magic == USAGE_HEADER_MAGIC && header.version == USAGE_VERSION;
+	success = success && ReadCounts(f, header.numVertexShaders, vert_);
+	success = success && ReadCounts(f, header.numFragmentShaders, frag_);
+	success = success && ReadCounts(f, header.numPrograms, programs_);
+	fclose(f);
+
+	if (!success) {
+		WARN_LOG(G3D, "Bad shader usage file '%s', starting over", filename.c_str());
+		Clear();
+		return false;
+	}
+	return true;
+}
+
+void ShaderUsage::Save(const std::string &filename) {
+	if (!dirty_)
+		return;
+
+	uint32_t maxCount = 0;
+	for (const auto &entry : programs_)
+		maxCount = std::max(maxCount, entry.second);
+	if (maxCount > USAGE_DECAY_LIMIT) {
+		DecayCounts(vert_);
+		DecayCounts(frag_);
+		DecayCounts(programs_);
+	}
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return;
+
+	ShaderUsageHeader header{};
+	header.magic = USAGE_HEADER_MAGIC;
+	header.version = USAGE_VERSION;
+	header.numVertexShaders = (uint32_t)vert_.size();
+	header.numFragmentShaders = (uint32_t)frag_.size();
+	header.numPrograms = (uint32_t)programs_.size();
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	success = success && WriteCounts(f, vert_);
+	success = success && WriteCounts(f, frag_);
+	success = success && WriteCounts(f, programs_);
+	fclose(f);
+
+	if (!success) {
+		ERROR_LOG(G3D, "Failed to write shader usage file, disk full?");
+		File::Delete(filename);
+	}
+	dirty_ = false;
+}
+
+void ShaderUsage::Clear() {
+	vert_.clear();
+	frag_.clear();
+	programs_.clear();
+	dirty_ = false;
+}
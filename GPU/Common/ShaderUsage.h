@@ -0,0 +1,57 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GPU/Common/ShaderId.h"
+
+// How long boot may spend precompiling the shader cache before the game is allowed to start.
+// Whatever is left gets compiled in small slices during the first frames.
+const double SHADER_PRECOMPILE_BOOT_BUDGET = 1.0;
+const double SHADER_PRECOMPILE_FRAME_SLICE = 0.002;
+
+// Remembers how often each shader and vertex/fragment pair was switched to, across runs,
+// so that shader cache precompiles can start with what the game actually leans on.
+class ShaderUsage {
+public:
+	void NoteShaders(const VShaderID &vsid, const FShaderID &fsid);
+
+	uint32_t VertexShaderCount(const VShaderID &id) const;
+	uint32_t FragmentShaderCount(const FShaderID &id) const;
+	uint32_t ProgramCount(const VShaderID &vsid, const FShaderID &fsid) const;
+
+	// Most used first. Ties, including IDs never seen, keep their original order.
+	void SortVertexShaders(std::vector<VShaderID> &ids) const;
+	void SortFragmentShaders(std::vector<FShaderID> &ids) const;
+	void SortPrograms(std::vector<std::pair<VShaderID, FShaderID>> &programs) const;
+
+	bool Load(const std::string &filename);
+	void Save(const std::string &filename);
+	void Clear();
+
+private:
+	std::map<VShaderID, uint32_t> vert_;
+	std::map<FShaderID, uint32_t> frag_;
+	std::map<std::pair<VShaderID, FShaderID>, uint32_t> programs_;
+	bool dirty_ = false;
+};
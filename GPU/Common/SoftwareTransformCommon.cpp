@@ -17,6 +17,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include "ext/xxhash.h"
 #include "Common/Math/math_util.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
 
@@ -156,6 +158,131 @@ static int ColorIndexOffset(int prim, GEShadeMode shadeMode, bool clearMode) {
 	return 0;
 }
 
+enum {
+	SWCACHE_DECIMATION_INTERVAL = 17,
+	SWCACHE_KILL_AGE = 120,
+	// At 36 bytes per TransformedVertex, about 9MB.
+	SWCACHE_MAX_VERTS = 256 * 1024,
+	// A frame is poor when it had at least this many misses and fewer than one hit per this many misses.
+	SWCACHE_POOR_MIN_MISSES = 32,
+	SWCACHE_POOR_MISS_RATIO = 8,
+	// After this many poor frames in a row, stop hashing draws for a while.  A static scene
+	// only starts hitting on its third frame, so this has to be comfortably above two.
+	SWCACHE_POOR_FRAMES = 8,
+	SWCACHE_BAILOUT_FRAMES = 300,
+};
+
+TransformedVertexCache::TransformedVertexCache() : entries_(256) {
+}
+
+TransformedVertexCache::~TransformedVertexCache() {
+	Clear();
+}
+
+bool TransformedVertexCache::Lookup(uint64_t dataHash, uint64_t stateHash, TransformedVertex *dest, int count) {
+	Entry *entry = entries_.Get(Key(dataHash, stateHash));
+	if (entry && entry->dataHash == dataHash && entry->stateHash == stateHash && (int)entry->verts.size() == count) {
+		entry->lastFrame = gpuStats.numFlips;
+		memcpy(dest, entry->verts.data(), count * sizeof(TransformedVertex));
+		gpuStats.numSwTransformCacheHits++;
+		frameHits_++;
+		return true;
+	}
+	gpuStats.numSwTransformCacheMisses++;
+	frameMisses_++;
+	return false;
+}
+
+bool TransformedVertexCache::Active() const {
+	return gpuStats.numFlips >= bailoutUntil_;
+}
+
+void TransformedVertexCache::Store(uint64_t dataHash, uint64_t stateHash, const TransformedVertex *verts, int count) {
+	const uint32_t key = Key(dataHash, stateHash);
+	Entry *entry = entries_.Get(key);
+	if (!entry) {
+		entry = new Entry();
+		entries_.Insert(key, entry);
+	} else if (entry->dataHash == dataHash && entry->stateHash == stateHash) {
+		// Second time we see this draw, now it's worth keeping.
+		if (entry->verts.empty() && totalVerts_ + count <= SWCACHE_MAX_VERTS) {
+			entry->verts.assign(verts, verts + count);
+			totalVerts_ += count;
+		}
+		entry->lastFrame = gpuStats.numFlips;
+		return;
+	} else {
+		// Key collision, the new draw takes over the slot.
+		totalVerts_ -= (int)entry->verts.size();
+		entry->verts.clear();
+	}
+
+	entry->dataHash = dataHash;
+	entry->stateHash = stateHash;
+	entry->lastFrame = gpuStats.numFlips;
+}
+
+void TransformedVertexCache::Decimate() {
+	// When draws keep changing, hashing them costs more than the few hits save.
+	if (frameMisses_ >= SWCACHE_POOR_MIN_MISSES && frameHits_ * SWCACHE_POOR_MISS_RATIO < frameMisses_) {
+		if (++poorFrames_ >= SWCACHE_POOR_FRAMES) {
+			poorFrames_ = 0;
+			bailoutUntil_ = gpuStats.numFlips + SWCACHE_BAILOUT_FRAMES;
+			Clear();
+		}
+	} else {
+		poorFrames_ = 0;
+	}
+	frameHits_ = 0;
+	frameMisses_ = 0;
+
+	if (--decimationCounter_ > 0)
+		return;
+	decimationCounter_ = SWCACHE_DECIMATION_INTERVAL;
+
+	const int threshold = gpuStats.numFlips - SWCACHE_KILL_AGE;
+	entries_.Iterate([&](uint32_t hash, Entry *entry) {
+		if (entry->lastFrame < threshold) {
+			totalVerts_ -= (int)entry->verts.size();
+			entries_.Remove(hash);
+			delete entry;
+		}
+	});
+	entries_.Maintain();
+}
+
+void TransformedVertexCache::Clear() {
+	entries_.Iterate([&](uint32_t hash, Entry *entry) {
+		delete entry;
+	});
+	entries_.Clear();
+	totalVerts_ = 0;
+}
+
+// Covers everything the transform reads, apart from the decoded vertices themselves.
+static uint64_t ComputeTransformStateHash(int prim, u32 vertType, const DecVtxFormat &decVtxFormat, bool provokeFlatFirst) {
+	auto hashRegs = [](GECommand first, GECommand last, uint64_t seed) {
+		return XXH3_64bits_withSeed(&gstate.cmdmem[first], (last - first + 1) * sizeof(u32), seed);
+	};
+
+	uint64_t hash = hashRegs(GE_CMD_LIGHTINGENABLE, GE_CMD_LIGHTENABLE3, 0);
+	hash = hashRegs(GE_CMD_SHADEMODE, GE_CMD_LSC3, hash);
+	hash = hashRegs(GE_CMD_TEXSIZE0, GE_CMD_TEXSIZE0, hash);
+	hash = hashRegs(GE_CMD_TEXMAPMODE, GE_CMD_TEXSHADELS, hash);
+	hash = hashRegs(GE_CMD_FOG1, GE_CMD_FOG2, hash);
+	hash = hashRegs(GE_CMD_CLEARMODE, GE_CMD_CLEARMODE, hash);
+
+	// World and view are adjacent.
+	hash = XXH3_64bits_withSeed(gstate.worldMatrix, sizeof(gstate.worldMatrix) + sizeof(gstate.viewMatrix), hash);
+	hash = XXH3_64bits_withSeed(gstate.tgenMatrix, sizeof(gstate.tgenMatrix), hash);
+	if (vertTypeIsSkinningEnabled(vertType)) {
+		hash = XXH3_64bits_withSeed(gstate.boneMatrix, vertTypeGetNumBoneWeights(vertType) * 12 * sizeof(float), hash);
+	}
+
+	const u32 extra[6] = { (u32)prim, vertType, decVtxFormat.id, gstate_c.curTextureWidth, gstate_c.curTextureHeight, provokeFlatFirst ? 1U : 0U };
+	return XXH3_64bits_withSeed(extra, sizeof(extra), hash);
+}
+
 void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVtxFormat, int maxIndex, SoftwareTransformResult *result) {
 	u8 *decoded = params_.decoded;
 	TransformedVertex *transformed = params_.transformed;
@@ -193,8 +320,20 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 		provokeIndOffset = ColorIndexOffset(prim, gstate.getShadeMode(), gstate.isModeClear());
 	}
 
+	TransformedVertexCache *cache = params_.cache && params_.cache->Active() ? params_.cache : nullptr;
+	uint64_t dataHash = 0;
+	uint64_t stateHash = 0;
+	bool cached = false;
+	if (cache) {
+		dataHash = XXH3_64bits(decoded, maxIndex * decVtxFormat.stride);
+		stateHash = ComputeTransformStateHash(prim, vertType, decVtxFormat, params_.provokeFlatFirst);
+		cached = cache->Lookup(dataHash, stateHash, transformed, maxIndex);
+	}
+
 	VertexReader reader(decoded, decVtxFormat, vertType);
-	if (throughmode) {
+	if (cached) {
+		// Already filled in from the cache.
+	} else if (throughmode) {
 		for (int index = 0; index < maxIndex; index++) {
 			// Do not touch the coordinates or the colors. No lighting.
 			reader.Goto(index);
@@ -431,6 +570,9 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 			// So is vertex depth rounding, to simulate the 16-bit depth buffer.
 		}
 	}
+	if (cache && !cached) {
+		cache->Store(dataHash, stateHash, transformed, maxIndex);
+	}
 
 	// Here's the best opportunity to try to detect rectangles used to clear the screen, and
 	// replace them with real clears. This can provide a speedup on certain mobile chips.
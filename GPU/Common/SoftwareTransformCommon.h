@@ -17,7 +17,10 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Common/CommonTypes.h"
+#include "Common/Data/Collections/Hashmaps.h"
 
 #include "VertexDecoderCommon.h"
 
@@ -47,12 +50,60 @@ struct SoftwareTransformResult {
 	bool drawIndexed;
 };
 
+// Remembers the output of the software transform, keyed by a hash of the decoded vertices and one of
+// the transform state. Draws that come back unchanged frame after frame can then skip lighting etc.
+// Like the vertex array cache, data is only kept once a draw has been seen twice, and unused entries
+// are aged out.
+class TransformedVertexCache {
+public:
+	TransformedVertexCache();
+	~TransformedVertexCache();
+
+	// Copies the cached output to dest and returns true on a hit.
+	bool Lookup(uint64_t dataHash, uint64_t stateHash, TransformedVertex *dest, int count);
+	void Store(uint64_t dataHash, uint64_t stateHash, const TransformedVertex *verts, int count);
+	// False for a while after several frames where few draws hit.  Don't hash or look up then.
+	bool Active() const;
+
+	// Call once per frame.
+	void Decimate();
+	void Clear();
+
+	int Size() {
+		return (int)entries_.size();
+	}
+
+private:
+	struct Entry {
+		uint64_t dataHash;
+		uint64_t stateHash;
+		int lastFrame;
+		// Empty until the draw has been seen a second time.
+		std::vector<TransformedVertex> verts;
+	};
+
+	static uint32_t Key(uint64_t dataHash, uint64_t stateHash) {
+		uint64_t mixed = dataHash ^ (stateHash * 0x9E3779B97F4A7C15ULL);
+		return (uint32_t)(mixed ^ (mixed >> 32));
+	}
+
+	PrehashMap<Entry *, nullptr> entries_;
+	int totalVerts_ = 0;
+	int decimationCounter_ = 0;
+	int frameHits_ = 0;
+	int frameMisses_ = 0;
+	int poorFrames_ = 0;
+	int bailoutUntil_ = 0;
+};
+
 struct SoftwareTransformParams {
 	u8 *decoded;
 	TransformedVertex *transformed;
 	TransformedVertex *transformedExpanded;
 	FramebufferManagerCommon *fbman;
 	TextureCacheCommon *texCache;
+	// Optional, skips the transform for repeated draws.
+	TransformedVertexCache *cache;
 	bool allowClear;
 	bool allowSeparateAlphaClear;
 	bool provokeFlatFirst;
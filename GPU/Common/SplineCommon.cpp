@@ -22,6 +22,7 @@
 
 #include "Common/CPUDetect.h"
 
+#include "Core/ThreadPools.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -333,80 +334,83 @@ void ControlPoints::Convert(const SimpleVertex *const *points, int size) {
 	defcolor = points[0]->color_32;
 }
 
+// Below this many output vertices, handing the work to other threads costs more than it saves.
+static const int PARALLEL_TESSELLATION_MIN_VERTS = 4096;
+
 template<class Surface>
 class SubdivisionSurface {
 public:
+	// Tessellates patches [lower, upper), numbered along U first.
+	// Patches write disjoint output vertices (shared edges belong to one of them), so ranges can run on separate threads.
 	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
-	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, int lower, int upper) {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
+		for (int patch = lower; patch < upper; ++patch) {
+			const int patch_u = patch % surface.num_patches_u;
+			const int patch_v = patch / surface.num_patches_u;
 			const int start_u = surface.GetTessStart(patch_u);
-			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
-				const int start_v = surface.GetTessStart(patch_v);
-
-				// Prepare 4x4 control points to tessellate
-				const int idx = surface.GetPointIndex(patch_u, patch_v);
-				const int idx_v[4] = { idx, idx + surface.num_points_u, idx + surface.num_points_u * 2, idx + surface.num_points_u * 3 };
-				Tessellator<Vec3f> tess_pos(points.pos, idx_v);
-				Tessellator<Vec4f> tess_col(points.col, idx_v);
-				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
-				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
-
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
-
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
-
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
-
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
-
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
-						if (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
-						} else {
-							vert.color_32 = points.defcolor;
-						}
-						if (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
-						} else {
-							// Generate texcoord
-							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
-						}
-						if (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if (patchFacing)
-								vert.nrm *= -1.0f;
-						} else {
-							vert.nrm.SetZero();
-							vert.nrm.z = 1.0f;
-						}
+			const int start_v = surface.GetTessStart(patch_v);
+
+			// Prepare 4x4 control points to tessellate
+			const int idx = surface.GetPointIndex(patch_u, patch_v);
+			const int idx_v[4] = { idx, idx + surface.num_points_u, idx + surface.num_points_u * 2, idx + surface.num_points_u * 3 };
+			Tessellator<Vec3f> tess_pos(points.pos, idx_v);
+			Tessellator<Vec4f> tess_col(points.col, idx_v);
+			Tessellator<Vec2f> tess_tex(points.tex, idx_v);
+			Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
+
+			for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
+				const int index_u = surface.GetIndexU(patch_u, tile_u);
+				const Weight &wu = weights.u[index_u];
+
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
+
+				for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const Weight &wv = weights.v[index_v];
+
+					SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+
+					// Tessellate
+					vert.pos = tess_pos.SampleV(wv.basis);
+					if (sampleCol) {
+						vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+					} else {
+						vert.color_32 = points.defcolor;
+					}
+					if (sampleTex) {
+						tess_tex.SampleV(wv.basis).Write(vert.uv);
+					} else {
+						// Generate texcoord
+						vert.uv[0] = patch_u + tile_u * inv_u;
+						vert.uv[1] = patch_v + tile_v * inv_v;
+					}
+					if (sampleNrm) {
+						const Vec3f derivU = tess_nrm.SampleV(wv.basis);
+						const Vec3f derivV = tess_pos.SampleV(wv.deriv);
+
+						vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
+						if (patchFacing)
+							vert.nrm *= -1.0f;
+					} else {
+						vert.nrm.SetZero();
+						vert.nrm.z = 1.0f;
 					}
 				}
 			}
 		}
-
-		surface.BuildIndex(output.indices, output.count);
 	}
 
-	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &);
+	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &, int, int);
 	TEMPLATE_PARAMETER_DISPATCHER_FUNCTION(Tess, SubdivisionSurface::Tessellate, TessFunc);
 
 	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, u32 origVertType) {
@@ -420,7 +424,18 @@ class SubdivisionSurface {
 		static TemplateParameterDispatcher<TessFunc, ARRAY_SIZE(params), Tess> dispatcher; // Initialize only once
 
 		TessFunc func = dispatcher.GetFunc(params);
-		func(output, surface, points, weights);
+
+		const int numPatches = surface.num_patches_u * surface.num_patches_v;
+		const int numVerts = numPatches * (surface.tess_u + 1) * (surface.tess_v + 1);
+		if (numPatches > 1 && numVerts >= PARALLEL_TESSELLATION_MIN_VERTS) {
+			GlobalThreadPool::Loop([&](int lower, int upper) {
+				func(output, surface, points, weights, lower, upper);
+			}, 0, numPatches);
+		} else {
+			func(output, surface, points, weights, 0, numPatches);
+		}
+
+		surface.BuildIndex(output.indices, output.count);
 	}
 };
 
@@ -19,6 +19,7 @@
 
 #include "ppsspp_config.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/ColorConv.h"
 #include "Common/MemoryUtil.h"
 #include "Core/Config.h"
@@ -342,13 +343,15 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 	}
 
 	bool hasClut = gstate.isTextureFormatIndexed();
+	// When the shader does the lookup, the texture holds raw indices and doesn't depend on the CLUT.
+	bool clutIndices = hasClut && CanDepalettizeInShader();
 	u32 cluthash;
 	if (hasClut) {
 		if (clutLastFormat_ != gstate.clutformat) {
 			// We update here because the clut format can be specified after the load.
 			UpdateCurrentClut(gstate.getClutPaletteFormat(), gstate.getClutIndexStartPos(), gstate.isClutIndexSimple());
 		}
-		cluthash = clutHash_ ^ gstate.clutformat;
+		cluthash = clutIndices ? 0 : clutHash_ ^ gstate.clutformat;
 	} else {
 		cluthash = 0;
 	}
@@ -377,6 +380,11 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 		bool match = entry->Matches(dim, format, maxLevel);
 		const char *reason = "different params";
 
+		if (((entry->status & TexCacheEntry::STATUS_CLUT_INDICES) != 0) != clutIndices) {
+			// Switched between CPU and shader depal, the contents are different.
+			match = false;
+		}
+
 		// Check for FBO changes.
 		if (entry->status & TexCacheEntry::STATUS_FRAMEBUFFER_OVERLAP) {
 			// Fall through to the end where we'll delete the entry if there's a framebuffer.
@@ -514,7 +522,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			entry->status = TexCacheEntry::STATUS_UNRELIABLE;
 		}
 
-		if (hasClut && clutRenderAddress_ == 0xFFFFFFFF) {
+		if (hasClut && !clutIndices && clutRenderAddress_ == 0xFFFFFFFF) {
 			const u64 cachekeyMin = (u64)(texaddr & 0x3FFFFFFF) << 32;
 			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
 
@@ -548,6 +556,11 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 	entry->bufw = bufw;
 
 	entry->cluthash = cluthash;
+	if (clutIndices) {
+		entry->status |= TexCacheEntry::STATUS_CLUT_INDICES;
+	} else {
+		entry->status &= ~TexCacheEntry::STATUS_CLUT_INDICES;
+	}
 
 	gstate_c.curTextureWidth = w;
 	gstate_c.curTextureHeight = h;
@@ -1604,6 +1617,94 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 	}
 }
 
+void TextureCacheCommon::DecodeTextureIndices(u8 *out, int outPitch, GETextureFormat format, uint32_t texaddr, int level, int bufw) {
+	// Writes each index as a 32-bit value, so that it can be uploaded as 8888 and reassembled
+	// by the depal fragment shader (see GE_FORMAT_8888 there.)  Mask, shift and offset are applied there too.
+	int w = gstate.getTextureWidth(level);
+	int h = gstate.getTextureHeight(level);
+	const u8 *texptr = Memory::GetPointer(texaddr);
+
+	bool swizzled = gstate.isTextureSwizzled();
+	if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr)) {
+		// Same mirror handling as DecodeTextureLevel.
+		if ((texaddr & 0x00200000) == 0x00200000) {
+			swizzled = !swizzled;
+		}
+	}
+
+	switch (format) {
+	case GE_TFMT_CLUT4:
+		if (swizzled) {
+			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpTexBuf32_.data(), bufw / 2, texptr, bufw, h, 0);
+			texptr = (u8 *)tmpTexBuf32_.data();
+		}
+		for (int y = 0; y < h; ++y) {
+			u32 *dest = (u32 *)(out + outPitch * y);
+			const u8 *indexed = texptr + (bufw * y) / 2;
+			for (int x = 0; x < w; ++x) {
+				dest[x] = (indexed[x >> 1] >> ((x & 1) * 4)) & 0xF;
+			}
+		}
+		break;
+
+	case GE_TFMT_CLUT8:
+	case GE_TFMT_CLUT16:
+	case GE_TFMT_CLUT32:
+	{
+		const int bytesPerIndex = format == GE_TFMT_CLUT8 ? 1 : (format == GE_TFMT_CLUT16 ? 2 : 4);
+		if (swizzled) {
+			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
+			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
+			texptr = (u8 *)tmpTexBuf32_.data();
+		}
+		for (int y = 0; y < h; ++y) {
+			u32 *dest = (u32 *)(out + outPitch * y);
+			const u8 *row = texptr + bufw * bytesPerIndex * y;
+			switch (bytesPerIndex) {
+			case 1:
+				for (int x = 0; x < w; ++x) {
+					dest[x] = row[x];
+				}
+				break;
+			case 2:
+				for (int x = 0; x < w; ++x) {
+					dest[x] = ((const u16_le *)row)[x];
+				}
+				break;
+			case 4:
+				for (int x = 0; x < w; ++x) {
+					dest[x] = ((const u32_le *)row)[x];
+				}
+				break;
+			}
+		}
+		break;
+	}
+
+	default:
+		ERROR_LOG_REPORT(G3D, "Unexpected non-CLUT texture format %d for shader depal", format);
+		break;
+	}
+}
+
+bool TextureCacheCommon::CanDepalettizeInShader() {
+	if (!g_Config.bShaderDepalTextures || !SupportsShaderDepal()) {
+		return false;
+	}
+	// The shader only looks up the base level.  Scaling or replacing indices wouldn't make sense either.
+	if (gstate.getTextureMaxLevel() != 0 || standardScaleFactor_ != 1 || replacer_.Enabled()) {
+		return false;
+	}
+	// Indices are fetched unfiltered and the shader filters bilinearly when the mag filter is linear.
+	// Without mips, minifying samples the base level the same way, so that's only right when min matches mag.
+	SamplerCacheKey key = GetSamplingParams(0, gstate.getTextureAddress(0));
+	if (key.minFilt != key.magFilt || key.magFilt != gstate.isMagnifyFilteringEnabled()) {
+		return false;
+	}
+	return true;
+}
+
 void TextureCacheCommon::ApplyTexture() {
 	TexCacheEntry *entry = nextTexture_;
 	if (!entry) {
@@ -1662,6 +1763,7 @@ void TextureCacheCommon::ApplyTexture() {
 
 	// Okay, now actually rebuild the texture if needed.
 	if (nextNeedsRebuild_) {
+		TRACE_SCOPE("BuildTexture", "texture");
 		_assert_(!entry->texturePtr);
 		BuildTexture(entry);
 		InvalidateLastTexture();
@@ -1669,7 +1771,10 @@ void TextureCacheCommon::ApplyTexture() {
 
 	entry->lastFrame = gpuStats.numFlips;
 	BindTexture(entry);
-	gstate_c.SetTextureFullAlpha(entry->GetAlphaStatus() == TexCacheEntry::STATUS_ALPHA_FULL);
+	// For CLUT index textures, BindTexture is responsible for SetTextureFullAlpha, based on the CLUT.
+	if ((entry->status & TexCacheEntry::STATUS_CLUT_INDICES) == 0) {
+		gstate_c.SetTextureFullAlpha(entry->GetAlphaStatus() == TexCacheEntry::STATUS_ALPHA_FULL);
+	}
 }
 
 void TextureCacheCommon::Clear(bool delete_them) {
@@ -1734,7 +1839,8 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 			if (secondIter != secondCache_.end()) {
 				// Found it, but does it match our current params?  If not, abort.
 				TexCacheEntry *secondEntry = secondIter->second.get();
-				if (secondEntry->Matches(entry->dim, entry->format, entry->maxLevel)) {
+				bool sameDecode = ((secondEntry->status ^ entry->status) & TexCacheEntry::STATUS_CLUT_INDICES) == 0;
+				if (secondEntry->Matches(entry->dim, entry->format, entry->maxLevel) && sameDecode) {
 					// Reset the numInvalidated value lower, we got a match.
 					if (entry->numInvalidated > 8) {
 						--entry->numInvalidated;
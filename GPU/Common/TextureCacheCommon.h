@@ -138,6 +138,8 @@ struct TexCacheEntry {
 		STATUS_FRAMEBUFFER_OVERLAP = 0x800,
 
 		STATUS_FORCE_REBUILD = 0x1000,
+
+		STATUS_CLUT_INDICES = 0x2000,  // Holds raw CLUT indices, looked up in the fragment shader.
 	};
 
 	// Status, but int so we can zero initialize.
@@ -277,11 +279,23 @@ class TextureCacheCommon {
 	void HandleTextureChange(TexCacheEntry *const entry, const char *reason, bool initialMatch, bool doDelete);
 	virtual void BuildTexture(TexCacheEntry *const entry) = 0;
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
+	// Whether the backend can look up CLUT colors in the fragment shader (see FS_BIT_SHADER_DEPAL.)
+	virtual bool SupportsShaderDepal() const { return false; }
+	bool CanDepalettizeInShader();
+	// True when the CLUT differs from the one clutAlphaFull_ was last computed for.
+	bool ClutAlphaChanged() {
+		u64 key = ((u64)clutHash_ << 32) | ((u64)gstate.getClutPaletteFormat() << 16) | clutMaxBytes_;
+		if (key == clutAlphaKey_)
+			return false;
+		clutAlphaKey_ = key;
+		return true;
+	}
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
 
 	void DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, bool reverseColors, bool useBGRA, bool expandTo32Bit);
 	void UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel);
 	void ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool expandTo32Bit);
+	void DecodeTextureIndices(u8 *out, int outPitch, GETextureFormat format, uint32_t texaddr, int level, int bufw);
 
 	template <typename T>
 	inline const T *GetCurrentClut() {
@@ -368,6 +382,9 @@ class TextureCacheCommon {
 	// True if the clut is just alpha values in the same order (RGBA4444-bit only.)
 	bool clutAlphaLinear_;
 	u16 clutAlphaLinearColor_;
+	// Alpha of the whole CLUT, for shader depal where there's no decoded texture to check.
+	u64 clutAlphaKey_ = ~0ULL;
+	bool clutAlphaFull_ = false;
 
 	int standardScaleFactor_;
 
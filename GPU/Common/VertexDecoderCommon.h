@@ -620,6 +620,9 @@ class VertexDecoderJitCache : public FakeGen::FakeXCodeBlock {
 	JittedVertexDecoder Compile(const VertexDecoder &dec, int32_t *jittedSize);
 	void Clear();
 
+	// Only affects x86, where skinning and morph use FMA when the CPU supports it.
+	void SetAllowFMA(bool allow) { allowFMA_ = allow; }
+
 	void Jit_WeightsU8();
 	void Jit_WeightsU16();
 	void Jit_WeightsU8ToFloat();
@@ -699,8 +702,14 @@ class VertexDecoderJitCache : public FakeGen::FakeXCodeBlock {
 	void Jit_AnyS8Morph(int srcoff, int dstoff);
 	void Jit_AnyS16Morph(int srcoff, int dstoff);
 	void Jit_AnyFloatMorph(int srcoff, int dstoff);
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	void Jit_SkinAccumulate(Gen::X64Reg weight);
+	void Jit_MorphAccumulate(Gen::X64Reg reg, Gen::X64Reg weight, bool first);
+#endif
 
 	const VertexDecoder *dec_;
+	bool allowFMA_ = true;
+	bool useFMA_ = false;
 #if PPSSPP_ARCH(ARM64)
 	Arm64Gen::ARM64FloatEmitter fp;
 #endif
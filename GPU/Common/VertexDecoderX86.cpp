@@ -164,6 +164,7 @@ static const JitLookup jitLookup[] = {
 
 JittedVertexDecoder VertexDecoderJitCache::Compile(const VertexDecoder &dec, int32_t *jittedSize) {
 	dec_ = &dec;
+	useFMA_ = allowFMA_ && cpu_info.bFMA3;
 	BeginWrite();
 	const u8 *start = this->AlignCode16();
 
@@ -552,18 +553,7 @@ void VertexDecoderJitCache::Jit_WeightsU8Skin() {
 			MULPS(XMM6, R(weight));
 			MULPS(XMM7, R(weight));
 		} else {
-			MOVAPS(XMM2, MDisp(tempReg2, 0));
-			MOVAPS(XMM3, MDisp(tempReg2, 16));
-			MULPS(XMM2, R(weight));
-			MULPS(XMM3, R(weight));
-			ADDPS(XMM4, R(XMM2));
-			ADDPS(XMM5, R(XMM3));
-			MOVAPS(XMM2, MDisp(tempReg2, 32));
-			MOVAPS(XMM3, MDisp(tempReg2, 48));
-			MULPS(XMM2, R(weight));
-			MULPS(XMM3, R(weight));
-			ADDPS(XMM6, R(XMM2));
-			ADDPS(XMM7, R(XMM3));
+			Jit_SkinAccumulate(weight);
 		}
 		ADD(PTRBITS, R(tempReg2), Imm8(4 * 16));
 	}
@@ -666,23 +656,48 @@ void VertexDecoderJitCache::Jit_WeightsU16Skin() {
 			MULPS(XMM6, R(weight));
 			MULPS(XMM7, R(weight));
 		} else {
-			MOVAPS(XMM2, MDisp(tempReg2, 0));
-			MOVAPS(XMM3, MDisp(tempReg2, 16));
-			MULPS(XMM2, R(weight));
-			MULPS(XMM3, R(weight));
-			ADDPS(XMM4, R(XMM2));
-			ADDPS(XMM5, R(XMM3));
-			MOVAPS(XMM2, MDisp(tempReg2, 32));
-			MOVAPS(XMM3, MDisp(tempReg2, 48));
-			MULPS(XMM2, R(weight));
-			MULPS(XMM3, R(weight));
-			ADDPS(XMM6, R(XMM2));
-			ADDPS(XMM7, R(XMM3));
+			Jit_SkinAccumulate(weight);
 		}
 		ADD(PTRBITS, R(tempReg2), Imm8(4 * 16));
 	}
 }
 
+// Adds the bone matrix at tempReg2, scaled by weight, to XMM4-XMM7.
+void VertexDecoderJitCache::Jit_SkinAccumulate(X64Reg weight) {
+	if (useFMA_) {
+		VFMADD231PS(XMM4, weight, MDisp(tempReg2, 0));
+		VFMADD231PS(XMM5, weight, MDisp(tempReg2, 16));
+		VFMADD231PS(XMM6, weight, MDisp(tempReg2, 32));
+		VFMADD231PS(XMM7, weight, MDisp(tempReg2, 48));
+		return;
+	}
+
+	MOVAPS(XMM2, MDisp(tempReg2, 0));
+	MOVAPS(XMM3, MDisp(tempReg2, 16));
+	MULPS(XMM2, R(weight));
+	MULPS(XMM3, R(weight));
+	ADDPS(XMM4, R(XMM2));
+	ADDPS(XMM5, R(XMM3));
+	MOVAPS(XMM2, MDisp(tempReg2, 32));
+	MOVAPS(XMM3, MDisp(tempReg2, 48));
+	MULPS(XMM2, R(weight));
+	MULPS(XMM3, R(weight));
+	ADDPS(XMM6, R(XMM2));
+	ADDPS(XMM7, R(XMM3));
+}
+
+// Scales reg by weight and sums it into fpScratchReg. On the first morph frame, reg is fpScratchReg.
+void VertexDecoderJitCache::Jit_MorphAccumulate(X64Reg reg, X64Reg weight, bool first) {
+	if (first) {
+		MULPS(reg, R(weight));
+	} else if (useFMA_) {
+		VFMADD231PS(fpScratchReg, reg, R(weight));
+	} else {
+		MULPS(reg, R(weight));
+		ADDPS(fpScratchReg, R(reg));
+	}
+}
+
 void VertexDecoderJitCache::Jit_WeightsFloatSkin() {
 	MOV(PTRBITS, R(tempReg2), ImmPtr(&bones));
 	for (int j = 0; j < dec_->nweights; j++) {
@@ -698,18 +713,7 @@ void VertexDecoderJitCache::Jit_WeightsFloatSkin() {
 			MULPS(XMM6, R(XMM1));
 			MULPS(XMM7, R(XMM1));
 		} else {
-			MOVAPS(XMM2, MDisp(tempReg2, 0));
-			MOVAPS(XMM3, MDisp(tempReg2, 16));
-			MULPS(XMM2, R(XMM1));
-			MULPS(XMM3, R(XMM1));
-			ADDPS(XMM4, R(XMM2));
-			ADDPS(XMM5, R(XMM3));
-			MOVAPS(XMM2, MDisp(tempReg2, 32));
-			MOVAPS(XMM3, MDisp(tempReg2, 48));
-			MULPS(XMM2, R(XMM1));
-			MULPS(XMM3, R(XMM1));
-			ADDPS(XMM6, R(XMM2));
-			ADDPS(XMM7, R(XMM3));
+			Jit_SkinAccumulate(XMM1);
 		}
 		ADD(PTRBITS, R(tempReg2), Imm8(4 * 16));
 	}
@@ -813,13 +817,8 @@ void VertexDecoderJitCache::Jit_TcAnyMorph(int bits) {
 		// And now scale by the weight.
 		MOVSS(fpScratchReg3, MDisp(tempReg1, n * sizeof(float)));
 		SHUFPS(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
-		MULPS(reg, R(fpScratchReg3));
-
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg2));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg3, first);
+		first = false;
 	}
 }
 
@@ -1072,13 +1071,8 @@ void VertexDecoderJitCache::Jit_Color8888Morph() {
 		// And now the weight.
 		MOVSS(fpScratchReg3, MDisp(tempReg1, n * sizeof(float)));
 		SHUFPS(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
-		MULPS(reg, R(fpScratchReg3));
-
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg2));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg3, first);
+		first = false;
 	}
 
 	Jit_WriteMorphColor(dec_->decFmt.c0off);
@@ -1120,13 +1114,8 @@ void VertexDecoderJitCache::Jit_Color4444Morph() {
 		// And now the weight.
 		MOVSS(fpScratchReg3, MDisp(tempReg1, n * sizeof(float)));
 		SHUFPS(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
-		MULPS(reg, R(fpScratchReg3));
-
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg2));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg3, first);
+		first = false;
 	}
 
 	Jit_WriteMorphColor(dec_->decFmt.c0off);
@@ -1175,13 +1164,8 @@ void VertexDecoderJitCache::Jit_Color565Morph() {
 		// And now the weight.
 		MOVSS(fpScratchReg2, MDisp(tempReg1, n * sizeof(float)));
 		SHUFPS(fpScratchReg2, R(fpScratchReg2), _MM_SHUFFLE(0, 0, 0, 0));
-		MULPS(reg, R(fpScratchReg2));
-
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg3));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg2, first);
+		first = false;
 	}
 
 	Jit_WriteMorphColor(dec_->decFmt.c0off, false);
@@ -1233,13 +1217,8 @@ void VertexDecoderJitCache::Jit_Color5551Morph() {
 		// And now the weight.
 		MOVSS(fpScratchReg2, MDisp(tempReg1, n * sizeof(float)));
 		SHUFPS(fpScratchReg2, R(fpScratchReg2), _MM_SHUFFLE(0, 0, 0, 0));
-		MULPS(reg, R(fpScratchReg2));
-
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg3));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg2, first);
+		first = false;
 	}
 
 	Jit_WriteMorphColor(dec_->decFmt.c0off);
@@ -1307,7 +1286,6 @@ void VertexDecoderJitCache::Jit_NormalFloat() {
 	}
 }
 
-// This could be a bit shorter with AVX 3-operand instructions and FMA.
 void VertexDecoderJitCache::Jit_WriteMatrixMul(int outOff, bool pos) {
 	MOVAPS(XMM1, R(XMM3));
 	MOVAPS(XMM2, R(XMM3));
@@ -1315,10 +1293,15 @@ void VertexDecoderJitCache::Jit_WriteMatrixMul(int outOff, bool pos) {
 	SHUFPS(XMM2, R(XMM2), _MM_SHUFFLE(1, 1, 1, 1));
 	SHUFPS(XMM3, R(XMM3), _MM_SHUFFLE(2, 2, 2, 2));
 	MULPS(XMM1, R(XMM4));
-	MULPS(XMM2, R(XMM5));
-	MULPS(XMM3, R(XMM6));
-	ADDPS(XMM1, R(XMM2));
-	ADDPS(XMM1, R(XMM3));
+	if (useFMA_) {
+		VFMADD231PS(XMM1, XMM2, R(XMM5));
+		VFMADD231PS(XMM1, XMM3, R(XMM6));
+	} else {
+		MULPS(XMM2, R(XMM5));
+		MULPS(XMM3, R(XMM6));
+		ADDPS(XMM1, R(XMM2));
+		ADDPS(XMM1, R(XMM3));
+	}
 	if (pos) {
 		ADDPS(XMM1, R(XMM7));
 	}
@@ -1556,12 +1539,8 @@ void VertexDecoderJitCache::Jit_AnyS8Morph(int srcoff, int dstoff) {
 		MULSS(fpScratchReg3, R(XMM5));
 		SHUFPS(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
 
-		MULPS(reg, R(fpScratchReg3));
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg2));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg3, first);
+		first = false;
 	}
 
 	MOVUPS(MDisp(dstReg, dstoff), fpScratchReg);
@@ -1599,12 +1578,8 @@ void VertexDecoderJitCache::Jit_AnyS16Morph(int srcoff, int dstoff) {
 		MULSS(fpScratchReg3, R(XMM5));
 		SHUFPS(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
 
-		MULPS(reg, R(fpScratchReg3));
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg2));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg3, first);
+		first = false;
 	}
 
 	MOVUPS(MDisp(dstReg, dstoff), fpScratchReg);
@@ -1620,12 +1595,8 @@ void VertexDecoderJitCache::Jit_AnyFloatMorph(int srcoff, int dstoff) {
 		MOVUPS(reg, MDisp(srcReg, dec_->onesize_ * n + srcoff));
 		MOVSS(fpScratchReg3, MDisp(tempReg1, sizeof(float) * n));
 		SHUFPS(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
-		MULPS(reg, R(fpScratchReg3));
-		if (!first) {
-			ADDPS(fpScratchReg, R(fpScratchReg2));
-		} else {
-			first = false;
-		}
+		Jit_MorphAccumulate(reg, fpScratchReg3, first);
+		first = false;
 	}
 
 	MOVUPS(MDisp(dstReg, dstoff), fpScratchReg);
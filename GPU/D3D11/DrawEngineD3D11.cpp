@@ -19,6 +19,7 @@
 
 #include "Common/Log.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/TimeUtil.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
@@ -272,6 +273,8 @@ void DrawEngineD3D11::BeginFrame() {
 	pushVerts_->Reset();
 	pushInds_->Reset();
 
+	swTransformCache_.Decimate();
+
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 	} else {
@@ -323,8 +326,11 @@ static uint32_t SwapRB(uint32_t c) {
 
 // The inline wrapper in the header checks for numDrawCalls == 0
 void DrawEngineD3D11::DoFlush() {
+	TraceScope trace("DoFlush", "draw");
+	trace.SetArg("drawCalls", numDrawCalls);
 	gpuStats.numFlushes++;
 	gpuStats.numTrackedVertexArrays = (int)vai_.size();
+	gpuStats.numSwTransformCacheEntries = swTransformCache_.Size();
 
 	// In D3D, we're synchronous and state carries over so all we reset here on a new step is the viewport/scissor.
 	int curRenderStepId = draw_->GetCurrentStepId();
@@ -587,6 +593,7 @@ void DrawEngineD3D11::DoFlush() {
 		params.transformedExpanded = transformedExpanded;
 		params.fbman = framebufferManager_;
 		params.texCache = textureCache_;
+		params.cache = g_Config.bVertexCache ? &swTransformCache_ : nullptr;
 		params.allowClear = true;
 		params.allowSeparateAlphaClear = false;  // D3D11 doesn't support separate alpha clears
 		params.provokeFlatFirst = true;
@@ -20,6 +20,7 @@
 #include <D3Dcompiler.h>
 
 #include "Common/Common.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/System/Display.h"
 #include "Common/Math/lin/matrix4x4.h"
 #include "Common/Math/math_util.h"
@@ -327,6 +328,7 @@ void FramebufferManagerD3D11::SimpleBlit(
 }
 
 void FramebufferManagerD3D11::BlitFramebuffer(VirtualFramebuffer *dst, int dstX, int dstY, VirtualFramebuffer *src, int srcX, int srcY, int w, int h, int bpp, const char *tag) {
+	TRACE_SCOPE(tag ? tag : "BlitFramebuffer", "blit");
 	if (!dst->fbo || !src->fbo || !useBufferedRendering_) {
 		// This can happen if they recently switched from non-buffered.
 		if (useBufferedRendering_) {
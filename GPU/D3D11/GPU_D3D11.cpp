@@ -151,6 +151,12 @@ void GPU_D3D11::CheckGPUFeatures() {
 	features |= GPU_SUPPORTS_INSTANCE_RENDERING;
 	features |= GPU_SUPPORTS_TEXTURE_LOD_CONTROL;
 
+	// Integer ops in pixel shaders need ps_4_0 proper, not the 9_x levels.
+	D3D_FEATURE_LEVEL featureLevel = (D3D_FEATURE_LEVEL)draw_->GetNativeObject(Draw::NativeObject::FEATURE_LEVEL);
+	if (featureLevel >= D3D_FEATURE_LEVEL_10_0) {
+		features |= GPU_SUPPORTS_32BIT_INT_FSHADER;
+	}
+
 	uint32_t fmt4444 = draw_->GetDataFormatSupport(Draw::DataFormat::A4R4G4B4_UNORM_PACK16);
 	uint32_t fmt1555 = draw_->GetDataFormatSupport(Draw::DataFormat::A1R5G5B5_UNORM_PACK16);
 	uint32_t fmt565 = draw_->GetDataFormatSupport(Draw::DataFormat::R5G6B5_UNORM_PACK16);
@@ -226,8 +226,39 @@ void TextureCacheD3D11::BindTexture(TexCacheEntry *entry) {
 	}
 	int maxLevel = (entry->status & TexCacheEntry::STATUS_BAD_MIPS) ? 0 : entry->maxLevel;
 	SamplerCacheKey samplerKey = GetSamplingParams(maxLevel, entry->addr);
+	if (entry->status & TexCacheEntry::STATUS_CLUT_INDICES) {
+		// The shader does the filtering after the lookup, so fetch the indices unfiltered.
+		samplerKey.magFilt = false;
+		samplerKey.minFilt = false;
+		samplerKey.mipFilt = false;
+		ID3D11SamplerState *state = samplerCache_.GetOrCreateSampler(device_, samplerKey);
+		context_->PSSetSamplers(0, 1, &state);
+
+		// Only the CLUT itself needs uploading when it changes.
+		bool expand32 = !gstate_c.Supports(GPU_SUPPORTS_16BIT_FORMATS);
+		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
+		ID3D11ShaderResourceView *clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_, expand32);
+		context_->PSSetShaderResources(3, 1, &clutTexture);
+
+		gstate_c.Dirty(DIRTY_DEPAL);
+		gstate_c.SetUseShaderDepal(true);
+		gstate_c.depalFramebufferFormat = GE_FORMAT_8888;
+		if (ClutAlphaChanged()) {
+			const u32 bytesPerColor = clutFormat == GE_CMODE_32BIT_ABGR8888 ? sizeof(u32) : sizeof(u16);
+			const u32 clutTotalColors = clutMaxBytes_ / bytesPerColor;
+			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(clutBuf_, GetClutDestFormatD3D11(clutFormat), clutTotalColors, clutTotalColors, 1);
+			clutAlphaFull_ = alphaStatus == TexCacheEntry::STATUS_ALPHA_FULL;
+		}
+		gstate_c.SetTextureFullAlpha(clutAlphaFull_);
+		return;
+	}
 	ID3D11SamplerState *state = samplerCache_.GetOrCreateSampler(device_, samplerKey);
 	context_->PSSetSamplers(0, 1, &state);
+	gstate_c.SetUseShaderDepal(false);
+}
+
+bool TextureCacheD3D11::SupportsShaderDepal() const {
+	return gstate_c.Supports(GPU_SUPPORTS_32BIT_INT_FSHADER);
 }
 
 void TextureCacheD3D11::Unbind() {
@@ -429,6 +460,7 @@ void TextureCacheD3D11::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 	SamplerCacheKey samplerKey = GetFramebufferSamplingParams(framebuffer->bufferWidth, framebuffer->bufferHeight);
 	ID3D11SamplerState *state = samplerCache_.GetOrCreateSampler(device_, samplerKey);
 	context_->PSSetSamplers(0, 1, &state);
+	gstate_c.SetUseShaderDepal(false);
 
 	gstate_c.Dirty(DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_BLEND_STATE | DIRTY_FRAGMENTSHADER_STATE);
 }
@@ -518,6 +550,10 @@ void TextureCacheD3D11::BuildTexture(TexCacheEntry *const entry) {
 	}
 
 	DXGI_FORMAT dstFmt = GetDestFormat(GETextureFormat(entry->format), gstate.getClutPaletteFormat());
+	if (entry->status & TexCacheEntry::STATUS_CLUT_INDICES) {
+		// Raw indices, see DecodeTextureIndices.
+		dstFmt = DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
 
 	if (IsFakeMipmapChange()) {
 		// NOTE: Since the level is not part of the cache key, we assume it never changes.
@@ -682,7 +718,7 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 		GEPaletteFormat clutformat = gstate.getClutPaletteFormat();
 		u32 texaddr = gstate.getTextureAddress(level);
 		int bufw = GetTextureBufw(level, texaddr, tfmt);
-		int bpp = dstFmt == DXGI_FORMAT_B8G8R8A8_UNORM ? 4 : 2;
+		int bpp = dstFmt == DXGI_FORMAT_B8G8R8A8_UNORM || dstFmt == DXGI_FORMAT_R8G8B8A8_UNORM ? 4 : 2;
 		u32 *pixelData;
 		int decPitch;
 		if (scaleFactor > 1) {
@@ -705,10 +741,17 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 		}
 
 		bool expand32 = !gstate_c.Supports(GPU_SUPPORTS_16BIT_FORMATS);
-		DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, expand32);
+		if (entry.status & TexCacheEntry::STATUS_CLUT_INDICES) {
+			DecodeTextureIndices((u8 *)pixelData, decPitch, tfmt, texaddr, level, bufw);
+		} else {
+			DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, expand32);
+		}
 
 		// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
-		if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+		if (entry.status & TexCacheEntry::STATUS_CLUT_INDICES) {
+			// The alpha comes from the CLUT, BindTexture checks that.
+			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+		} else if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
 			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
 			entry.SetAlphaStatus(alphaStatus, level);
 		} else {
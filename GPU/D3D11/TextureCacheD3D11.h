@@ -65,6 +65,7 @@ class TextureCacheD3D11 : public TextureCacheCommon {
 protected:
 	void BindTexture(TexCacheEntry *entry) override;
 	void Unbind() override;
+	bool SupportsShaderDepal() const override;
 	void ReleaseTexture(TexCacheEntry *entry, bool delete_them) override;
 
 private:
@@ -19,6 +19,7 @@
 
 #include "Common/Log.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/TimeUtil.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
@@ -251,6 +252,8 @@ void DrawEngineDX9::ClearTrackedVertexArrays() {
 }
 
 void DrawEngineDX9::DecimateTrackedVertexArrays() {
+	swTransformCache_.Decimate();
+
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 	} else {
@@ -308,8 +311,11 @@ void DrawEngineDX9::BeginFrame() {
 
 // The inline wrapper in the header checks for numDrawCalls == 0
 void DrawEngineDX9::DoFlush() {
+	TraceScope trace("DoFlush", "draw");
+	trace.SetArg("drawCalls", numDrawCalls);
 	gpuStats.numFlushes++;
 	gpuStats.numTrackedVertexArrays = (int)vai_.size();
+	gpuStats.numSwTransformCacheEntries = swTransformCache_.Size();
 
 	// In D3D, we're synchronous and state carries over so all we reset here on a new step is the viewport/scissor.
 	int curRenderStepId = draw_->GetCurrentStepId();
@@ -552,6 +558,7 @@ void DrawEngineDX9::DoFlush() {
 		params.transformedExpanded = transformedExpanded;
 		params.fbman = framebufferManager_;
 		params.texCache = textureCache_;
+		params.cache = g_Config.bVertexCache ? &swTransformCache_ : nullptr;
 		params.allowClear = true;
 		params.allowSeparateAlphaClear = true;
 		params.provokeFlatFirst = true;
@@ -27,6 +27,7 @@
 
 #include "Common/GPU/OpenGL/GLDebugLog.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
 
 #include "GPU/Math3D.h"
 #include "GPU/GPUState.h"
@@ -265,6 +266,8 @@ void DrawEngineGLES::ClearTrackedVertexArrays() {
 }
 
 void DrawEngineGLES::DecimateTrackedVertexArrays() {
+	swTransformCache_.Decimate();
+
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 	} else {
@@ -304,11 +307,14 @@ void DrawEngineGLES::FreeVertexArray(VertexArrayInfo *vai) {
 
 void DrawEngineGLES::DoFlush() {
 	PROFILE_THIS_SCOPE("flush");
+	TraceScope trace("DoFlush", "draw");
+	trace.SetArg("drawCalls", numDrawCalls);
 
 	FrameData &frameData = frameData_[render_->GetCurFrame()];
 	
 	gpuStats.numFlushes++;
 	gpuStats.numTrackedVertexArrays = (int)vai_.size();
+	gpuStats.numSwTransformCacheEntries = swTransformCache_.Size();
 
 	// A new render step means we need to flush any dynamic state. Really, any state that is reset in
 	// GLQueueRunner::PerformRenderPass.
@@ -563,6 +569,7 @@ void DrawEngineGLES::DoFlush() {
 		params.transformedExpanded = transformedExpanded;
 		params.fbman = framebufferManager_;
 		params.texCache = textureCache_;
+		params.cache = g_Config.bVertexCache ? &swTransformCache_ : nullptr;
 		params.allowClear = true;
 		params.allowSeparateAlphaClear = true;
 		params.provokeFlatFirst = false;
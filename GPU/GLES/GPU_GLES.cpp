@@ -104,6 +104,9 @@ GPU_GLES::GPU_GLES(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".glshadercache";
+		shaderUsagePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".shaderusage";
+		// Needed first, the precompile order comes from it.
+		shaderManagerGL_->Usage().Load(shaderUsagePath_);
 		// Actually precompiled by IsReady() since we're single-threaded.
 		shaderManagerGL_->Load(shaderCachePath_);
 	}
@@ -129,6 +132,7 @@ GPU_GLES::~GPU_GLES() {
 
 	if (!shaderCachePath_.empty() && draw_) {
 		shaderManagerGL_->Save(shaderCachePath_);
+		shaderManagerGL_->Usage().Save(shaderUsagePath_);
 	}
 
 	framebufferManagerGL_->DestroyAllFBOs();
@@ -255,7 +259,10 @@ void GPU_GLES::CheckGPUFeatures() {
 }
 
 bool GPU_GLES::IsReady() {
-	return shaderManagerGL_->ContinuePrecompile();
+	if (shaderManagerGL_->ContinuePrecompile())
+		return true;
+	// Past the boot budget, let the game start. BeginHostFrame compiles the rest a slice at a time.
+	return shaderManagerGL_->PrecompileElapsed() >= SHADER_PRECOMPILE_BOOT_BUDGET;
 }
 
 void  GPU_GLES::CancelReady() {
@@ -334,6 +341,8 @@ void GPU_GLES::BeginHostFrame() {
 		resized_ = false;
 	}
 
+	shaderManagerGL_->ContinuePrecompile(SHADER_PRECOMPILE_FRAME_SLICE);
+
 	drawEngine_.BeginFrame();
 }
 
@@ -355,6 +364,7 @@ void GPU_GLES::BeginFrame() {
 	// Save the cache from time to time. TODO: How often? We save on exit, so shouldn't need to do this all that often.
 	if (!shaderCachePath_.empty() && (gpuStats.numFlips & 4095) == 0) {
 		shaderManagerGL_->Save(shaderCachePath_);
+		shaderManagerGL_->Usage().Save(shaderUsagePath_);
 	}
 
 	shaderManagerGL_->DirtyShader();
@@ -87,4 +87,5 @@ class GPU_GLES : public GPUCommon {
 	ShaderManagerGLES *shaderManagerGL_;
 
 	std::string shaderCachePath_;
+	std::string shaderUsagePath_;
 };
@@ -723,6 +723,7 @@ LinkedShader *ShaderManagerGLES::ApplyFragmentShader(VShaderID VSID, Shader *vs,
 	}
 
 	lastFSID_ = FSID;
+	usage_.NoteShaders(VSID, FSID);
 
 	Shader *fs = fsCache_.Get(FSID);
 	if (!fs)	{
@@ -906,6 +907,11 @@ void ShaderManagerGLES::Load(const std::string &filename) {
 		diskCachePending_.link.push_back(std::make_pair(vsid, fsid));
 	}
 
+	// Most used first, so the boot time budget goes to the shaders that matter.
+	usage_.SortVertexShaders(diskCachePending_.vert);
+	usage_.SortFragmentShaders(diskCachePending_.frag);
+	usage_.SortPrograms(diskCachePending_.link);
+
 	// Actual compilation happens in ContinuePrecompile(), called by GPU_GLES's IsReady.
 	NOTICE_LOG(G3D, "Precompiling the shader cache from '%s'", filename.c_str());
 	diskCacheDirty_ = false;
@@ -923,64 +929,63 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 	// Let's try to keep it under sliceTime if possible.
 	double end = start + sliceTime;
 
-	for (size_t &i = pending.vertPos; i < pending.vert.size(); i++) {
+	// Programs go first, compiling their shaders as needed, since they carry the usage order.
+	for (size_t &i = pending.linkPos; i < pending.link.size(); i++) {
 		if (time_now_d() >= end) {
 			// We'll finish later.
 			return false;
 		}
 
-		const VShaderID &id = pending.vert[i];
-		if (!vsCache_.Get(id)) {
-			if (id.Bit(VS_BIT_IS_THROUGH) && id.Bit(VS_BIT_USE_HW_TRANSFORM)) {
-				// Clearly corrupt, bailing.
-				ERROR_LOG_REPORT(G3D, "Corrupt shader cache: Both IS_THROUGH and USE_HW_TRANSFORM set.");
-				pending.Clear();
+		const VShaderID &vsid = pending.link[i].first;
+		const FShaderID &fsid = pending.link[i].second;
+		Shader *vs = vsCache_.Get(vsid);
+		if (!vs) {
+			vs = PrecompileVertexShader(vsid);
+			if (!vs)
 				return false;
-			}
+		}
+		Shader *fs = fsCache_.Get(fsid);
+		if (!fs) {
+			fs = CompileFragmentShader(fsid);
+			fsCache_.Insert(fsid, fs);
+		}
 
-			Shader *vs = CompileVertexShader(id);
-			if (vs->Failed()) {
-				// Give up on using the cache, just bail. We can't safely create the fallback shaders here
-				// without trying to deduce the vertType from the VSID.
-				ERROR_LOG(G3D, "Failed to compile a vertex shader loading from cache. Skipping rest of shader cache.");
-				delete vs;
-				pending.Clear();
-				return false;
+		// The game may already have linked this one if it started before we got here.
+		bool found = false;
+		for (const auto &entry : linkedShaderCache_) {
+			if (entry.vs == vs && entry.fs == fs) {
+				found = true;
+				break;
 			}
-			vsCache_.Insert(id, vs);
-		} else {
-			WARN_LOG(G3D, "Duplicate vertex shader found in GL shader cache, ignoring");
+		}
+		if (!found) {
+			LinkedShader *ls = new LinkedShader(render_, vsid, vs, fsid, fs, vs->UseHWTransform(), true);
+			LinkedShaderCacheEntry entry(vs, fs, ls);
+			linkedShaderCache_.push_back(entry);
 		}
 	}
 
-	for (size_t &i = pending.fragPos; i < pending.frag.size(); i++) {
+	for (size_t &i = pending.vertPos; i < pending.vert.size(); i++) {
 		if (time_now_d() >= end) {
 			// We'll finish later.
 			return false;
 		}
 
-		const FShaderID &id = pending.frag[i];
-		if (!fsCache_.Get(id)) {
-			fsCache_.Insert(id, CompileFragmentShader(id));
-		} else {
-			WARN_LOG(G3D, "Duplicate fragment shader found in GL shader cache, ignoring");
+		const VShaderID &id = pending.vert[i];
+		if (!vsCache_.Get(id) && !PrecompileVertexShader(id)) {
+			return false;
 		}
 	}
 
-	for (size_t &i = pending.linkPos; i < pending.link.size(); i++) {
+	for (size_t &i = pending.fragPos; i < pending.frag.size(); i++) {
 		if (time_now_d() >= end) {
 			// We'll finish later.
 			return false;
 		}
 
-		const VShaderID &vsid = pending.link[i].first;
-		const FShaderID &fsid = pending.link[i].second;
-		Shader *vs = vsCache_.Get(vsid);
-		Shader *fs = fsCache_.Get(fsid);
-		if (vs && fs) {
-			LinkedShader *ls = new LinkedShader(render_, vsid, vs, fsid, fs, vs->UseHWTransform(), true);
-			LinkedShaderCacheEntry entry(vs, fs, ls);
-			linkedShaderCache_.push_back(entry);
+		const FShaderID &id = pending.frag[i];
+		if (!fsCache_.Get(id)) {
+			fsCache_.Insert(id, CompileFragmentShader(id));
 		}
 	}
 
@@ -993,6 +998,34 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 	return true;
 }
 
+Shader *ShaderManagerGLES::PrecompileVertexShader(const VShaderID &id) {
+	auto &pending = diskCachePending_;
+	if (id.Bit(VS_BIT_IS_THROUGH) && id.Bit(VS_BIT_USE_HW_TRANSFORM)) {
+		// Clearly corrupt, bailing.
+		ERROR_LOG_REPORT(G3D, "Corrupt shader cache: Both IS_THROUGH and USE_HW_TRANSFORM set.");
+		pending.Clear();
+		return nullptr;
+	}
+
+	Shader *vs = CompileVertexShader(id);
+	if (vs->Failed()) {
+		// Give up on using the cache, just bail. We can't safely create the fallback shaders here
+		// without trying to deduce the vertType from the VSID.
+		ERROR_LOG(G3D, "Failed to compile a vertex shader loading from cache. Skipping rest of shader cache.");
+		delete vs;
+		pending.Clear();
+		return nullptr;
+	}
+	vsCache_.Insert(id, vs);
+	return vs;
+}
+
+double ShaderManagerGLES::PrecompileElapsed() {
+	if (diskCachePending_.Done())
+		return 0.0;
+	return time_now_d() - diskCachePending_.start;
+}
+
 void ShaderManagerGLES::CancelPrecompile() {
 	diskCachePending_.Clear();
 }
@@ -164,6 +164,8 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 
 	void Load(const std::string &filename);
 	bool ContinuePrecompile(float sliceTime = 1.0f / 60.0f);
+	// Seconds since Load started precompiling, or 0 if there's nothing left to do.
+	double PrecompileElapsed();
 	void CancelPrecompile();
 	void Save(const std::string &filename);
 
@@ -171,6 +173,7 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 	void Clear();
 	Shader *CompileFragmentShader(FShaderID id);
 	Shader *CompileVertexShader(VShaderID id);
+	Shader *PrecompileVertexShader(const VShaderID &id);
 
 	struct LinkedShaderCacheEntry {
 		LinkedShaderCacheEntry(Shader *vs_, Shader *fs_, LinkedShader *ls_)
@@ -230,10 +230,42 @@ void TextureCacheGLES::BindTexture(TexCacheEntry *entry) {
 	}
 	int maxLevel = (entry->status & TexCacheEntry::STATUS_BAD_MIPS) ? 0 : entry->maxLevel;
 	SamplerCacheKey samplerKey = GetSamplingParams(maxLevel, entry->addr);
+	if (entry->status & TexCacheEntry::STATUS_CLUT_INDICES) {
+		// The shader does the filtering after the lookup, so fetch the indices unfiltered.
+		samplerKey.magFilt = false;
+		samplerKey.minFilt = false;
+		samplerKey.mipEnable = false;
+		ApplySamplingParams(samplerKey);
+
+		// Only the CLUT itself needs uploading when it changes.
+		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
+		GLRTexture *clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_);
+		render_->BindTexture(TEX_SLOT_CLUT, clutTexture);
+		render_->SetTextureSampler(TEX_SLOT_CLUT, GL_REPEAT, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST, 0.0f);
+
+		gstate_c.Dirty(DIRTY_DEPAL);
+		gstate_c.SetUseShaderDepal(true);
+		gstate_c.depalFramebufferFormat = GE_FORMAT_8888;
+		if (ClutAlphaChanged()) {
+			const u32 bytesPerColor = clutFormat == GE_CMODE_32BIT_ABGR8888 ? sizeof(u32) : sizeof(u16);
+			const u32 clutTotalColors = clutMaxBytes_ / bytesPerColor;
+			TexCacheEntry::TexStatus alphaStatus = CheckAlpha((const uint8_t *)clutBuf_, getClutDestFormat(clutFormat), clutTotalColors, clutTotalColors, 1);
+			clutAlphaFull_ = alphaStatus == TexCacheEntry::STATUS_ALPHA_FULL;
+		}
+		gstate_c.SetTextureFullAlpha(clutAlphaFull_);
+		return;
+	}
 	ApplySamplingParams(samplerKey);
 	gstate_c.SetUseShaderDepal(false);
 }
 
+bool TextureCacheGLES::SupportsShaderDepal() const {
+	if (!gstate_c.Supports(GPU_SUPPORTS_32BIT_INT_FSHADER)) {
+		return false;
+	}
+	return gstate_c.Supports(GPU_SUPPORTS_GLSL_ES_300) || gstate_c.Supports(GPU_SUPPORTS_GLSL_330);
+}
+
 void TextureCacheGLES::Unbind() {
 	render_->BindTexture(TEX_SLOT_PSP_TEXTURE, nullptr);
 	InvalidateLastTexture();
@@ -347,10 +379,7 @@ void TextureCacheGLES::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 	uint32_t clutMode = gstate.clutformat & 0xFFFFFF;
 	bool need_depalettize = IsClutFormat(texFormat);
 
-	bool useShaderDepal = framebufferManager_->GetCurrentRenderVFB() != framebuffer && (gstate_c.Supports(GPU_SUPPORTS_GLSL_ES_300) || gstate_c.Supports(GPU_SUPPORTS_GLSL_330));
-	if (!gstate_c.Supports(GPU_SUPPORTS_32BIT_INT_FSHADER)) {
-		useShaderDepal = false;
-	}
+	bool useShaderDepal = framebufferManager_->GetCurrentRenderVFB() != framebuffer && SupportsShaderDepal();
 
 	if (need_depalettize && !g_Config.bDisableSlowFramebufEffects) {
 		if (useShaderDepal) {
@@ -492,6 +521,10 @@ void TextureCacheGLES::BuildTexture(TexCacheEntry *const entry) {
 
 	// If GLES3 is available, we can preallocate the storage, which makes texture loading more efficient.
 	Draw::DataFormat dstFmt = GetDestFormat(GETextureFormat(entry->format), gstate.getClutPaletteFormat());
+	if (entry->status & TexCacheEntry::STATUS_CLUT_INDICES) {
+		// Raw indices, see DecodeTextureIndices.
+		dstFmt = Draw::DataFormat::R8G8B8A8_UNORM;
+	}
 
 	int scaleFactor = standardScaleFactor_;
 
@@ -673,14 +706,20 @@ void TextureCacheGLES::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &r
 		decPitch = std::max(w * pixelSize, 4);
 
 		pixelData = (uint8_t *)AllocateAlignedMemory(decPitch * h * pixelSize, 16);
-		DecodeTextureLevel(pixelData, decPitch, GETextureFormat(entry.format), clutformat, texaddr, level, bufw, true, false, false);
-
-		// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
-		if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
-			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / pixelSize, w, h);
-			entry.SetAlphaStatus(alphaStatus, level);
-		} else {
+		if (entry.status & TexCacheEntry::STATUS_CLUT_INDICES) {
+			DecodeTextureIndices(pixelData, decPitch, GETextureFormat(entry.format), texaddr, level, bufw);
+			// The alpha comes from the CLUT, BindTexture checks that.
 			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+		} else {
+			DecodeTextureLevel(pixelData, decPitch, GETextureFormat(entry.format), clutformat, texaddr, level, bufw, true, false, false);
+
+			// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
+			if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+				TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / pixelSize, w, h);
+				entry.SetAlphaStatus(alphaStatus, level);
+			} else {
+				entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			}
 		}
 
 		if (scaleFactor > 1) {
@@ -77,6 +77,7 @@ class TextureCacheGLES : public TextureCacheCommon {
 
 	static TexCacheEntry::TexStatus CheckAlpha(const uint8_t *pixelData, Draw::DataFormat dstFmt, int stride, int w, int h);
 	void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) override;
+	bool SupportsShaderDepal() const override;
 	void ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, GETextureFormat texFormat, FramebufferNotificationChannel channel) override;
 
 	void BuildTexture(TexCacheEntry *const entry) override;
@@ -70,6 +70,9 @@ struct GPUStatistics {
 		numTextureDataBytesHashed = 0;
 		numShaderSwitches = 0;
 		numFlushes = 0;
+		numSwTransformCacheHits = 0;
+		numSwTransformCacheMisses = 0;
+		numSwTransformCacheEntries = 0;
 		numTexturesDecoded = 0;
 		numFramebufferEvaluations = 0;
 		numReadbacks = 0;
@@ -89,6 +92,9 @@ struct GPUStatistics {
 	int numCachedVertsDrawn;
 	int numUncachedVertsDrawn;
 	int numTrackedVertexArrays;
+	int numSwTransformCacheHits;
+	int numSwTransformCacheMisses;
+	int numSwTransformCacheEntries;
 	int numTextureInvalidations;
 	int numTextureInvalidationsByFramebuffer;
 	int numTexturesHashed;
@@ -3,6 +3,7 @@
 #include <mutex>
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
 
 #include "Common/ColorConv.h"
 #include "Common/GraphicsContext.h"
@@ -16,6 +17,7 @@
 #include "GPU/GPUCommon.h"
 #include "GPU/GPUState.h"
 #include "Core/Config.h"
+#include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/MemMap.h"
 #include "Core/Host.h"
@@ -380,6 +382,9 @@ GPUCommon::GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw) :
 	// you'd expect due to the int64 field, but the Linux ABI apparently does not require that.
 	static_assert(sizeof(DisplayList) == 456, "Bad DisplayList size");
 
+	// The backend constructors load the shader caches, so this covers that.
+	bootStart_ = time_now_d();
+
 	Reinitialize();
 	SetupColorConv();
 	gstate.Reset();
@@ -960,6 +965,7 @@ void GPUCommon::NotifySteppingExit() {
 }
 
 bool GPUCommon::InterpretList(DisplayList &list) {
+	TRACE_SCOPE("InterpretList", "gpu");
 	// Initialized to avoid a race condition with bShowDebugStats changing.
 	double start = 0.0;
 	if (coreCollectDebugStats) {
@@ -1076,6 +1082,8 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 }
 
 void GPUCommon::BeginFrame() {
+	if (Trace_IsActive())
+		Trace_AddInstant("BeginFrame", "gpu");
 	immCount_ = 0;
 	if (dumpNextFrame_) {
 		NOTICE_LOG(G3D, "DUMPING THIS FRAME");
@@ -1085,6 +1093,29 @@ void GPUCommon::BeginFrame() {
 		dumpThisFrame_ = false;
 	}
 	GPURecord::NotifyFrame();
+	UpdateBootStats();
+}
+
+void GPUCommon::UpdateBootStats() {
+	// How long after the first frame we count hitches, and what counts as one.
+	const double BOOT_HITCH_WINDOW = 30.0;
+	const double BOOT_HITCH_TIME = 0.05;
+
+	if (bootStatsReported_)
+		return;
+
+	double now = time_now_d();
+	if (firstFrame_ == 0.0) {
+		firstFrame_ = now;
+		NOTICE_LOG(G3D, "Time to first frame: %0.1f ms", (now - bootStart_) * 1000.0);
+	} else if (now - firstFrame_ < BOOT_HITCH_WINDOW) {
+		if (now - lastFrame_ >= BOOT_HITCH_TIME && !Core_IsStepping())
+			bootHitches_++;
+	} else {
+		NOTICE_LOG(G3D, "Hitches over %d ms in the first %d seconds: %d", (int)(BOOT_HITCH_TIME * 1000.0), (int)BOOT_HITCH_WINDOW, bootHitches_);
+		bootStatsReported_ = true;
+	}
+	lastFrame_ = now;
 }
 
 void GPUCommon::SlowRunLoop(DisplayList &list)
@@ -2894,6 +2925,7 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		"DL processing time: %0.2f ms\n"
 		"Draw calls: %d, flushes %d, clears %d (cached: %d)\n"
 		"Num Tracked Vertex Arrays: %d\n"
+		"SW transform cache: %d hits, %d misses, %d entries\n"
 		"Commands per call level: %i %i %i %i\n"
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
@@ -2906,6 +2938,9 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numClears,
 		gpuStats.numCachedDrawCalls,
 		gpuStats.numTrackedVertexArrays,
+		gpuStats.numSwTransformCacheHits,
+		gpuStats.numSwTransformCacheMisses,
+		gpuStats.numSwTransformCacheEntries,
 		gpuStats.gpuCommandsAtCallLevel[0], gpuStats.gpuCommandsAtCallLevel[1], gpuStats.gpuCommandsAtCallLevel[2], gpuStats.gpuCommandsAtCallLevel[3],
 		gpuStats.numVertsSubmitted,
 		gpuStats.numCachedVertsDrawn,
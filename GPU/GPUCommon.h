@@ -365,10 +365,18 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 private:
 	void FlushImm();
+	void UpdateBootStats();
 	// Debug stats.
 	double timeSteppingStarted_;
 	double timeSpentStepping_;
 	int lastVsync_ = -1;
+
+	// Boot experience: time to first frame, then long frames early in the game.
+	double bootStart_ = 0.0;
+	double firstFrame_ = 0.0;
+	double lastFrame_ = 0.0;
+	int bootHitches_ = 0;
+	bool bootStatsReported_ = false;
 };
 
 struct CommonCommandTableEntry {
@@ -19,6 +19,7 @@
 
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 
 #include "Common/Log.h"
@@ -306,6 +307,8 @@ void DrawEngineVulkan::BeginFrame() {
 		descDecimationCounter_ = DESCRIPTORSET_DECIMATION_INTERVAL;
 	}
 
+	swTransformCache_.Decimate();
+
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 
@@ -576,9 +579,12 @@ void MarkUnreliable(VertexArrayInfoVulkan *vai) {
 // The inline wrapper in the header checks for numDrawCalls == 0
 void DrawEngineVulkan::DoFlush() {
 	PROFILE_THIS_SCOPE("Flush");
+	TraceScope trace("DoFlush", "draw");
+	trace.SetArg("drawCalls", numDrawCalls);
 	gpuStats.numFlushes++;
 	// TODO: Should be enough to update this once per frame?
 	gpuStats.numTrackedVertexArrays = (int)vai_.size();
+	gpuStats.numSwTransformCacheEntries = swTransformCache_.Size();
 
 	VulkanRenderManager *renderManager = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
 	
@@ -825,7 +831,8 @@ void DrawEngineVulkan::DoFlush() {
 			VkRenderPass renderPass = (VkRenderPass)draw_->GetNativeObject(object);
 			VulkanPipeline *pipeline = pipelineManager_->GetOrCreatePipeline(pipelineLayout_, renderPass, pipelineKey_, &dec_->decFmt, vshader, fshader, true);
 			if (!pipeline || !pipeline->pipeline) {
-				// Already logged, let's bail out.
+				// Already logged or still compiling, let's bail out.
+				ResetAfterDraw();
 				return;
 			}
 			BindShaderBlendTex();  // This might cause copies so important to do before BindPipeline.
@@ -902,6 +909,7 @@ void DrawEngineVulkan::DoFlush() {
 		params.transformedExpanded = transformedExpanded;
 		params.fbman = framebufferManager_;
 		params.texCache = textureCache_;
+		params.cache = g_Config.bVertexCache ? &swTransformCache_ : nullptr;
 		// We have to force drawing of primitives if !framebufferManager_->UseBufferedRendering() because Vulkan clears
 		// do not respect scissor rects.
 		params.allowClear = framebufferManager_->UseBufferedRendering();
@@ -948,7 +956,8 @@ void DrawEngineVulkan::DoFlush() {
 				VkRenderPass renderPass = (VkRenderPass)draw_->GetNativeObject(object);
 				VulkanPipeline *pipeline = pipelineManager_->GetOrCreatePipeline(pipelineLayout_, renderPass, pipelineKey_, &dec_->decFmt, vshader, fshader, false);
 				if (!pipeline || !pipeline->pipeline) {
-					// Already logged, let's bail out.
+					// Already logged or still compiling, let's bail out.
+					ResetAfterDraw();
 					return;
 				}
 				BindShaderBlendTex();  // This might cause copies so super important to do before BindPipeline.
@@ -1024,6 +1033,12 @@ void DrawEngineVulkan::DoFlush() {
 	gpuStats.numDrawCalls += numDrawCalls;
 	gpuStats.numVertsSubmitted += vertexCountInDrawCalls_;
 
+	ResetAfterDraw();
+
+	GPUDebug::NotifyDraw();
+}
+
+void DrawEngineVulkan::ResetAfterDraw() {
 	indexGen.Reset();
 	decodedVerts_ = 0;
 	numDrawCalls = 0;
@@ -1039,8 +1054,6 @@ void DrawEngineVulkan::DoFlush() {
 	gstate_c.vertBounds.minV = 512;
 	gstate_c.vertBounds.maxU = 0;
 	gstate_c.vertBounds.maxV = 0;
-
-	GPUDebug::NotifyDraw();
 }
 
 void DrawEngineVulkan::UpdateUBOs(FrameData *frame) {
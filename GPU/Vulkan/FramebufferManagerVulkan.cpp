@@ -18,6 +18,7 @@
 #include <algorithm>
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
 
 #include "Common/System/Display.h"
 #include "Common/Math/lin/matrix4x4.h"
@@ -235,6 +236,7 @@ void FramebufferManagerVulkan::Bind2DShader() {
 }
 
 void FramebufferManagerVulkan::BlitFramebuffer(VirtualFramebuffer *dst, int dstX, int dstY, VirtualFramebuffer *src, int srcX, int srcY, int w, int h, int bpp, const char *tag) {
+	TRACE_SCOPE(tag ? tag : "BlitFramebuffer", "blit");
 	if (!dst->fbo || !src->fbo || !useBufferedRendering_) {
 		// This can happen if they recently switched from non-buffered.
 		if (useBufferedRendering_) {
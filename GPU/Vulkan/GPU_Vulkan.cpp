@@ -104,7 +104,10 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".vkshadercache";
+		shaderUsagePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".shaderusage";
 		shaderCacheLoaded_ = false;
+		// Needed first, the precompile order comes from it.
+		shaderManagerVulkan_->Usage().Load(shaderUsagePath_);
 
 		std::thread th([&] {
 			LoadCache(shaderCachePath_);
@@ -164,6 +167,7 @@ void GPU_Vulkan::SaveCache(std::string filename) {
 	pipelineManager_->SaveCache(f, false, shaderManagerVulkan_, draw_);
 	INFO_LOG(G3D, "Saved Vulkan pipeline cache");
 	fclose(f);
+	shaderManagerVulkan_->Usage().Save(shaderUsagePath_);
 }
 
 GPU_Vulkan::~GPU_Vulkan() {
@@ -300,6 +304,8 @@ void GPU_Vulkan::BeginHostFrame() {
 	}
 
 	textureCacheVulkan_->StartFrame();
+	// Cached pipelines that didn't fit in the boot budget.
+	pipelineManager_->ContinueLoadCache(time_now_d() + SHADER_PRECOMPILE_FRAME_SLICE);
 
 	int curFrame = vulkan_->GetCurFrame();
 	FrameData &frame = frameData_[curFrame];
@@ -563,13 +569,18 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 	const DrawEngineVulkanStats &drawStats = drawEngine_.GetStats();
 	char texStats[256];
 	textureCacheVulkan_->GetStats(texStats, sizeof(texStats));
+	float p50, p90, p99, maxTime;
+	pipelineManager_->GetCompileTimeStats(&p50, &p90, &p99, &maxTime);
 	snprintf(buffer, bufsize,
-		"Vertex, Fragment, Pipelines loaded: %i, %i, %i\n"
+		"Vertex, Fragment, Pipelines loaded: %i, %i, %i (%i pending)\n"
+		"Pipeline compile ms p50/p90/p99/max: %0.1f/%0.1f/%0.1f/%0.1f\n"
 		"Pushbuffer space used: UBO %d, Vtx %d, Idx %d\n"
 		"%s\n",
 		shaderManagerVulkan_->GetNumVertexShaders(),
 		shaderManagerVulkan_->GetNumFragmentShaders(),
 		pipelineManager_->GetNumPipelines(),
+		pipelineManager_->GetNumPendingPipelines(),
+		p50, p90, p99, maxTime,
 		drawStats.pushUBOSpaceUsed,
 		drawStats.pushVertexSpaceUsed,
 		drawStats.pushIndexSpaceUsed,
@@ -109,5 +109,6 @@ class GPU_Vulkan : public GPUCommon {
 	FrameData frameData_[VulkanContext::MAX_INFLIGHT_FRAMES]{};
 
 	std::string shaderCachePath_;
+	std::string shaderUsagePath_;
 	bool shaderCacheLoaded_ = false;
 };
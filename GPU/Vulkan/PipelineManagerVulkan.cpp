@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <set>
@@ -7,6 +8,9 @@
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "GPU/Vulkan/VulkanUtil.h"
 #include "GPU/Vulkan/PipelineManagerVulkan.h"
@@ -21,6 +25,7 @@ PipelineManagerVulkan::PipelineManagerVulkan(VulkanContext *vulkan) : vulkan_(vu
 }
 
 PipelineManagerVulkan::~PipelineManagerVulkan() {
+	StopCompileThreads();
 	Clear();
 	if (pipelineCache_ != VK_NULL_HANDLE)
 		vulkan_->Delete().QueueDeletePipelineCache(pipelineCache_);
@@ -30,6 +35,7 @@ void PipelineManagerVulkan::Clear() {
 	// This should kill off all the shaders at once.
 	// This could also be an opportunity to store the whole cache to disk. Will need to also
 	// store the keys.
+	WaitForCompiles();
 
 	pipelines_.Iterate([&](const VulkanPipelineKey &key, VulkanPipeline *value) {
 		if (value->pipeline)
@@ -41,7 +47,10 @@ void PipelineManagerVulkan::Clear() {
 }
 
 void PipelineManagerVulkan::DeviceLost() {
+	StopCompileThreads();
 	Clear();
+	pendingCache_.clear();
+	pendingCachePos_ = 0;
 	if (pipelineCache_ != VK_NULL_HANDLE)
 		vulkan_->Delete().QueueDeletePipelineCache(pipelineCache_);
 }
@@ -140,7 +149,7 @@ static bool UsesBlendConstant(int factor) {
 
 static VulkanPipeline *CreateVulkanPipeline(VkDevice device, VkPipelineCache pipelineCache, 
 		VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &key,
-		const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform, float lineWidth) {
+		const DecVtxFormat *decFmt, VkShaderModule vsModule, VkShaderModule fsModule, bool needsUV, bool needsColor1, bool useHwTransform, float lineWidth) {
 	PROFILE_THIS_SCOPE("pipelinebuild");
 	bool useBlendConstant = false;
 
@@ -221,13 +230,13 @@ static VulkanPipeline *CreateVulkanPipeline(VkDevice device, VkPipelineCache pip
 	ss[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	ss[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
 	ss[0].pSpecializationInfo = nullptr;
-	ss[0].module = vs->GetModule();
+	ss[0].module = vsModule;
 	ss[0].pName = "main";
 	ss[0].flags = 0;
 	ss[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	ss[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	ss[1].pSpecializationInfo = nullptr;
-	ss[1].module = fs->GetModule();
+	ss[1].module = fsModule;
 	ss[1].pName = "main";
 	ss[1].flags = 0;
 
@@ -253,8 +262,6 @@ static VulkanPipeline *CreateVulkanPipeline(VkDevice device, VkPipelineCache pip
 		attributeCount = SetupVertexAttribs(attrs, *decFmt);
 		vertexStride = decFmt->stride;
 	} else {
-		bool needsUV = vs->GetID().Bit(VS_BIT_DO_TEXTURE);
-		bool needsColor1 = vs->GetID().Bit(VS_BIT_LMODE);
 		attributeCount = SetupVertexAttribsPretransformed(attrs, needsUV, needsColor1);
 		vertexStride = 36;
 	}
@@ -349,12 +356,46 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VkPipelineLayout layo
 	key.vtxFmtId = useHwTransform ? decFmt->id : 0;
 
 	auto iter = pipelines_.Get(key);
-	if (iter)
-		return iter;
+	if (iter) {
+		// Still compiling in the background, skip the draw for now.
+		if (!iter->ready.load(std::memory_order_acquire))
+			return nullptr;
+		return iter->pipeline ? iter : nullptr;
+	}
+
+	bool needsUV = vs->GetID().Bit(VS_BIT_DO_TEXTURE);
+	bool needsColor1 = vs->GetID().Bit(VS_BIT_LMODE);
+
+	if (g_Config.bVulkanAsyncPipelines) {
+		// Insert a placeholder right away so we only queue each pipeline once.
+		VulkanPipeline *pending = new VulkanPipeline();
+		pending->pipeline = VK_NULL_HANDLE;
+		pending->flags = 0;
+		pending->ready.store(false, std::memory_order_relaxed);
+		pipelines_.Insert(key, pending);
+
+		CompileJob job{};
+		job.target = pending;
+		job.layout = layout;
+		job.renderPass = renderPass;
+		job.raster = rasterKey;
+		if (useHwTransform)
+			job.decFmt = *decFmt;
+		job.vsModule = vs->GetModule();
+		job.fsModule = fs->GetModule();
+		job.needsUV = needsUV;
+		job.needsColor1 = needsColor1;
+		job.useHwTransform = useHwTransform;
+		job.lineWidth = lineWidth_;
+		QueueCompile(job);
+		return nullptr;
+	}
 
+	double start = time_now_d();
 	VulkanPipeline *pipeline = CreateVulkanPipeline(
 		vulkan_->GetDevice(), pipelineCache_, layout, renderPass, 
-		rasterKey, decFmt, vs, fs, useHwTransform, lineWidth_);
+		rasterKey, decFmt, vs->GetModule(), fs->GetModule(), needsUV, needsColor1, useHwTransform, lineWidth_);
+	RecordCompileTime(time_now_d() - start);
 	pipelines_.Insert(key, pipeline);
 
 	// Don't return placeholder null pipelines.
@@ -365,11 +406,114 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VkPipelineLayout layo
 	}
 }
 
+void PipelineManagerVulkan::QueueCompile(const CompileJob &job) {
+	std::unique_lock<std::mutex> guard(compileLock_);
+	if (compileThreads_.empty()) {
+		// Leave some cores for the emulator and GPU threads.
+		int numThreads = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() / 2));
+		compileStop_ = false;
+		for (int i = 0; i < numThreads; i++)
+			compileThreads_.push_back(std::thread(&PipelineManagerVulkan::CompileThreadFunc, this));
+	}
+	compileQueue_.push_back(job);
+	compilesPending_++;
+	compileCond_.notify_one();
+}
+
+void PipelineManagerVulkan::CompileThreadFunc() {
+	setCurrentThreadName("PipelineCompile");
+
+	std::unique_lock<std::mutex> guard(compileLock_);
+	while (true) {
+		compileCond_.wait(guard, [&] { return compileStop_ || !compileQueue_.empty(); });
+		if (compileQueue_.empty())
+			break;
+
+		CompileJob job = compileQueue_.front();
+		compileQueue_.pop_front();
+		guard.unlock();
+
+		// The pipeline cache is internally synchronized, so compiles can share it.
+		double start = time_now_d();
+		VulkanPipeline *pipeline = CreateVulkanPipeline(
+			vulkan_->GetDevice(), pipelineCache_, job.layout, job.renderPass, job.raster,
+			job.useHwTransform ? &job.decFmt : nullptr, job.vsModule, job.fsModule,
+			job.needsUV, job.needsColor1, job.useHwTransform, job.lineWidth);
+		RecordCompileTime(time_now_d() - start);
+
+		job.target->pipeline = pipeline->pipeline;
+		job.target->flags = pipeline->flags;
+		job.target->ready.store(true, std::memory_order_release);
+		delete pipeline;
+
+		guard.lock();
+		compilesPending_--;
+		if (compilesPending_ == 0)
+			compileDoneCond_.notify_all();
+	}
+}
+
+void PipelineManagerVulkan::WaitForCompiles() {
+	std::unique_lock<std::mutex> guard(compileLock_);
+	compileDoneCond_.wait(guard, [&] { return compilesPending_ == 0; });
+}
+
+void PipelineManagerVulkan::StopCompileThreads() {
+	{
+		std::unique_lock<std::mutex> guard(compileLock_);
+		compileStop_ = true;
+		compileCond_.notify_all();
+	}
+	// Threads drain the queue before exiting, so every placeholder gets filled in.
+	for (auto &thread : compileThreads_)
+		thread.join();
+	compileThreads_.clear();
+}
+
+int PipelineManagerVulkan::GetNumPendingPipelines() {
+	std::unique_lock<std::mutex> guard(compileLock_);
+	return compilesPending_;
+}
+
+void PipelineManagerVulkan::RecordCompileTime(double seconds) {
+	// Keep a window of recent compiles, enough for stable percentiles.
+	const size_t WINDOW_SIZE = 256;
+	std::unique_lock<std::mutex> guard(compileTimesLock_);
+	float ms = (float)(seconds * 1000.0);
+	if (compileTimes_.size() < WINDOW_SIZE) {
+		compileTimes_.push_back(ms);
+	} else {
+		compileTimes_[compileTimesPos_] = ms;
+	}
+	compileTimesPos_ = (compileTimesPos_ + 1) % WINDOW_SIZE;
+}
+
+void PipelineManagerVulkan::GetCompileTimeStats(float *p50, float *p90, float *p99, float *maxTime) {
+	std::vector<float> times;
+	{
+		std::unique_lock<std::mutex> guard(compileTimesLock_);
+		times = compileTimes_;
+	}
+	if (times.empty()) {
+		*p50 = *p90 = *p99 = *maxTime = 0.0f;
+		return;
+	}
+	std::sort(times.begin(), times.end());
+	auto percentile = [&](int p) {
+		return times[std::min(times.size() - 1, times.size() * p / 100)];
+	};
+	*p50 = percentile(50);
+	*p90 = percentile(90);
+	*p99 = percentile(99);
+	*maxTime = times.back();
+}
+
 std::vector<std::string> PipelineManagerVulkan::DebugGetObjectIDs(DebugShaderType type) {
 	std::vector<std::string> ids;
 	switch (type) {
 	case SHADER_TYPE_PIPELINE:
 	{
+		WaitForCompiles();
 		pipelines_.Iterate([&](const VulkanPipelineKey &key, VulkanPipeline *value) {
 			std::string id;
 			key.ToString(&id);
@@ -470,6 +614,8 @@ std::string PipelineManagerVulkan::DebugGetObjectString(std::string id, DebugSha
 	VulkanPipelineKey pipelineKey;
 	pipelineKey.FromString(id);
 
+	// Compile threads may still be filling in the placeholder.
+	WaitForCompiles();
 	VulkanPipeline *iter = pipelines_.Get(pipelineKey);
 	if (!iter) {
 		return "";
@@ -550,6 +696,8 @@ void PipelineManagerVulkan::SetLineWidth(float lineWidth) {
 	if (lineWidth_ == lineWidth)
 		return;
 	lineWidth_ = lineWidth;
+	// Flags aren't known until a compile finishes.
+	WaitForCompiles();
 
 	// Wipe all line-drawing pipelines.
 	pipelines_.Iterate([&](const VulkanPipelineKey &key, VulkanPipeline *value) {
@@ -571,27 +719,15 @@ struct VkPipelineCacheHeader {
 	uint8_t uuid[VK_UUID_SIZE];
 };
 
-struct StoredVulkanPipelineKey {
-	VulkanPipelineRasterStateKey raster;
-	VShaderID vShaderID;
-	FShaderID fShaderID;
-	uint32_t vtxFmtId;
-	bool useHWTransform;
-	bool backbufferPass;
-	VulkanQueueRunner::RPKey renderPassKey;
-
-	// For std::set. Better zero-initialize the struct properly for this to work.
-	bool operator < (const StoredVulkanPipelineKey &other) const {
-		return memcmp(this, &other, sizeof(*this)) < 0;
-	}
-};
-
 // If you're looking for how to invalidate the cache, it's done in ShaderManagerVulkan, look for CACHE_VERSION and increment it.
 // (Header of the same file this is stored in).
 void PipelineManagerVulkan::SaveCache(FILE *file, bool saveRawPipelineCache, ShaderManagerVulkan *shaderManager, Draw::DrawContext *drawContext) {
 	VulkanRenderManager *rm = (VulkanRenderManager *)drawContext->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
 	VulkanQueueRunner *queueRunner = rm->GetQueueRunner();
 
+	// Save finished pipelines only, and a pipeline cache that has all of them.
+	WaitForCompiles();
+
 	size_t dataSize = 0;
 	uint32_t size;
 
@@ -730,40 +866,70 @@ bool PipelineManagerVulkan::LoadCache(FILE *file, bool loadRawPipelineCache, Sha
 	// Read the number of pipelines.
 	bool failed = fread(&size, sizeof(size), 1, file) != 1;
 
-	NOTICE_LOG(G3D, "Creating %d pipelines...", size);
-	for (uint32_t i = 0; i < size; i++) {
-		if (failed || cancelCache_) {
-			break;
-		}
+	pendingCache_.clear();
+	pendingCachePos_ = 0;
+	for (uint32_t i = 0; i < size && !failed; i++) {
 		StoredVulkanPipelineKey key;
-		failed = failed || fread(&key, sizeof(key), 1, file) != 1;
+		failed = fread(&key, sizeof(key), 1, file) != 1;
 		if (failed) {
 			ERROR_LOG(G3D, "Truncated Vulkan pipeline cache file");
-			continue;
+			break;
 		}
-		VulkanVertexShader *vs = shaderManager->GetVertexShaderFromID(key.vShaderID);
-		VulkanFragmentShader *fs = shaderManager->GetFragmentShaderFromID(key.fShaderID);
+		pendingCache_.push_back(key);
+	}
+
+	const ShaderUsage &usage = shaderManager->Usage();
+	std::stable_sort(pendingCache_.begin(), pendingCache_.end(), [&](const StoredVulkanPipelineKey &a, const StoredVulkanPipelineKey &b) {
+		return usage.ProgramCount(a.vShaderID, a.fShaderID) > usage.ProgramCount(b.vShaderID, b.fShaderID);
+	});
+	pendingShaderManager_ = shaderManager;
+	pendingQueueRunner_ = queueRunner;
+	pendingLayout_ = layout;
+
+	int total = (int)pendingCache_.size();
+	NOTICE_LOG(G3D, "Creating %d pipelines...", total);
+	if (ContinueLoadCache(time_now_d() + SHADER_PRECOMPILE_BOOT_BUDGET)) {
+		NOTICE_LOG(G3D, "Recreated Vulkan pipeline cache (%d pipelines).", total);
+	} else {
+		NOTICE_LOG(G3D, "Recreated %d/%d cached pipelines, the rest will follow in-game.", (int)pendingCachePos_, total);
+	}
+	return true;
+}
+
+bool PipelineManagerVulkan::ContinueLoadCache(double deadline) {
+	for (size_t &i = pendingCachePos_; i < pendingCache_.size(); i++) {
+		if (cancelCache_ || time_now_d() >= deadline)
+			break;
+
+		const StoredVulkanPipelineKey &key = pendingCache_[i];
+		VulkanVertexShader *vs = pendingShaderManager_->GetVertexShaderFromID(key.vShaderID);
+		VulkanFragmentShader *fs = pendingShaderManager_->GetFragmentShaderFromID(key.fShaderID);
 		if (!vs || !fs) {
-			failed = true;
 			ERROR_LOG(G3D, "Failed to find vs or fs in of pipeline %d in cache", (int)i);
-			continue;
+			pendingCachePos_ = pendingCache_.size();
+			break;
 		}
 
 		VkRenderPass rp;
 		if (key.backbufferPass) {
-			rp = queueRunner->GetBackbufferRenderPass();
+			rp = pendingQueueRunner_->GetBackbufferRenderPass();
 		} else {
-			rp = queueRunner->GetRenderPass(key.renderPassKey);
+			rp = pendingQueueRunner_->GetRenderPass(key.renderPassKey);
 		}
 
 		DecVtxFormat fmt;
 		fmt.InitializeFromID(key.vtxFmtId);
-		GetOrCreatePipeline(layout, rp, key.raster,
+		GetOrCreatePipeline(pendingLayout_, rp, key.raster,
 			key.useHWTransform ? &fmt : 0,
 			vs, fs, key.useHWTransform);
 	}
-	NOTICE_LOG(G3D, "Recreated Vulkan pipeline cache (%d pipelines).", (int)size);
-	return true;
+
+	if (cancelCache_ || pendingCachePos_ >= pendingCache_.size()) {
+		pendingCache_.clear();
+		pendingCachePos_ = 0;
+		return true;
+	}
+	return false;
 }
 
 void PipelineManagerVulkan::CancelCache() {
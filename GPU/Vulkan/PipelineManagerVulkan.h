@@ -17,7 +17,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "Common/Data/Collections/Hashmaps.h"
 
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -46,10 +53,28 @@ struct VulkanPipelineKey {
 	std::string GetDescription(DebugShaderStringType stringType) const;
 };
 
+// The part of a pipeline key that's stable across runs, for the disk cache.
+struct StoredVulkanPipelineKey {
+	VulkanPipelineRasterStateKey raster;
+	VShaderID vShaderID;
+	FShaderID fShaderID;
+	uint32_t vtxFmtId;
+	bool useHWTransform;
+	bool backbufferPass;
+	VulkanQueueRunner::RPKey renderPassKey;
+
+	// For std::set. Better zero-initialize the struct properly for this to work.
+	bool operator < (const StoredVulkanPipelineKey &other) const {
+		return memcmp(this, &other, sizeof(*this)) < 0;
+	}
+};
+
 // Simply wraps a Vulkan pipeline, providing some metadata.
 struct VulkanPipeline {
 	VkPipeline pipeline;
 	int flags;  // PipelineFlags enum above.
+	// False while a background compile is still filling in pipeline and flags.
+	std::atomic<bool> ready{ true };
 
 	bool UsesBlendConstant() const { return (flags & PIPELINE_FLAG_USES_BLEND_CONSTANT) != 0; }
 	bool UsesLines() const { return (flags & PIPELINE_FLAG_USES_LINES) != 0; }
@@ -69,6 +94,9 @@ class PipelineManagerVulkan {
 
 	VulkanPipeline *GetOrCreatePipeline(VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &rasterKey, const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform);
 	int GetNumPipelines() const { return (int)pipelines_.size(); }
+	int GetNumPendingPipelines();
+	// Pipeline compile times in milliseconds over the recent window.
+	void GetCompileTimeStats(float *p50, float *p90, float *p99, float *maxTime);
 
 	void Clear();
 
@@ -83,12 +111,55 @@ class PipelineManagerVulkan {
 	// Saves data for faster creation next time.
 	void SaveCache(FILE *file, bool saveRawPipelineCache, ShaderManagerVulkan *shaderManager, Draw::DrawContext *drawContext);
 	bool LoadCache(FILE *file, bool loadRawPipelineCache, ShaderManagerVulkan *shaderManager, Draw::DrawContext *drawContext, VkPipelineLayout layout);
+	// Creates more of the cached pipelines LoadCache left for later, until the deadline.
+	// Returns true once there are none left.
+	bool ContinueLoadCache(double deadline);
 	void CancelCache();
 
 private:
+	struct CompileJob {
+		VulkanPipeline *target;
+		VkPipelineLayout layout;
+		VkRenderPass renderPass;
+		VulkanPipelineRasterStateKey raster;
+		DecVtxFormat decFmt;
+		VkShaderModule vsModule;
+		VkShaderModule fsModule;
+		bool needsUV;
+		bool needsColor1;
+		bool useHwTransform;
+		float lineWidth;
+	};
+
+	void QueueCompile(const CompileJob &job);
+	void CompileThreadFunc();
+	void WaitForCompiles();
+	void StopCompileThreads();
+	void RecordCompileTime(double seconds);
+
 	DenseHashMap<VulkanPipelineKey, VulkanPipeline *, nullptr> pipelines_;
 	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 	VulkanContext *vulkan_;
 	float lineWidth_ = 1.0f;
 	bool cancelCache_ = false;
+
+	// Cached pipelines, most used first. LoadCache creates what fits in the boot budget.
+	std::vector<StoredVulkanPipelineKey> pendingCache_;
+	size_t pendingCachePos_ = 0;
+	ShaderManagerVulkan *pendingShaderManager_ = nullptr;
+	VulkanQueueRunner *pendingQueueRunner_ = nullptr;
+	VkPipelineLayout pendingLayout_ = VK_NULL_HANDLE;
+
+	std::vector<std::thread> compileThreads_;
+	std::mutex compileLock_;
+	std::condition_variable compileCond_;
+	std::condition_variable compileDoneCond_;
+	std::deque<CompileJob> compileQueue_;
+	// Queued plus currently compiling, guarded by compileLock_.
+	int compilesPending_ = 0;
+	bool compileStop_ = false;
+
+	std::mutex compileTimesLock_;
+	std::vector<float> compileTimes_;
+	size_t compileTimesPos_ = 0;
 };
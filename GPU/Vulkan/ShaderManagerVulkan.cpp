@@ -19,6 +19,9 @@
 //#define SHADERLOG
 #endif
 
+#include <atomic>
+#include <memory>
+
 #include "Common/Math/lin/matrix4x4.h"
 #include "Common/Math/math_util.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
@@ -33,6 +36,7 @@
 #include "Common/Common.h"
 #include "Core/Config.h"
 #include "Core/Reporting.h"
+#include "Core/ThreadPools.h"
 #include "GPU/Math3D.h"
 #include "GPU/GPUState.h"
 #include "GPU/ge_constants.h"
@@ -157,9 +161,11 @@ std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) cons
 	}
 }
 
+static const size_t CODE_BUFFER_SIZE = 16384;
+
 ShaderManagerVulkan::ShaderManagerVulkan(Draw::DrawContext *draw, VulkanContext *vulkan)
 	: ShaderManagerCommon(draw), vulkan_(vulkan), compat_(GLSL_VULKAN), fsCache_(16), vsCache_(16) {
-	codeBuffer_ = new char[16384];
+	codeBuffer_ = new char[CODE_BUFFER_SIZE];
 	uboAlignment_ = vulkan_->GetPhysicalDeviceProperties().properties.limits.minUniformBufferOffsetAlignment;
 	memset(&ub_base, 0, sizeof(ub_base));
 	memset(&ub_lights, 0, sizeof(ub_lights));
@@ -285,6 +291,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 	}
 
 	lastFSID_ = FSID;
+	usage_.NoteShaders(VSID, FSID);
 
 	lastVShader_ = vs;
 	lastFShader_ = fs;
@@ -388,37 +395,78 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 	if (header.featureFlags != gstate_c.featureFlags)
 		return false;
 
+	std::vector<VShaderID> vertIDs;
 	for (int i = 0; i < header.numVertexShaders; i++) {
 		VShaderID id;
 		if (fread(&id, sizeof(id), 1, f) != 1) {
 			ERROR_LOG(G3D, "Vulkan shader cache truncated");
 			break;
 		}
-		bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
-		std::string genErrorString;
-		uint32_t attributeMask = 0;
-		uint64_t uniformMask = 0;
-		if (!GenerateVertexShader(id, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &genErrorString)) {
-			return false;
-		}
-		VulkanVertexShader *vs = new VulkanVertexShader(vulkan_, id, codeBuffer_, useHWTransform);
-		vsCache_.Insert(id, vs);
+		vertIDs.push_back(id);
 	}
-	uint32_t vendorID = vulkan_->GetPhysicalDeviceProperties().properties.vendorID;
-
+	std::vector<FShaderID> fragIDs;
 	for (int i = 0; i < header.numFragmentShaders; i++) {
 		FShaderID id;
 		if (fread(&id, sizeof(id), 1, f) != 1) {
 			ERROR_LOG(G3D, "Vulkan shader cache truncated");
 			break;
 		}
-		std::string genErrorString;
-		uint64_t uniformMask = 0;
-		if (!GenerateFragmentShader(id, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &genErrorString)) {
-			return false;
+		fragIDs.push_back(id);
+	}
+
+	// Most used first, so they're the first ones the workers pick up.
+	usage_.SortVertexShaders(vertIDs);
+	usage_.SortFragmentShaders(fragIDs);
+
+	// Generation and SPIR-V compilation are independent per shader, so spread them out.
+	// Each slice gets its own code buffer, and the maps are only touched afterwards.
+	std::vector<VulkanVertexShader *> vertShaders(vertIDs.size(), nullptr);
+	std::vector<VulkanFragmentShader *> fragShaders(fragIDs.size(), nullptr);
+	std::atomic<bool> failed(false);
+	int numVert = (int)vertIDs.size();
+	GlobalThreadPool::Loop([&](int lower, int upper) {
+		std::unique_ptr<char[]> code(new char[CODE_BUFFER_SIZE]);
+		for (int i = lower; i < upper && !failed; i++) {
+			std::string genErrorString;
+			uint64_t uniformMask = 0;
+			if (i < numVert) {
+				const VShaderID &id = vertIDs[i];
+				uint32_t attributeMask = 0;
+				if (!GenerateVertexShader(id, code.get(), compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &genErrorString)) {
+					failed = true;
+					break;
+				}
+				vertShaders[i] = new VulkanVertexShader(vulkan_, id, code.get(), id.Bit(VS_BIT_USE_HW_TRANSFORM));
+			} else {
+				const FShaderID &id = fragIDs[i - numVert];
+				if (!GenerateFragmentShader(id, code.get(), compat_, draw_->GetBugs(), &uniformMask, &genErrorString)) {
+					failed = true;
+					break;
+				}
+				fragShaders[i - numVert] = new VulkanFragmentShader(vulkan_, id, code.get());
+			}
 		}
-		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan_, id, codeBuffer_);
-		fsCache_.Insert(id, fs);
+	}, 0, numVert + (int)fragIDs.size());
+
+	if (failed) {
+		for (VulkanVertexShader *vs : vertShaders)
+			delete vs;
+		for (VulkanFragmentShader *fs : fragShaders)
+			delete fs;
+		return false;
+	}
+
+	for (size_t i = 0; i < vertIDs.size(); i++) {
+		if (!vsCache_.Get(vertIDs[i]))
+			vsCache_.Insert(vertIDs[i], vertShaders[i]);
+		else
+			delete vertShaders[i];
+	}
+	for (size_t i = 0; i < fragIDs.size(); i++) {
+		if (!fsCache_.Get(fragIDs[i]))
+			fsCache_.Insert(fragIDs[i], fragShaders[i]);
+		else
+			delete fragShaders[i];
 	}
 
 	NOTICE_LOG(G3D, "Loaded %d vertex and %d fragment shaders", header.numVertexShaders, header.numFragmentShaders);
@@ -516,6 +516,32 @@ void TextureCacheVulkan::BindTexture(TexCacheEntry *entry) {
 	imageView_ = entry->vkTex->GetImageView();
 	int maxLevel = (entry->status & TexCacheEntry::STATUS_BAD_MIPS) ? 0 : entry->maxLevel;
 	SamplerCacheKey samplerKey = GetSamplingParams(maxLevel, entry->addr);
+	if (entry->status & TexCacheEntry::STATUS_CLUT_INDICES) {
+		// The shader does the filtering after the lookup, so fetch the indices unfiltered.
+		samplerKey.magFilt = false;
+		samplerKey.minFilt = false;
+		samplerKey.mipFilt = false;
+		curSampler_ = samplerCache_.GetOrCreateSampler(samplerKey);
+
+		// Only the CLUT itself needs uploading when it changes.
+		bool expand32 = !gstate_c.Supports(GPU_SUPPORTS_16BIT_FORMATS);
+		depalShaderCache_->SetPushBuffer(drawEngine_->GetPushBufferForTextureData());
+		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
+		VulkanTexture *clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_, expand32);
+		drawEngine_->SetDepalTexture(clutTexture ? clutTexture->GetImageView() : VK_NULL_HANDLE);
+
+		gstate_c.Dirty(DIRTY_DEPAL);
+		gstate_c.SetUseShaderDepal(true);
+		gstate_c.depalFramebufferFormat = GE_FORMAT_8888;
+		if (ClutAlphaChanged()) {
+			const u32 bytesPerColor = clutFormat == GE_CMODE_32BIT_ABGR8888 ? sizeof(u32) : sizeof(u16);
+			const u32 clutTotalColors = clutMaxBytes_ / bytesPerColor;
+			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(clutBuf_, getClutDestFormatVulkan(clutFormat), clutTotalColors, clutTotalColors, 1);
+			clutAlphaFull_ = alphaStatus == TexCacheEntry::STATUS_ALPHA_FULL;
+		}
+		gstate_c.SetTextureFullAlpha(clutAlphaFull_);
+		return;
+	}
 	curSampler_ = samplerCache_.GetOrCreateSampler(samplerKey);
 	drawEngine_->SetDepalTexture(VK_NULL_HANDLE);
 	gstate_c.SetUseShaderDepal(false);
@@ -757,6 +783,10 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 
 	// If GLES3 is available, we can preallocate the storage, which makes texture loading more efficient.
 	VkFormat dstFmt = GetDestFormat(GETextureFormat(entry->format), gstate.getClutPaletteFormat());
+	if (entry->status & TexCacheEntry::STATUS_CLUT_INDICES) {
+		// Raw indices, see DecodeTextureIndices.
+		dstFmt = VULKAN_8888_FORMAT;
+	}
 
 	int scaleFactor = standardScaleFactor_;
 
@@ -1088,17 +1118,24 @@ void TextureCacheVulkan::LoadTextureLevel(TexCacheEntry &entry, uint8_t *writePt
 		}
 
 		bool expand32 = !gstate_c.Supports(GPU_SUPPORTS_16BIT_FORMATS);
-		DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, expand32);
-		gpuStats.numTexturesDecoded++;
-
-		// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
-		if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
-			// TODO: When we decode directly, this can be more expensive (maybe not on mobile?)
-			// This does allow us to skip alpha testing, though.
-			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
-			entry.SetAlphaStatus(alphaStatus, level);
-		} else {
+		if (entry.status & TexCacheEntry::STATUS_CLUT_INDICES) {
+			DecodeTextureIndices((u8 *)pixelData, decPitch, tfmt, texaddr, level, bufw);
+			gpuStats.numTexturesDecoded++;
+			// The alpha comes from the CLUT, BindTexture checks that.
 			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+		} else {
+			DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, expand32);
+			gpuStats.numTexturesDecoded++;
+
+			// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
+			if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+				// TODO: When we decode directly, this can be more expensive (maybe not on mobile?)
+				// This does allow us to skip alpha testing, though.
+				TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
+				entry.SetAlphaStatus(alphaStatus, level);
+			} else {
+				entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			}
 		}
 
 		if (scaleFactor > 1) {
@@ -29,12 +29,15 @@
 #include "Common/UI/ViewGroup.h"
 #include "Common/UI/UI.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
+#include "Common/File/FileUtil.h"
 
 #include "Common/LogManager.h"
 #include "Common/CPUDetect.h"
 #include "Common/StringUtils.h"
 
 #include "Core/MemMap.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/System.h"
@@ -48,6 +51,7 @@
 #include "GPU/GPUState.h"
 #include "UI/MiscScreens.h"
 #include "UI/DevScreens.h"
+#include "UI/OnScreenDisplay.h"
 #include "UI/ControlMappingScreen.h"
 #include "UI/GameSettingsScreen.h"
 
@@ -87,6 +91,7 @@ void DevMenu::CreatePopupContents(UI::ViewGroup *parent) {
 	}
 	items->Add(new Choice(dev->T("Toggle Freeze")))->OnClick.Handle(this, &DevMenu::OnFreezeFrame);
 	items->Add(new Choice(dev->T("Dump Frame GPU Commands")))->OnClick.Handle(this, &DevMenu::OnDumpFrame);
+	items->Add(new Choice(dev->T(Trace_IsActive() ? "Stop GPU Trace" : "Start GPU Trace")))->OnClick.Handle(this, &DevMenu::OnGPUTrace);
 	items->Add(new Choice(dev->T("Toggle Audio Debug")))->OnClick.Handle(this, &DevMenu::OnToggleAudioDebug);
 #ifdef USE_PROFILER
 	items->Add(new CheckBox(&g_Config.bShowFrameProfiler, dev->T("Frame Profiler"), ""));
@@ -158,6 +163,37 @@ UI::EventReturn DevMenu::OnDumpFrame(UI::EventParams &e) {
 	return UI::EVENT_DONE;
 }
 
+static std::string GenTraceFilename() {
+	const std::string dumpDir = GetSysDirectory(DIRECTORY_DUMP);
+	const std::string prefix = dumpDir + g_paramSFO.GetDiscID();
+
+	File::CreateFullPath(dumpDir);
+
+	for (int n = 1; n < 10000; ++n) {
+		std::string filename = StringFromFormat("%s_trace_%04d.json", prefix.c_str(), n);
+		if (!File::Exists(filename)) {
+			return filename;
+		}
+	}
+
+	return StringFromFormat("%s_trace_%04d.json", prefix.c_str(), 9999);
+}
+
+UI::EventReturn DevMenu::OnGPUTrace(UI::EventParams &e) {
+	auto dev = GetI18NCategory("Developer");
+	if (Trace_IsActive()) {
+		std::string filename = GenTraceFilename();
+		if (Trace_StopAndSave(filename)) {
+			osm.Show(std::string(dev->T("Saved GPU trace to")) + " " + filename, 3.0f);
+		}
+	} else {
+		Trace_Start();
+	}
+	// The label changes, just close the menu.
+	TriggerFinish(DR_OK);
+	return UI::EVENT_DONE;
+}
+
 void DevMenu::dialogFinished(const Screen *dialog, DialogResult result) {
 	UpdateUIState(UISTATE_INGAME);
 	// Close when a subscreen got closed.
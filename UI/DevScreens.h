@@ -43,6 +43,7 @@ class DevMenu : public PopupScreen {
 	UI::EventReturn OnShaderView(UI::EventParams &e);
 	UI::EventReturn OnFreezeFrame(UI::EventParams &e);
 	UI::EventReturn OnDumpFrame(UI::EventParams &e);
+	UI::EventReturn OnGPUTrace(UI::EventParams &e);
 	UI::EventReturn OnDeveloperTools(UI::EventParams &e);
 	UI::EventReturn OnToggleAudioDebug(UI::EventParams &e);
 	UI::EventReturn OnResetLimitedLogging(UI::EventParams &e);
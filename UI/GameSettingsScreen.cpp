@@ -624,6 +624,10 @@ void GameSettingsScreen::CreateViews() {
 	}
 #endif
 
+	static const char *resamplers[] = { "Linear", "Sinc (higher quality)" };
+	PopupMultiChoice *resampler = audioSettings->Add(new PopupMultiChoice(&g_Config.iAudioResampler, a->T("Resampling"), resamplers, 0, ARRAY_SIZE(resamplers), a->GetName(), screenManager()));
+	resampler->SetEnabledPtr(&g_Config.bEnableSound);
+
 	std::vector<std::string> micList = Microphone::getDeviceList();
 	if (!micList.empty()) {
 		audioSettings->Add(new ItemHeader(a->T("Microphone")));
@@ -10,6 +10,7 @@
 #endif
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/Trace.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
 
@@ -23,8 +24,11 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
+#include "Core/HLE/ReplaceTables.h"
+#include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
+#include "Core/Replay.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "Log.h"
@@ -115,6 +119,10 @@ int printUsage(const char *progname, const char *reason)
 	}
 #endif
 	fprintf(stderr, "  --timeout=SECONDS     abort test it if takes longer than SECONDS\n");
+	fprintf(stderr, "  --replacements        report which function replacements were hit\n");
+	fprintf(stderr, "  --replay=FILE         play back a replay as fast as possible, report fps\n");
+	fprintf(stderr, "  --replay-seek=FRAME   start the replay from its last keyframe before FRAME\n");
+	fprintf(stderr, "  --gputrace=FILE       write a Chrome trace of GPU work to FILE\n");
 
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
@@ -140,6 +148,40 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
+static bool reportReplacements = false;
+static const char *replayFilename = nullptr;
+static int replaySeekFrame = -1;
+static const char *traceFilename = nullptr;
+
+// Saved time is an estimate: the guest cycles a replacement charged, at this run's average
+// host time per executed (not idled) guest cycle, minus the time the replacement itself took.
+static void PrintReplacementStats(double runSeconds) {
+	std::vector<ReplacementStat> stats = GetReplacementStats();
+	if (stats.empty()) {
+		fprintf(stderr, "No function replacements hit.\n");
+		return;
+	}
+
+	u64 executedCycles = CoreTiming::GetTicks() - CoreTiming::GetIdleTicks();
+	double secondsPerCycle = executedCycles != 0 ? runSeconds / executedCycles : 0.0;
+
+	u64 totalHits = 0;
+	u64 totalCycles = 0;
+	double totalMs = 0.0;
+	double totalSavedMs = 0.0;
+	fprintf(stderr, "%-32s %12s %14s %10s %12s\n", "Replacement", "Hits", "Cycles", "Host ms", "Est. saved");
+	for (const ReplacementStat &stat : stats) {
+		double ms = stat.seconds * 1000.0;
+		double savedMs = stat.cycles * secondsPerCycle * 1000.0 - ms;
+		fprintf(stderr, "%-32s %12llu %14llu %10.2f %12.2f\n", stat.name, (unsigned long long)stat.hits, (unsigned long long)stat.cycles, ms, savedMs);
+		totalHits += stat.hits;
+		totalCycles += stat.cycles;
+		totalMs += ms;
+		totalSavedMs += savedMs;
+	}
+	fprintf(stderr, "%-32s %12llu %14llu %10.2f %12.2f\n", "Total", (unsigned long long)totalHits, (unsigned long long)totalCycles, totalMs, totalSavedMs);
+}
+
 bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
 {
 	// Kinda ugly, trying to guesstimate the test name from filename...
@@ -161,6 +203,16 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	TeamCityPrint("testStarted name='%s' captureStandardOutput='true'", currentTestName.c_str());
 
 	host->BootDone();
+	double runStartTime = time_now_d();
+
+	if (replayFilename && !ReplayExecuteFile(replayFilename)) {
+		fprintf(stderr, "Failed to load replay %s\n", replayFilename);
+		PSP_Shutdown();
+		return false;
+	}
+	bool replaySeekPending = replayFilename && replaySeekFrame >= 0;
+	int replayStartFrame = 0;
+	double replayStartTime = time_now_d();
 
 	if (autoCompare)
 		headlessHost->SetComparisonScreenshot(ExpectedScreenshotFromFilename(coreParameter.fileToStart));
@@ -188,6 +240,19 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 			coreState = CORE_RUNNING;
 			headlessHost->SwapBuffers();
 		}
+		if (replayFilename) {
+			// Seek once the game has booted, the keyframes need a running kernel to load into.
+			if (replaySeekPending && __DisplayGetNumVblanks() > 0) {
+				replaySeekPending = false;
+				int frame = ReplaySeekFrame(replaySeekFrame);
+				if (frame < 0)
+					fprintf(stderr, "No replay keyframe before frame %d, playing from boot\n", replaySeekFrame);
+				replayStartFrame = __DisplayGetNumVblanks();
+				replayStartTime = time_now_d();
+			}
+			if (!ReplayHasMoreEvents())
+				Core_Stop();
+		}
 		if (time_now_d() > deadline) {
 			// Don't compare, print the output at least up to this point, and bail.
 			printf("%s", output.c_str());
@@ -201,6 +266,15 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	}
 	PSP_EndHostFrame();
 
+	if (reportReplacements)
+		PrintReplacementStats(time_now_d() - runStartTime);
+	if (replayFilename) {
+		int frames = __DisplayGetNumVblanks() - replayStartFrame;
+		double seconds = time_now_d() - replayStartTime;
+		fprintf(stderr, "Replay: %d frames in %0.2f seconds (%0.1f fps)\n", frames, seconds, seconds > 0.0 ? frames / seconds : 0.0);
+		ReplayAbort();
+	}
+
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
 
@@ -293,6 +367,14 @@ int main(int argc, const char* argv[])
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
+		else if (!strcmp(argv[i], "--replacements"))
+			reportReplacements = true;
+		else if (!strncmp(argv[i], "--replay=", strlen("--replay=")) && strlen(argv[i]) > strlen("--replay="))
+			replayFilename = argv[i] + strlen("--replay=");
+		else if (!strncmp(argv[i], "--replay-seek=", strlen("--replay-seek=")) && strlen(argv[i]) > strlen("--replay-seek="))
+			replaySeekFrame = atoi(argv[i] + strlen("--replay-seek="));
+		else if (!strncmp(argv[i], "--gputrace=", strlen("--gputrace=")) && strlen(argv[i]) > strlen("--gputrace="))
+			traceFilename = argv[i] + strlen("--gputrace=");
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
 			stateToLoad = argv[i] + strlen("--state=");
 		else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
@@ -378,6 +460,8 @@ int main(int argc, const char* argv[])
 	g_Config.bVertexDecoderJit = true;
 	g_Config.bBlockTransferGPU = true;
 	g_Config.iSplineBezierQuality = 2;
+	if (reportReplacements)
+		Replacement_EnableStats(true);
 	g_Config.bHighQualityDepth = true;
 	g_Config.bMemStickInserted = true;
 	g_Config.iMemStickSizeGB = 16;
@@ -423,6 +507,9 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(stateToLoad, -1);
 
+	if (traceFilename)
+		Trace_Start();
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -456,6 +543,9 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (traceFilename && !Trace_StopAndSave(traceFilename))
+		fprintf(stderr, "Failed to write trace to %s\n", traceFilename);
+
 	host->ShutdownGraphics();
 	delete host;
 	host = nullptr;
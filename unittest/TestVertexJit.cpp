@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
@@ -25,6 +26,9 @@
 #include "unittest/TestVertexJit.h"
 #include "unittest/UnitTest.h"
 
+// Whether new harnesses may use the FMA jit path, when the CPU has it.
+static bool allowFMA = true;
+
 class VertexDecoderTestHarness {
 	static const int BUFFER_SIZE = 64 * 65536;
 	static const int ROUNDS = 200;
@@ -35,6 +39,7 @@ class VertexDecoderTestHarness {
 		src_ = new u8[BUFFER_SIZE];
 		dst_ = new u8[BUFFER_SIZE];
 		cache_ = new VertexDecoderJitCache();
+		cache_->SetAllowFMA(allowFMA);
 
 		g_Config.bVertexDecoderJit = true;
 		// Required for jit to be enabled.
@@ -82,7 +87,7 @@ class VertexDecoderTestHarness {
 		dec_->DecodeVerts(dst_, src_, indexLowerBound_, indexUpperBound);
 	}
 
-	double ExecuteTimed(int vtype, int indexUpperBound, bool useJit) {
+	double ExecuteTimed(int vtype, int indexUpperBound, bool useJit, double seconds = 0.5) {
 		SetupExecute(vtype, useJit);
 
 		int total = 0;
@@ -92,7 +97,7 @@ class VertexDecoderTestHarness {
 				dec_->DecodeVerts(dst_, src_, indexLowerBound_, indexUpperBound);
 				++total;
 			}
-		} while (time_now_d() - st < 0.5);
+		} while (time_now_d() - st < seconds);
 		double elapsed = time_now_d() - st;
 
 		return total / elapsed;
@@ -654,35 +659,59 @@ static VertexTestFunc vertdecTestFuncs[] = {
 	&TestVertexFloatSkin,
 };
 
-bool TestVertexJit() {
-	VertexDecoderTestHarness dec;
-	/*for (int i = 0; i < 100; ++i) {
-		dec.AddFloat(0.5f, 1.0f, -1.0f);
-	}
-	int vtype = GE_VTYPE_POS_FLOAT;*/
-	/*for (int i = 0; i < 100; ++i) {
-		dec.Add16(32767, 0, 32768);
+static void BenchmarkVertexFormat(const char *name, int vtype) {
+	const int VERTS = 512;
+
+	double rates[3]{};
+	for (int path = 0; path < 3; ++path) {
+		allowFMA = path == 2;
+		if (path == 2 && !cpu_info.bFMA3) {
+			break;
+		}
+
+		VertexDecoderTestHarness dec;
+		dec.Reset();
+		// Arbitrary but finite data, so float formats don't hit NaN or denormal paths.
+		for (int i = 0; i < VERTS * 64; ++i) {
+			dec.Add8(0x3C);
+		}
+		rates[path] = dec.ExecuteTimed(vtype, VERTS - 1, path != 0, 0.25) * VERTS;
 	}
-	int vtype = GE_VTYPE_POS_16BIT;*/
-	for (int i = 0; i < 100; ++i) {
-		dec.Add8(127, 0, 128);
+	allowFMA = true;
+
+	printf("%-12s steps %7.1f  jit %7.1f  fma %7.1f Mverts/sec\n", name, rates[0] / 1000000.0, rates[1] / 1000000.0, rates[2] / 1000000.0);
+}
+
+bool BenchVertexJit() {
+	g_Config.bSoftwareSkinning = true;
+	for (int i = 0; i < 8 * 12; ++i) {
+		gstate.boneMatrix[i] = (i % 4) == 0 ? 1.0f : 0.0f;
 	}
-	int vtype = GE_VTYPE_POS_8BIT;
-	double yesJit = dec.ExecuteTimed(vtype, 100, true);
-	double noJit = dec.ExecuteTimed(vtype, 100, false);
 
-	float x = dec.GetFloat();
-	float y = dec.GetFloat();
-	float z = dec.GetFloat();
-	printf("Result: %f, %f, %f\n", x, y, z);
-	printf("Jit was %fx faster than steps.\n\n", yesJit / noJit);
+	BenchmarkVertexFormat("pos8", GE_VTYPE_POS_8BIT);
+	BenchmarkVertexFormat("pos16", GE_VTYPE_POS_16BIT);
+	BenchmarkVertexFormat("posfloat", GE_VTYPE_POS_FLOAT);
+	BenchmarkVertexFormat("tc16col8888", GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_8BIT | GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888);
+	BenchmarkVertexFormat("skin4w8", GE_VTYPE_POS_16BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_WEIGHT_8BIT | (3 << GE_VTYPE_WEIGHTCOUNT_SHIFT));
+	BenchmarkVertexFormat("morph2f", GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_FLOAT | (1 << GE_VTYPE_MORPHCOUNT_SHIFT));
+	return true;
+}
 
+bool TestVertexJit() {
 	bool pass = true;
-	for (size_t i = 0; i < ARRAY_SIZE(vertdecTestFuncs); ++i) {
-		if (!vertdecTestFuncs[i]()) {
-			pass = false;
+	// Run the checks against both the SSE and (if supported) the FMA jit.
+	for (int fma = 0; fma <= 1; ++fma) {
+		allowFMA = fma == 1;
+		if (allowFMA && !cpu_info.bFMA3) {
+			break;
+		}
+		for (size_t i = 0; i < ARRAY_SIZE(vertdecTestFuncs); ++i) {
+			if (!vertdecTestFuncs[i]()) {
+				pass = false;
+			}
 		}
 	}
+	allowFMA = true;
 
 	return pass;
 }
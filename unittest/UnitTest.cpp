@@ -27,11 +27,15 @@
 // To use, set command line parameter to one or more of the tests below, or "all".
 // Search for "availableTests".
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <deque>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <snappy-c.h>
 #if defined(ANDROID)
 #include <jni.h>
 #endif
@@ -42,17 +46,35 @@
 #include "Common/Input/InputState.h"
 #include "ext/disarm.h"
 #include "Common/Math/math_util.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Data/Text/Parsers.h"
 
 #include "Common/ArmEmitter.h"
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
+#include "Common/ExceptionHandlerSetup.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/CoreTiming.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HLE/ReplaceTables.h"
+#include "Core/HLE/ThreadQueueList.h"
+#include "Core/HW/SasAudio.h"
+#include "Core/HW/StereoResampler.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/Replay.h"
+#ifndef MOBILE_DEVICE
+#include "Core/WaveFile.h"
+#endif
+#include "GPU/Common/IndexGenerator.h"
+#include "GPU/Common/SoftwareTransformCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/GPU.h"
 
 #include "unittest/JitHarness.h"
 #include "unittest/TestVertexJit.h"
@@ -560,6 +582,901 @@ static bool TestMemMap() {
 	return true;
 }
 
+static const ReplacementTableEntry *FindReplacement(const char *name) {
+	for (int i = 0; i < GetNumReplacementFuncs(); ++i) {
+		const ReplacementTableEntry *entry = GetReplacementFunc(i);
+		if (!strcmp(entry->name, name))
+			return entry;
+	}
+	return nullptr;
+}
+
+// Bit exact, except any NaN matches any NaN.
+static bool SameFloat(float a, float b) {
+	if (my_isnan(a) || my_isnan(b))
+		return my_isnan(a) && my_isnan(b);
+	u32 ia, ib;
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	return ia == ib;
+}
+
+// The enabled libc replacements, against what the host libc does.
+static bool TestReplacements() {
+	MIPSState *oldMIPS = currentMIPS;
+	currentMIPS = &mipsr4k;
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	EXPECT_TRUE(Memory::Init());
+
+	const float values[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1.5f, 2.5f, -2.5f, 7.25f, -1234.5f, 16777215.0f, 3.0e38f, 1.0e-40f, -1.0e-40f, INFINITY, -INFINITY, NAN };
+	auto callFloat = [&](const char *name, float a, float b) {
+		const ReplacementTableEntry *entry = FindReplacement(name);
+		currentMIPS->f[12] = a;
+		currentMIPS->f[13] = b;
+		currentMIPS->f[0] = 0.0f;
+		currentMIPS->r[MIPS_REG_V0] = 0xDEADBEEF;
+		entry->replaceFunc();
+	};
+	for (float a : values) {
+		callFloat("isnanf", a, 0.0f);
+		EXPECT_EQ_INT((int)currentMIPS->r[MIPS_REG_V0], std::isnan(a) ? 1 : 0);
+		callFloat("finitef", a, 0.0f);
+		EXPECT_EQ_INT((int)currentMIPS->r[MIPS_REG_V0], std::isfinite(a) ? 1 : 0);
+		callFloat("roundf", a, 0.0f);
+		EXPECT_TRUE(SameFloat(currentMIPS->f[0], roundf(a)));
+		for (float b : values) {
+			callFloat("fmodf", a, b);
+			EXPECT_TRUE(SameFloat(currentMIPS->f[0], fmodf(a, b)));
+			callFloat("copysignf", a, b);
+			EXPECT_TRUE(SameFloat(currentMIPS->f[0], copysignf(a, b)));
+		}
+	}
+
+	const u32 aAddr = 0x08900000;
+	const u32 bAddr = 0x08A00001;
+	u8 *a = Memory::GetPointer(aAddr);
+	u8 *b = Memory::GetPointer(bAddr);
+	auto callMem = [&](const char *name, u32 p0, u32 p1, u32 p2) {
+		const ReplacementTableEntry *entry = FindReplacement(name);
+		currentMIPS->r[MIPS_REG_A0] = p0;
+		currentMIPS->r[MIPS_REG_A1] = p1;
+		currentMIPS->r[MIPS_REG_A2] = p2;
+		entry->replaceFunc();
+		return (s32)currentMIPS->r[MIPS_REG_V0];
+	};
+	srand(1234);
+	for (u32 len = 0; len < 70; ++len) {
+		for (u32 i = 0; i < len; ++i)
+			a[i] = b[i] = (u8)rand();
+		EXPECT_EQ_INT(callMem("memcmp", aAddr, bAddr, len), 0);
+		EXPECT_EQ_INT(callMem("bcmp", aAddr, bAddr, len), 0);
+		for (u32 pos = 0; pos < len; ++pos) {
+			u8 old = b[pos];
+			b[pos] = (u8)(old + 1 + rand() % 255);
+			// The sign has to match, and the value is the byte difference, like newlib.
+			int expected = memcmp(a, b, len);
+			int result = callMem("memcmp", aAddr, bAddr, len);
+			EXPECT_TRUE((result < 0) == (expected < 0) && (result > 0) == (expected > 0));
+			EXPECT_EQ_INT(result, (int)a[pos] - (int)b[pos]);
+			EXPECT_TRUE(callMem("bcmp", aAddr, bAddr, len) != 0);
+
+			const u8 *found = (const u8 *)memchr(a, b[pos], len);
+			u32 expectedAddr = found ? aAddr + (u32)(found - a) : 0;
+			EXPECT_EQ_HEX((u32)callMem("memchr", aAddr, b[pos], len), expectedAddr);
+			b[pos] = old;
+		}
+		// Only the low byte of the value counts.
+		if (len != 0) {
+			const u8 *found = (const u8 *)memchr(a, a[len - 1], len);
+			EXPECT_EQ_HEX((u32)callMem("memchr", aAddr, 0x1200 | a[len - 1], len), aAddr + (u32)(found - a));
+		}
+	}
+
+	Memory::Shutdown();
+	currentMIPS = oldMIPS;
+	return true;
+}
+
+static bool TestSasMix() {
+	static const int pitches[] = { PSP_SAS_PITCH_BASE, 0x0800, 0x1234, 0x0123, PSP_SAS_PITCH_MAX };
+	static const u32 fracs[] = { 0, 0x345, 0xFFF };
+	static const int counts[] = { 0, 1, 5, 64, 255 };
+
+	static const int MAX_COUNT = 255;
+	s16 src[(MAX_COUNT * PSP_SAS_PITCH_MAX >> PSP_SAS_PITCH_BASE_SHIFT) + 16];
+	int envelope[MAX_COUNT];
+	int mixScalar[MAX_COUNT * 2], sendScalar[MAX_COUNT * 2];
+	int mixSIMD[MAX_COUNT * 2], sendSIMD[MAX_COUNT * 2];
+
+	srand(1234);
+	for (int pitch : pitches) {
+		for (u32 frac : fracs) {
+			for (int count : counts) {
+				SasVoice voice;
+				voice.pitch = pitch;
+				voice.volumeLeft = rand() % (PSP_SAS_VOL_MAX * 2 + 1) - PSP_SAS_VOL_MAX;
+				voice.volumeRight = rand() % (PSP_SAS_VOL_MAX * 2 + 1) - PSP_SAS_VOL_MAX;
+				voice.effectLeft = rand() % (PSP_SAS_VOL_MAX * 2 + 1) - PSP_SAS_VOL_MAX;
+				voice.effectRight = rand() % (PSP_SAS_VOL_MAX * 2 + 1) - PSP_SAS_VOL_MAX;
+
+				for (size_t i = 0; i < ARRAY_SIZE(src); ++i) {
+					src[i] = (s16)(rand() & 0xFFFF);
+				}
+				for (int i = 0; i < count; ++i) {
+					// The whole range of heights, (GetHeight() + (1 << 14)) >> 15 is at most 0x8000.
+					envelope[i] = rand() % 0x8001;
+				}
+				for (int i = 0; i < MAX_COUNT * 2; ++i) {
+					mixScalar[i] = mixSIMD[i] = rand() - RAND_MAX / 2;
+					sendScalar[i] = sendSIMD[i] = rand() - RAND_MAX / 2;
+				}
+
+				SasMixSamples_Scalar(voice, mixScalar, sendScalar, src, frac, envelope, count);
+				SasMixSamples(voice, mixSIMD, sendSIMD, src, frac, envelope, count);
+				for (int i = 0; i < MAX_COUNT * 2; ++i) {
+					EXPECT_EQ_INT(mixSIMD[i], mixScalar[i]);
+					EXPECT_EQ_INT(sendSIMD[i], sendScalar[i]);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+// Anything after the test name on the command line.
+static std::vector<std::string> testArgs;
+
+// Signal to noise ratio in dB of a resampled stereo stream, against a long double precision windowed sinc.
+static double ResamplerSNR(const std::vector<s16> &input, const s16 *output, u32 frames, u32 ratio, int delay) {
+	const int HALF_WIDTH = 32;
+	const int inputFrames = (int)input.size() / 2;
+	double signal = 0.0;
+	double noise = 0.0;
+	for (u32 i = 0; i < frames; ++i) {
+		double pos = (double)i * ratio / 65536.0 + delay;
+		int center = (int)pos;
+		if (center < HALF_WIDTH || center + HALF_WIDTH >= inputFrames)
+			continue;
+		double ref[2] = {};
+		for (int k = center - HALF_WIDTH + 1; k <= center + HALF_WIDTH; ++k) {
+			double x = pos - k;
+			double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+			// Blackman window.
+			double w = 0.42 + 0.5 * cos(M_PI * x / HALF_WIDTH) + 0.08 * cos(2.0 * M_PI * x / HALF_WIDTH);
+			ref[0] += input[k * 2] * sinc * w;
+			ref[1] += input[k * 2 + 1] * sinc * w;
+		}
+		for (int c = 0; c < 2; ++c) {
+			double err = output[i * 2 + c] - ref[c];
+			signal += ref[c] * ref[c];
+			noise += err * err;
+		}
+	}
+	return 10.0 * log10(signal / std::max(noise, 1.0));
+}
+
+struct ResamplerResult {
+	double snr;
+	double nsPerFrame;
+};
+
+// Resamples the whole input to outRate with each method, repeats times for timing.
+static void RunResamplers(const std::vector<s16> &input, int inRate, int outRate, int repeats, ResamplerResult *linear, ResamplerResult *sinc, std::vector<s16> *sincOutput) {
+	// Power of two ring buffer holding everything, plus the mirror the polyphase filter needs.
+	u32 ringSize = 1;
+	while (ringSize <= input.size())
+		ringSize <<= 1;
+	std::vector<s16> ring(ringSize + PolyphaseFilter::TAPS * 2);
+	std::copy(input.begin(), input.end(), ring.begin());
+	std::copy(ring.begin(), ring.begin() + PolyphaseFilter::TAPS * 2, ring.begin() + ringSize);
+
+	const u32 ratio = (u32)(65536.0 * inRate / outRate);
+	const u32 maxFrames = (u32)((u64)(input.size() / 2) * 65536 / ratio) + 1;
+	std::vector<s16> output(maxFrames * 2);
+	PolyphaseFilter filter;
+	filter.Build(std::min(1.0, (double)outRate / inRate));
+
+	for (int method = 0; method < 2; ++method) {
+		u32 frames = 0;
+		double start = time_now_d();
+		for (int n = 0; n < repeats; ++n) {
+			u32 indexR = 0;
+			u32 frac = 0;
+			u32 indexW = (u32)input.size();
+			if (method == 0)
+				frames = ResampleLinear(output.data(), maxFrames, ring.data(), ringSize - 1, indexR, indexW, frac, ratio);
+			else
+				frames = ResamplePolyphase(output.data(), maxFrames, ring.data(), ringSize - 1, indexR, indexW, frac, ratio, filter);
+		}
+		double elapsed = time_now_d() - start;
+
+		ResamplerResult &result = method == 0 ? *linear : *sinc;
+		result.nsPerFrame = frames == 0 ? 0.0 : elapsed * 1e9 / ((double)frames * repeats);
+		result.snr = ResamplerSNR(input, output.data(), frames, ratio, method == 0 ? 0 : PolyphaseFilter::DELAY);
+		if (method == 1 && sincOutput)
+			sincOutput->assign(output.begin(), output.begin() + frames * 2);
+	}
+}
+
+// A 1 kHz tone on the left and 6 kHz on the right, at 44.1 kHz.
+static std::vector<s16> ResamplerTones() {
+	std::vector<s16> input(44100 * 2);
+	for (int i = 0; i < 44100; ++i) {
+		input[i * 2] = (s16)(20000.0 * sin(2.0 * M_PI * 1000.0 * i / 44100.0));
+		input[i * 2 + 1] = (s16)(20000.0 * sin(2.0 * M_PI * 6000.0 * i / 44100.0));
+	}
+	return input;
+}
+
+// Checks the polyphase filter against the scalar path and a reference, and its quality against linear.
+static bool TestResampler() {
+	PolyphaseFilter filter;
+	filter.Build(1.0);
+	for (int p = 0; p < PolyphaseFilter::PHASES; ++p) {
+		int sum = 0;
+		for (int k = 0; k < PolyphaseFilter::TAPS; ++k)
+			sum += filter.taps[p][k];
+		EXPECT_EQ_INT(sum, 1 << PolyphaseFilter::COEF_SHIFT);
+	}
+
+	// The SIMD path must match the scalar one exactly, including across the ring buffer wrap.
+	static const u32 RING_SIZE = 256;
+	s16 ring[RING_SIZE + PolyphaseFilter::TAPS * 2];
+	srand(4321);
+	for (u32 i = 0; i < RING_SIZE; ++i)
+		ring[i] = (s16)(rand() & 0xFFFF);
+	memcpy(ring + RING_SIZE, ring, PolyphaseFilter::TAPS * 2 * sizeof(s16));
+	static const u32 ratios[] = { 0x10000, 0xEB33, 0x10A3E, 0x8000, 0x1FFFF };
+	for (u32 ratio : ratios) {
+		s16 outScalar[RING_SIZE], outSIMD[RING_SIZE];
+		u32 startR = RING_SIZE - 20;
+		u32 indexW = startR + 200;
+		u32 indexR1 = startR, indexR2 = startR;
+		u32 frac1 = 0x1234, frac2 = 0x1234;
+		u32 frames1 = ResamplePolyphase_Scalar(outScalar, RING_SIZE / 2, ring, RING_SIZE - 1, indexR1, indexW, frac1, ratio, filter);
+		u32 frames2 = ResamplePolyphase(outSIMD, RING_SIZE / 2, ring, RING_SIZE - 1, indexR2, indexW, frac2, ratio, filter);
+		EXPECT_EQ_INT(frames2, frames1);
+		EXPECT_EQ_INT(indexR2, indexR1);
+		EXPECT_EQ_INT(frac2, frac1);
+		for (u32 i = 0; i < frames1 * 2; ++i) {
+			EXPECT_EQ_INT(outSIMD[i], outScalar[i]);
+		}
+	}
+
+	// Resampled the usual way from 44.1 kHz to 48 kHz.
+	ResamplerResult linear, sinc;
+	RunResamplers(ResamplerTones(), 44100, 48000, 1, &linear, &sinc, nullptr);
+	EXPECT_TRUE(sinc.snr > 60.0);
+	EXPECT_TRUE(sinc.snr > linear.snr + 20.0);
+	return true;
+}
+
+static bool BenchResampler() {
+	const int REPEATS = 20;
+	std::vector<s16> input = ResamplerTones();
+	ResamplerResult linear, sinc;
+	RunResamplers(input, 44100, 48000, REPEATS, &linear, &sinc, nullptr);
+	printf("Resampler tones: linear %0.1f dB %0.2f ns/frame, sinc %0.1f dB %0.2f ns/frame\n", linear.snr, linear.nsPerFrame, sinc.snr, sinc.nsPerFrame);
+
+#ifndef MOBILE_DEVICE
+	// Pass a 16-bit wave file (and optionally an output path) after the test name to measure real audio.
+	if (!testArgs.empty()) {
+		unsigned int rate = 0;
+		if (!ReadWaveFile(testArgs[0], &input, &rate)) {
+			printf("Could not read %s\n", testArgs[0].c_str());
+			return false;
+		}
+		std::vector<s16> output;
+		RunResamplers(input, rate, 48000, REPEATS, &linear, &sinc, &output);
+		printf("%s (%d Hz): linear %0.1f dB %0.2f ns/frame, sinc %0.1f dB %0.2f ns/frame\n", testArgs[0].c_str(), rate, linear.snr, linear.nsPerFrame, sinc.snr, sinc.nsPerFrame);
+
+		if (testArgs.size() >= 2) {
+			WaveFileWriter writer;
+			if (!writer.Start(testArgs[1], 48000))
+				return false;
+			for (size_t i = 0; i < output.size(); i += 8192)
+				writer.AddStereoSamples(&output[i], (u32)std::min((size_t)4096, (output.size() - i) / 2));
+			writer.Stop();
+		}
+	}
+#endif
+
+	return true;
+}
+
+static std::vector<std::pair<s64, u64>> coreTimingFired;
+
+static void CoreTimingTestCallback(u64 userdata, int cyclesLate) {
+	coreTimingFired.push_back(std::make_pair((s64)CoreTiming::GetTicks() - cyclesLate, userdata));
+}
+
+// Runs the "CPU" until no events of the type are left, jumping straight to each event.
+static void CoreTimingDrain(int eventType) {
+	while (CoreTiming::IsScheduled(eventType)) {
+		currentMIPS->downcount = 0;
+		CoreTiming::Advance();
+	}
+}
+
+static bool TestCoreTiming() {
+	static const int EVENTS = 1000;
+	CoreTiming::Init();
+	int eventType = CoreTiming::RegisterEvent("TestEvent", &CoreTimingTestCallback);
+
+	// Plenty of equal times, which have to run in the order they were scheduled.
+	std::vector<s64> delays(EVENTS);
+	srand(1111);
+	for (int i = 0; i < EVENTS; ++i) {
+		delays[i] = (rand() % 500) * 100;
+		CoreTiming::ScheduleEvent(delays[i], eventType, i);
+	}
+	for (int i = 0; i < EVENTS; i += 3) {
+		EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(eventType, i), (int)delays[i]);
+	}
+	EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(eventType, EVENTS), 0);
+
+	coreTimingFired.clear();
+	CoreTimingDrain(eventType);
+	EXPECT_EQ_INT((int)coreTimingFired.size(), EVENTS - (EVENTS + 2) / 3);
+	for (size_t i = 0; i < coreTimingFired.size(); ++i) {
+		u64 userdata = coreTimingFired[i].second;
+		EXPECT_TRUE(userdata % 3 != 0);
+		EXPECT_EQ_INT((int)coreTimingFired[i].first, (int)delays[(size_t)userdata]);
+		if (i > 0) {
+			EXPECT_TRUE(coreTimingFired[i - 1].first <= coreTimingFired[i].first);
+			if (coreTimingFired[i - 1].first == coreTimingFired[i].first) {
+				EXPECT_TRUE(coreTimingFired[i - 1].second < userdata);
+			}
+		}
+	}
+
+	CoreTiming::Shutdown();
+	return true;
+}
+
+static bool BenchCoreTiming() {
+	// The speed of 1k concurrent events: schedule, cancel half, then run the rest.
+	static const int EVENTS = 1000;
+	CoreTiming::Init();
+	int eventType = CoreTiming::RegisterEvent("TestEvent", &CoreTimingTestCallback);
+
+	std::vector<s64> delays(EVENTS);
+	srand(1111);
+	for (int i = 0; i < EVENTS; ++i)
+		delays[i] = (rand() % 500) * 100;
+
+	const int ROUNDS = 200;
+	double start = time_now_d();
+	for (int round = 0; round < ROUNDS; ++round) {
+		for (int i = 0; i < EVENTS; ++i)
+			CoreTiming::ScheduleEvent(delays[(i + round) % EVENTS] + 1, eventType, i);
+		for (int i = 0; i < EVENTS; i += 2)
+			CoreTiming::UnscheduleEvent(eventType, i);
+		coreTimingFired.clear();
+		CoreTimingDrain(eventType);
+	}
+	double elapsed = time_now_d() - start;
+	printf("CoreTiming: %0.1f ns per event (schedule, cancel or run)\n", elapsed * 1e9 / (ROUNDS * (EVENTS + EVENTS / 2 + EVENTS / 2)));
+
+	CoreTiming::Shutdown();
+	return true;
+}
+
+static bool TestThreadQueueList() {
+	// Checked against plain deques, which is obviously the order the PSP uses.
+	ThreadQueueList queue;
+	std::deque<SceUID> model[ThreadQueueList::NUM_QUEUES];
+	const u32 priorities[] = { 8, 16, 17, 31, 32, 48, 63, 64, 100, 111, 127 };
+	for (u32 prio : priorities)
+		queue.prepare(prio);
+
+	auto modelFirst = [&](u32 limit) {
+		for (u32 i = 0; i < limit; ++i) {
+			if (!model[i].empty())
+				return (int)i;
+		}
+		return -1;
+	};
+
+	srand(2222);
+	SceUID nextID = 1;
+	for (int i = 0; i < 100000; ++i) {
+		u32 prio = priorities[rand() % ARRAY_SIZE(priorities)];
+		switch (rand() % 6) {
+		case 0:
+			queue.push_back(prio, nextID);
+			model[prio].push_back(nextID++);
+			break;
+		case 1:
+			queue.push_front(prio, nextID);
+			model[prio].push_front(nextID++);
+			break;
+		case 2:
+			if (!model[prio].empty()) {
+				SceUID id = model[prio][rand() % model[prio].size()];
+				queue.remove(prio, id);
+				model[prio].erase(std::find(model[prio].begin(), model[prio].end(), id));
+			}
+			break;
+		case 3:
+			queue.rotate(prio);
+			if (model[prio].size() > 1) {
+				model[prio].push_back(model[prio].front());
+				model[prio].pop_front();
+			}
+			break;
+		case 4: {
+			int best = modelFirst(prio);
+			SceUID expected = best < 0 ? 0 : model[best].front();
+			EXPECT_EQ_INT(queue.pop_first_better(prio), expected);
+			if (best >= 0)
+				model[best].pop_front();
+			break;
+		}
+		default: {
+			int best = modelFirst(ThreadQueueList::NUM_QUEUES);
+			EXPECT_EQ_INT(queue.peek_first(), best < 0 ? 0 : model[best].front());
+			if (best >= 0 && (rand() & 1)) {
+				EXPECT_EQ_INT(queue.pop_first(), model[best].front());
+				model[best].pop_front();
+			}
+			break;
+		}
+		}
+		EXPECT_EQ_INT((int)queue.empty(prio), (int)model[prio].empty());
+	}
+	return true;
+}
+
+static bool BenchThreadQueueList() {
+	// Like a busy game: lots of threads over many priorities, with most of them waiting.
+	ThreadQueueList queue;
+	for (u32 prio = 0; prio < ThreadQueueList::NUM_QUEUES; prio += 2)
+		queue.prepare(prio);
+	for (SceUID id = 1; id <= 64; ++id)
+		queue.push_back(100 + (id & 3) * 2, id);
+	const int ROUNDS = 1000000;
+	double start = time_now_d();
+	SceUID sum = 0;
+	for (int i = 0; i < ROUNDS; ++i) {
+		SceUID id = queue.pop_first();
+		sum += id;
+		queue.push_back(100 + (id & 3) * 2, id);
+	}
+	double elapsed = time_now_d() - start;
+	printf("ThreadQueueList: %0.1f ns per pick and requeue (%d)\n", elapsed * 1e9 / ROUNDS, (int)(sum & 1));
+	return true;
+}
+
+static bool TestTransformedVertexCache() {
+	const int savedFlips = gpuStats.numFlips;
+	gpuStats.numFlips = 0;
+
+	TransformedVertex verts[3]{};
+	for (int i = 0; i < 3; ++i) {
+		verts[i].x = (float)i;
+		verts[i].color0_32 = 0xFF000000 | i;
+	}
+	TransformedVertex out[3];
+
+	// The first time a draw is seen is only remembered, the second stores it.
+	TransformedVertexCache cache;
+	EXPECT_TRUE(cache.Active());
+	EXPECT_FALSE(cache.Lookup(1, 2, out, 3));
+	cache.Store(1, 2, verts, 3);
+	EXPECT_FALSE(cache.Lookup(1, 2, out, 3));
+	cache.Store(1, 2, verts, 3);
+	EXPECT_TRUE(cache.Lookup(1, 2, out, 3));
+	EXPECT_TRUE(memcmp(out, verts, sizeof(verts)) == 0);
+	EXPECT_FALSE(cache.Lookup(1, 3, out, 3));
+	EXPECT_FALSE(cache.Lookup(1, 2, out, 2));
+	EXPECT_EQ_INT(cache.Size(), 1);
+
+	// Unused entries age out.
+	gpuStats.numFlips += 200;
+	cache.Decimate();
+	EXPECT_EQ_INT(cache.Size(), 0);
+
+	// The same draws every frame keep the cache on, and hit from the third frame.
+	for (int frame = 0; frame < 20; ++frame) {
+		int hits = 0;
+		for (uint64_t i = 0; i < 100; ++i) {
+			if (cache.Lookup(i, 7, out, 3))
+				hits++;
+			else
+				cache.Store(i, 7, verts, 3);
+		}
+		EXPECT_EQ_INT(hits, frame >= 2 ? 100 : 0);
+		gpuStats.numFlips++;
+		cache.Decimate();
+		EXPECT_TRUE(cache.Active());
+	}
+
+	// Draws that never repeat turn it off for a while.
+	cache.Clear();
+	int frame = 0;
+	for (; frame < 100 && cache.Active(); ++frame) {
+		for (uint64_t i = 0; i < 100; ++i) {
+			uint64_t hash = frame * 1000 + i;
+			if (!cache.Lookup(hash, 7, out, 3))
+				cache.Store(hash, 7, verts, 3);
+		}
+		gpuStats.numFlips++;
+		cache.Decimate();
+	}
+	EXPECT_TRUE(frame < 100);
+	EXPECT_EQ_INT(cache.Size(), 0);
+	gpuStats.numFlips += 1000;
+	EXPECT_TRUE(cache.Active());
+
+	gpuStats.numFlips = savedFlips;
+	return true;
+}
+
+static bool TestDirtyTracking() {
+	if (!Memory::DirtyTracking_Supported()) {
+		printf("Write tracking not supported on this platform, skipping\n");
+		return true;
+	}
+
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	EXPECT_TRUE(Memory::Init());
+	InstallExceptionHandler(&Memory::HandleFault);
+	EXPECT_TRUE(Memory::DirtyTracking_Start());
+
+	const u32 pageSize = Memory::DirtyTracking_PageSize();
+	auto pageOf = [&](u32 address) {
+		const u8 *ptr = Memory::GetPointer(address & 0x3FFFFFFF);
+		for (u32 page = 0; page < Memory::DirtyTracking_NumPages(); ++page) {
+			const u8 *start = Memory::DirtyTracking_PagePointer(page);
+			if (ptr >= start && ptr < start + pageSize)
+				return (int)page;
+		}
+		return -1;
+	};
+
+	std::vector<u32> dirty;
+	Memory::DirtyTracking_GetDirty(&dirty);
+	EXPECT_EQ_INT((int)dirty.size(), 0);
+
+	// Through the cached, uncached and kernel mirrors, plus a "host" write into VRAM.
+	Memory::Write_U32(1, 0x08804000);
+	Memory::Write_U32(2, 0x48804000 + pageSize * 2);
+	Memory::Write_U32(3, 0x88804000 + pageSize * 2 + 4);
+	{
+		Memory::DirtyTrackingHostWrite hostWrite(Memory::GetPointer(0x04000000), pageSize + 1);
+		memset(Memory::GetPointer(0x04000000), 0xFF, pageSize + 1);
+	}
+	Memory::Write_U8(4, 0x00010000);
+
+	Memory::DirtyTracking_GetDirty(&dirty);
+	EXPECT_EQ_INT((int)dirty.size(), 5);
+	std::vector<int> expected{ pageOf(0x00010000), pageOf(0x04000000), pageOf(0x04000000 + pageSize), pageOf(0x08804000), pageOf(0x08804000 + pageSize * 2) };
+	std::sort(expected.begin(), expected.end());
+	for (size_t i = 0; i < dirty.size(); ++i)
+		EXPECT_EQ_INT((int)dirty[i], expected[i]);
+	EXPECT_EQ_INT(Memory::Read_U32(0x08804000 + pageSize * 2), 2);
+
+	Memory::DirtyTracking_Protect(dirty);
+	dirty.clear();
+	Memory::DirtyTracking_GetDirty(&dirty);
+	EXPECT_EQ_INT((int)dirty.size(), 0);
+	Memory::Write_U32(5, 0x08804010);
+	Memory::DirtyTracking_GetDirty(&dirty);
+	EXPECT_EQ_INT((int)dirty.size(), 1);
+	EXPECT_EQ_INT((int)dirty[0], pageOf(0x08804000));
+
+	// A snapshot taken during a host write must leave the page writable (and dirty.)
+	{
+		Memory::DirtyTrackingHostWrite hostWrite(Memory::GetPointer(0x08900000), 4);
+		Memory::DirtyTracking_Protect(dirty);
+		dirty.clear();
+		Memory::DirtyTracking_GetDirty(&dirty);
+		EXPECT_EQ_INT((int)dirty.size(), 1);
+		EXPECT_EQ_INT((int)dirty[0], pageOf(0x08900000));
+	}
+	Memory::DirtyTracking_Protect(dirty);
+	dirty.clear();
+	Memory::DirtyTracking_GetDirty(&dirty);
+	EXPECT_EQ_INT((int)dirty.size(), 0);
+
+	Memory::DirtyTracking_Stop();
+	UninstallExceptionHandler();
+	Memory::Shutdown();
+	return true;
+}
+
+// Something shaped roughly like a state: mostly empty RAM, some code and tables,
+// framebuffers with gradients, and a bit of noise.
+static void FillStateLike(std::vector<u8> &state) {
+	srand(4321);
+	for (size_t i = 0; i < state.size(); i += 4096) {
+		size_t n = std::min((size_t)4096, state.size() - i);
+		switch (rand() % 8) {
+		case 0: case 1: case 2:
+			break;
+		case 3: case 4:
+			for (size_t j = 0; j < n; ++j)
+				state[i + j] = (u8)((j * 7) ^ (j >> 5));
+			break;
+		case 5: case 6:
+			for (size_t j = 0; j < n; j += 2)
+				state[i + j] = (u8)(j >> 4), state[i + j + 1] = (u8)(rand() & 3);
+			break;
+		default:
+			for (size_t j = 0; j < n; ++j)
+				state[i + j] = (u8)rand();
+			break;
+		}
+	}
+}
+
+static bool TestSaveStateCompression() {
+	// A few whole chunks and a partial one.
+	std::vector<u8> state(3 * 1024 * 1024 + 1234);
+	FillStateLike(state);
+
+	std::vector<u8> roundTrip;
+	const CChunkFileReader::Compression modes[] = { CChunkFileReader::Compression::FAST, CChunkFileReader::Compression::DENSE };
+	for (auto mode : modes) {
+		std::vector<u8> compressed;
+		CChunkFileReader::CompressChunks(&state[0], state.size(), mode, &compressed);
+		EXPECT_FALSE(compressed.empty());
+		EXPECT_TRUE(CChunkFileReader::DecompressChunks(&compressed[0], compressed.size(), &roundTrip));
+		EXPECT_TRUE(roundTrip == state);
+
+		// A damaged chunk has to fail, not crash.
+		compressed[compressed.size() / 2] ^= 0x55;
+		compressed.resize(compressed.size() - 16);
+		EXPECT_FALSE(CChunkFileReader::DecompressChunks(&compressed[0], compressed.size(), &roundTrip));
+	}
+
+	// Regions are left out of the buffer, and remember where they go.
+	std::vector<PointerWrapRegion> regions;
+	u32 before = 0x12345678, after = 0x9ABCDEF0;
+	u8 *ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	p.regions = &regions;
+	auto doState = [&] {
+		Do(p, before);
+		p.DoRegion(&state[0], (int)state.size());
+		Do(p, after);
+	};
+	doState();
+	EXPECT_EQ_INT((int)(size_t)ptr, 8);
+	EXPECT_TRUE(regions.empty());
+
+	u8 buffer[8];
+	ptr = buffer;
+	p.SetMode(PointerWrap::MODE_WRITE);
+	doState();
+	EXPECT_EQ_INT((int)regions.size(), 1);
+	EXPECT_TRUE(regions[0].at == buffer + 4 && regions[0].data == &state[0] && regions[0].size == state.size());
+	return true;
+}
+
+static void FillReplayKeyframeState(std::vector<u8> &state, int frame) {
+	state.resize(64 * 1024 + frame);
+	for (size_t i = 0; i < state.size(); ++i)
+		state[i] = (u8)((i >> 6) + frame);
+}
+
+static bool TestReplayKeyframes() {
+	static const int KEYFRAMES = 20;
+	CoreTiming::Init();
+
+	ReplayBeginSave();
+	for (int i = 0; i < KEYFRAMES; ++i) {
+		std::vector<u8> state;
+		FillReplayKeyframeState(state, i * 100);
+		ReplaySaveKeyframe(i * 100, std::move(state));
+	}
+	std::vector<u8> blob;
+	ReplayFlushBlob(&blob);
+	ReplayExecuteBlob(blob);
+
+	// The 17th keyframe thins the first 16 down to every other one, the newest ones stay.
+	static const int expectedFrames[] = { 0, 200, 400, 600, 800, 1000, 1200, 1400, 1600, 1700, 1800, 1900 };
+	EXPECT_EQ_INT(ReplayKeyframeCount(), (int)ARRAY_SIZE(expectedFrames));
+	for (int i = 0; i < ReplayKeyframeCount(); ++i) {
+		int frame = -1;
+		std::vector<u8> state, expected;
+		EXPECT_TRUE(ReplayGetKeyframe(i, &frame, &state));
+		EXPECT_EQ_INT(frame, expectedFrames[i]);
+		FillReplayKeyframeState(expected, frame);
+		EXPECT_TRUE(state == expected);
+	}
+	EXPECT_TRUE(ReplayHasMoreEvents());
+
+	ReplayAbort();
+	CoreTiming::Shutdown();
+	return true;
+}
+
+// Straightforward reference for what IndexGenerator should output, one triangle at a time.
+template <class T>
+static std::vector<u16> ReferenceIndices(int prim, int n, const T *inds, int offset, bool clockwise) {
+	std::vector<u16> out;
+	auto add = [&](int i) { out.push_back((u16)(offset + inds[i])); };
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < n; ++i)
+			add(i);
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i < (n & ~1); ++i)
+			add(i);
+		break;
+	case GE_PRIM_TRIANGLES:
+		for (int i = 0; i + 2 < n; i += 3) {
+			add(i);
+			add(clockwise ? i + 1 : i + 2);
+			add(clockwise ? i + 2 : i + 1);
+		}
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+		for (int i = 0; i + 2 < n; ++i) {
+			bool forward = ((i & 1) == 0) == clockwise;
+			add(i);
+			add(forward ? i + 1 : i + 2);
+			add(forward ? i + 2 : i + 1);
+		}
+		break;
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i + 2 < n; ++i) {
+			add(0);
+			add(clockwise ? i + 1 : i + 2);
+			add(clockwise ? i + 2 : i + 1);
+		}
+		break;
+	}
+	return out;
+}
+
+template <class T>
+static bool CheckTranslatedIndices(const char *type, int prim, int n, int base, int indexOffset, bool clockwise) {
+	std::vector<T> inds(n);
+	for (int i = 0; i < n; ++i)
+		inds[i] = (T)((i * 37 + (i >> 3)) & 0xFF);
+	// The generator may write a little past the end, like it does into the real index buffer.
+	std::vector<u16> buffer(n * 3 + 64, 0xCDCD);
+	IndexGenerator gen;
+	gen.Setup(&buffer[0]);
+	gen.SetIndex(base);
+	gen.TranslatePrim(prim, n, n ? &inds[0] : nullptr, indexOffset, clockwise);
+
+	std::vector<u16> expected = ReferenceIndices(prim, n, n ? &inds[0] : nullptr, base - indexOffset, clockwise);
+	if (gen.VertexCount() != (int)expected.size()) {
+		printf("%s prim %d n=%d: count %d, expected %d\n", type, prim, n, gen.VertexCount(), (int)expected.size());
+		return false;
+	}
+	for (size_t i = 0; i < expected.size(); ++i) {
+		if (buffer[i] != expected[i]) {
+			printf("%s prim %d n=%d %s: index %d is %d, expected %d\n", type, prim, n, clockwise ? "cw" : "ccw", (int)i, buffer[i], expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool ValidIndexCount(int prim, int n) {
+	if (prim == GE_PRIM_TRIANGLES)
+		return n % 3 == 0;
+	if (prim == GE_PRIM_TRIANGLE_STRIP || prim == GE_PRIM_TRIANGLE_FAN)
+		return n >= 3;
+	return true;
+}
+
+static bool TestIndexGenerator() {
+	const int prims[] = { GE_PRIM_POINTS, GE_PRIM_LINES, GE_PRIM_TRIANGLES, GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN, GE_PRIM_RECTANGLES };
+	const int counts[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 16, 17, 23, 24, 25, 26, 33, 100, 1001 };
+	for (int prim : prims) {
+		for (int n : counts) {
+			// Callers never send partial triangle lists or strips and fans without a triangle.
+			if (!ValidIndexCount(prim, n))
+				continue;
+			for (int cw = 0; cw < 2; ++cw) {
+				// Zero offset for the memcpy path, then one that wraps past 0xFFFF.
+				EXPECT_TRUE(CheckTranslatedIndices<u8>("u8", prim, n, 0, 0, cw != 0));
+				EXPECT_TRUE(CheckTranslatedIndices<u8>("u8", prim, n, 0xFFF0, 3, cw != 0));
+				EXPECT_TRUE(CheckTranslatedIndices<u16_le>("u16", prim, n, 0, 0, cw != 0));
+				EXPECT_TRUE(CheckTranslatedIndices<u16_le>("u16", prim, n, 0xFFF0, 3, cw != 0));
+				EXPECT_TRUE(CheckTranslatedIndices<u32_le>("u32", prim, n, 0xFFF0, 3, cw != 0));
+			}
+		}
+	}
+
+	// Non-indexed triangles are just translations of 0, 1, 2...
+	const int trianglePrims[] = { GE_PRIM_TRIANGLES, GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN };
+	for (int prim : trianglePrims) {
+		for (int n : counts) {
+			if (!ValidIndexCount(prim, n))
+				continue;
+			for (int cw = 0; cw < 2; ++cw) {
+				std::vector<u16> buffer(n * 3 + 64);
+				IndexGenerator gen;
+				gen.Setup(&buffer[0]);
+				gen.SetIndex(100);
+				gen.AddPrim(prim, n, cw != 0);
+				std::vector<int> seq(n);
+				for (int i = 0; i < n; ++i)
+					seq[i] = i;
+				std::vector<u16> expected = ReferenceIndices(prim, n, n ? &seq[0] : nullptr, 100, cw != 0);
+				EXPECT_EQ_INT(gen.VertexCount(), (int)expected.size());
+				for (size_t i = 0; i < expected.size(); ++i)
+					EXPECT_EQ_INT((int)buffer[i], (int)expected[i]);
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool BenchSaveStateCompression() {
+	std::vector<u8> state(40 * 1024 * 1024 + 1234);
+	FillStateLike(state);
+
+	double start = time_now_d();
+	size_t snappyLen = snappy_max_compressed_length(state.size());
+	std::vector<u8> snappyOut(snappyLen);
+	snappy_compress((const char *)&state[0], state.size(), (char *)&snappyOut[0], &snappyLen);
+	double snappyTime = time_now_d() - start;
+	start = time_now_d();
+	std::vector<u8> roundTrip(state.size());
+	size_t roundTripLen = roundTrip.size();
+	snappy_uncompress((const char *)&snappyOut[0], snappyLen, (char *)&roundTrip[0], &roundTripLen);
+	double snappyLoadTime = time_now_d() - start;
+	printf("snappy: %d -> %d bytes, save %0.1f ms, load %0.1f ms\n", (int)state.size(), (int)snappyLen, snappyTime * 1000.0, snappyLoadTime * 1000.0);
+
+	const CChunkFileReader::Compression modes[] = { CChunkFileReader::Compression::FAST, CChunkFileReader::Compression::DENSE };
+	const char *names[] = { "fast", "dense" };
+	for (int m = 0; m < 2; ++m) {
+		std::vector<u8> compressed;
+		start = time_now_d();
+		CChunkFileReader::CompressChunks(&state[0], state.size(), modes[m], &compressed);
+		double saveTime = time_now_d() - start;
+		EXPECT_FALSE(compressed.empty());
+
+		start = time_now_d();
+		EXPECT_TRUE(CChunkFileReader::DecompressChunks(&compressed[0], compressed.size(), &roundTrip));
+		double loadTime = time_now_d() - start;
+		EXPECT_TRUE(roundTrip == state);
+		printf("chunked %s: %d -> %d bytes, save %0.1f ms, load %0.1f ms\n", names[m], (int)state.size(), (int)compressed.size(), saveTime * 1000.0, loadTime * 1000.0);
+	}
+	return true;
+}
+
+// Rough throughput numbers, for comparing SIMD against scalar builds.
+static bool BenchIndexGenerator() {
+	const int benchInds = 30000;
+	std::vector<u16_le> inds(benchInds);
+	for (int i = 0; i < benchInds; ++i)
+		inds[i] = (u16)(i * 7);
+	std::vector<u16> buffer(benchInds * 3 + 64);
+	const char *names[] = { "list", "strip", "fan" };
+	const int benchPrims[] = { GE_PRIM_TRIANGLES, GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN };
+	for (int p = 0; p < 3; ++p) {
+		IndexGenerator gen;
+		gen.Setup(&buffer[0]);
+		int iterations = 0;
+		double start = time_now_d();
+		double elapsed;
+		do {
+			for (int i = 0; i < 20; ++i) {
+				gen.Reset();
+				gen.SetIndex(1);
+				gen.TranslatePrim(benchPrims[p], benchInds, &inds[0], 0, true);
+			}
+			iterations += 20;
+			elapsed = time_now_d() - start;
+		} while (elapsed < 0.25);
+		printf("IndexGenerator u16 %s: %0.1f Minds/sec\n", names[p], (double)iterations * benchInds / elapsed / 1000000.0);
+	}
+	return true;
+}
+
 typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
@@ -567,6 +1484,7 @@ struct TestItem {
 };
 
 #define TEST_ITEM(name) { #name, &Test ##name, }
+#define BENCH_ITEM(name) { #name "Bench", &Bench ##name, }
 
 bool TestArmEmitter();
 bool TestArm64Emitter();
@@ -584,6 +1502,7 @@ TestItem availableTests[] = {
 	TEST_ITEM(X64Emitter),
 #endif
 	TEST_ITEM(VertexJit),
+	TEST_ITEM(IndexGenerator),
 	TEST_ITEM(Asin),
 	TEST_ITEM(SinCos),
 	TEST_ITEM(VFPUSinCos),
@@ -594,9 +1513,28 @@ TestItem availableTests[] = {
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
 	TEST_ITEM(CLZ),
+	TEST_ITEM(Replacements),
+	TEST_ITEM(SasMix),
+	TEST_ITEM(Resampler),
+	TEST_ITEM(CoreTiming),
+	TEST_ITEM(ThreadQueueList),
+	TEST_ITEM(TransformedVertexCache),
+	TEST_ITEM(DirtyTracking),
+	TEST_ITEM(SaveStateCompression),
+	TEST_ITEM(ReplayKeyframes),
 	TEST_ITEM(ShaderGenerators),
 };
 
+// Benchmarks aren't part of "all", run them by name.
+TestItem availableBenchmarks[] = {
+	BENCH_ITEM(VertexJit),
+	BENCH_ITEM(IndexGenerator),
+	BENCH_ITEM(SaveStateCompression),
+	BENCH_ITEM(ThreadQueueList),
+	BENCH_ITEM(CoreTiming),
+	BENCH_ITEM(Resampler),
+};
+
 int main(int argc, const char *argv[]) {
 	cpu_info.bNEON = true;
 	cpu_info.bVFP = true;
@@ -610,12 +1548,21 @@ int main(int argc, const char *argv[]) {
 		if (!strcasecmp(argv[1], "all")) {
 			allTests = true;
 		}
+		for (int i = 2; i < argc; ++i) {
+			testArgs.push_back(argv[i]);
+		}
 		for (auto f : availableTests) {
 			if (!strcasecmp(argv[1], f.name)) {
 				testFunc = f.func;
 				break;
 			}
 		}
+		for (auto f : availableBenchmarks) {
+			if (!strcasecmp(argv[1], f.name)) {
+				testFunc = f.func;
+				break;
+			}
+		}
 	}
 
 	if (allTests) {
@@ -642,6 +1589,11 @@ int main(int argc, const char *argv[]) {
 		for (auto f : availableTests) {
 			fprintf(stderr, "  * %s\n", f.name);
 		}
+		fprintf(stderr, "\n");
+		fprintf(stderr, "Benchmarks (not run by \"all\"):\n");
+		for (auto f : availableBenchmarks) {
+			fprintf(stderr, "  * %s\n", f.name);
+		}
 		return 1;
 	} else {
 		if (!testFunc()) {